@@ -0,0 +1,319 @@
+// This program benchmarks the Gaussian Elimination versions over a sweep
+// of matrix sizes and thread/rank counts, and writes the results as CSV
+// and JSON
+//
+// Each version is a compiled program that accepts "-n -t -w -r" and
+// prints a "BENCH,parallel,..." line (see common/bench.h). The serial
+// baseline is timed here with ge_serial
+// Versions that solve many small systems per run (pthreads/batched and
+// pthreads/fixed_size) print a "THROUGHPUT,parallel,..." line instead,
+// and are reported in systems per second (with no efficiency, since one
+// N x N serial elimination is not their baseline)
+// Versions that skip structural zeros (pthreads/banded and
+// pthreads/sparse) also print a "FLOPS,parallel,..." line, so their
+// GFLOP/s come from the operations they actually do, and they get no
+// efficiency either
+//
+// Usage:
+//   benchmark -n 512,1024,2048 -t 1,2,4,8 -w 1 -r 5 -o results
+//       -b block=../pthreads/naive/gaussian
+//       -b cyclic=../pthreads/cyclic_striped_mapping/gaussian
+//       -m mpi_block=../mpi/naive/gaussian
+//       -l "mpirun --oversubscribe"
+// where -b adds a pthread version (run with -t threads), -m adds an MPI
+// version (run with the launcher and -np ranks), and -o is the prefix of
+// the .csv and .json files
+// Extra options can follow the path of a version, so the same program
+// can be compared against itself with padded and unpadded rows:
+//   -b padded=../pthreads/naive/gaussian
+//   -b dense="../pthreads/naive/gaussian -l dense"
+// or with barriers around every pivot instead of the lookahead pipeline:
+//   -b barrier="../pthreads/naive/gaussian -e barrier"
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include "../common/common.h"
+#include "../common/bench.h"
+
+using namespace std::chrono;
+
+// A compiled version of Gaussian Elimination
+struct Version {
+    string name;
+    string path;
+    // Launched with the MPI launcher instead of -t threads
+    bool mpi;
+};
+
+// Timings of one version at one size and thread/rank count
+struct Result {
+    string name;
+    int N;
+    int workers;
+    vector<double> times;
+    // Systems solved per run (0 if a run is one N x N elimination)
+    int count;
+    // Operations per run of a version with a band or a sparse pattern
+    // (0 if a run is a dense elimination)
+    double flops;
+};
+
+// Splits a comma separated list of integers
+// Takes the list as an argument
+vector<int> parse_list(const char *list){
+    vector<int> values;
+    stringstream ss(list);
+    string item;
+    while(getline(ss, item, ',')){
+        values.push_back(atoi(item.c_str()));
+    }
+    return values;
+}
+
+// Splits a "name=path" argument into a version
+// Takes the argument and whether the version uses MPI as arguments
+Version parse_version(const char *arg, bool mpi){
+    string s(arg);
+    size_t eq = s.find('=');
+    if(eq == string::npos){
+        return {s, s, mpi};
+    }
+    return {s.substr(0, eq), s.substr(eq + 1), mpi};
+}
+
+// Runs one version and reads back its timings
+// Takes the version, the MPI launcher, the size, the number of threads
+// or ranks, the number of warmup and timed runs, and where to store the
+// systems per run (0 for a BENCH line) and the operations per run (0
+// without a FLOPS line) as arguments
+// Returns no timings if the program failed
+vector<double> run_version(const Version &v, const string &launcher, int N,
+        int workers, int warmup, int reps, int *count, double *flops){
+    // Build the command line
+    stringstream cmd;
+    if(v.mpi){
+        cmd << launcher << " -np " << workers << " " << v.path;
+    }else{
+        cmd << v.path << " -t " << workers;
+    }
+    cmd << " -n " << N << " -w " << warmup << " -r " << reps;
+
+    // Look for the BENCH or THROUGHPUT line of the parallel version
+    vector<double> times;
+    *count = 0;
+    *flops = 0;
+    FILE *pipe = popen(cmd.str().c_str(), "r");
+    if(pipe == NULL){
+        return times;
+    }
+    char line[4096];
+    while(fgets(line, sizeof(line), pipe) != NULL){
+        if(strncmp(line, "FLOPS,parallel,", 15) == 0){
+            *flops = atof(&line[15]);
+            continue;
+        }
+        bool throughput = (strncmp(line, "THROUGHPUT,parallel,", 20) == 0);
+        if(!throughput && (strncmp(line, "BENCH,parallel,", 15) != 0)){
+            continue;
+        }
+
+        // Skip the version, N, and workers fields (and the number of
+        // systems of a THROUGHPUT line)
+        int first = throughput ? 5 : 4;
+        stringstream ss(line);
+        string field;
+        for(int i = 0; getline(ss, field, ','); i++){
+            if(throughput && (i == 4)){
+                *count = atoi(field.c_str());
+            }
+            if(i >= first){
+                times.push_back(atof(field.c_str()));
+            }
+        }
+    }
+    if(pclose(pipe) != 0){
+        cerr << "Failed: " << cmd.str() << endl;
+        times.clear();
+    }
+    return times;
+}
+
+// Times ge_serial on the same matrix the versions use
+// Takes the size and the number of warmup and timed runs as arguments
+vector<double> time_serial(int N, int warmup, int reps){
+    float *matrix = new float[(size_t)N * N];
+    float *work = new float[(size_t)N * N];
+    int *perm = new int[N];
+    init_matrix(matrix, N);
+
+    vector<double> times;
+    for(int r = 0; r < warmup + reps; r++){
+        memcpy(work, matrix, (size_t)N * N * sizeof(float));
+        high_resolution_clock::time_point start = high_resolution_clock::now();
+        ge_serial(work, N, perm);
+        high_resolution_clock::time_point end = high_resolution_clock::now();
+        duration<double> elapsed = duration_cast<duration<double>>(end - start);
+        if(r >= warmup){
+            times.push_back(elapsed.count());
+        }
+    }
+
+    delete[] matrix;
+    delete[] work;
+    delete[] perm;
+    return times;
+}
+
+// Finds the median serial time for a size
+// Takes the results and the size as arguments
+double serial_median(const vector<Result> &results, int N){
+    for(size_t i = 0; i < results.size(); i++){
+        if((results[i].name == "serial") && (results[i].N == N)){
+            return bench_stats(results[i].times).median;
+        }
+    }
+    return 0;
+}
+
+// Floating point rate of a result (every system of a throughput run,
+// or the operations a banded or sparse version reported)
+// Takes the result and its median time as arguments
+double result_gflops(const Result &r, double median){
+    if(r.flops){
+        return r.flops / median / 1e9;
+    }
+    return ge_gflops(r.N, median) * (r.count ? r.count : 1);
+}
+
+// Writes one row per result: median, p95, GFLOP/s, and parallel
+// efficiency against the serial time at the same size (dense versions
+// only), or systems per second for throughput runs
+// Takes the file name and the results as arguments
+void write_csv(const string &path, const vector<Result> &results){
+    ofstream out(path.c_str());
+    out << "version,N,workers,reps,median_s,p95_s,gflops,efficiency,"
+        << "systems_per_s\n";
+    for(size_t i = 0; i < results.size(); i++){
+        const Result &r = results[i];
+        BenchStats stats = bench_stats(r.times);
+        double serial = serial_median(results, r.N);
+        out << r.name << "," << r.N << "," << r.workers << ","
+            << r.times.size() << "," << stats.median << "," << stats.p95
+            << "," << result_gflops(r, stats.median) << ",";
+        if(r.count){
+            out << "," << r.count / stats.median << "\n";
+        }else if(r.flops){
+            out << ",\n";
+        }else{
+            out << serial / (r.workers * stats.median) << ",\n";
+        }
+    }
+}
+
+// Writes the same rows as write_csv, plus every timing, as JSON
+// Takes the file name and the results as arguments
+void write_json(const string &path, const vector<Result> &results){
+    ofstream out(path.c_str());
+    out << "[\n";
+    for(size_t i = 0; i < results.size(); i++){
+        const Result &r = results[i];
+        BenchStats stats = bench_stats(r.times);
+        double serial = serial_median(results, r.N);
+        out << "  {\"version\": \"" << r.name << "\", \"N\": " << r.N
+            << ", \"workers\": " << r.workers << ", \"median_s\": "
+            << stats.median << ", \"p95_s\": " << stats.p95
+            << ", \"gflops\": " << result_gflops(r, stats.median);
+        if(r.count){
+            out << ", \"systems\": " << r.count << ", \"systems_per_s\": "
+                << r.count / stats.median;
+        }else if(!r.flops){
+            out << ", \"efficiency\": "
+                << serial / (r.workers * stats.median);
+        }
+        out << ", \"times_s\": [";
+        for(size_t t = 0; t < r.times.size(); t++){
+            out << (t ? ", " : "") << r.times[t];
+        }
+        out << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+int main(int argc, char *argv[]){
+    // Defaults for the sweep
+    vector<int> sizes = {512, 1024, 2048};
+    vector<int> workers = {1, 2, 4, 8};
+    int warmup = 1;
+    int reps = 5;
+    string prefix = "results";
+    string launcher = "mpirun";
+    vector<Version> versions;
+
+    // Read the command line
+    for(int i = 1; i + 1 < argc; i += 2){
+        if(strcmp(argv[i], "-n") == 0){
+            sizes = parse_list(argv[i + 1]);
+        }else if(strcmp(argv[i], "-t") == 0){
+            workers = parse_list(argv[i + 1]);
+        }else if(strcmp(argv[i], "-w") == 0){
+            warmup = atoi(argv[i + 1]);
+        }else if(strcmp(argv[i], "-r") == 0){
+            reps = atoi(argv[i + 1]);
+        }else if(strcmp(argv[i], "-o") == 0){
+            prefix = argv[i + 1];
+        }else if(strcmp(argv[i], "-l") == 0){
+            launcher = argv[i + 1];
+        }else if(strcmp(argv[i], "-b") == 0){
+            versions.push_back(parse_version(argv[i + 1], false));
+        }else if(strcmp(argv[i], "-m") == 0){
+            versions.push_back(parse_version(argv[i + 1], true));
+        }else{
+            cerr << "Unknown option " << argv[i] << endl;
+            return 1;
+        }
+    }
+
+    // Sweep every size, then every version and thread/rank count
+    vector<Result> results;
+    for(size_t s = 0; s < sizes.size(); s++){
+        int N = sizes[s];
+        results.push_back({"serial", N, 1, time_serial(N, warmup, reps),
+                0, 0});
+        cout << "serial N=" << N << " median "
+            << bench_stats(results.back().times).median << " s" << endl;
+
+        for(size_t v = 0; v < versions.size(); v++){
+            for(size_t w = 0; w < workers.size(); w++){
+                Result r;
+                r.name = versions[v].name;
+                r.N = N;
+                r.workers = workers[w];
+                r.times = run_version(versions[v], launcher, N, workers[w],
+                        warmup, reps, &r.count, &r.flops);
+                if(r.times.empty()){
+                    continue;
+                }
+                double median = bench_stats(r.times).median;
+                cout << r.name << " N=" << N << " workers=" << r.workers
+                    << " median " << median << " s";
+                if(r.count){
+                    cout << " (" << r.count / median << " systems/s)";
+                }
+                cout << endl;
+                results.push_back(r);
+            }
+        }
+    }
+
+    // Write the machine-readable results
+    write_csv(prefix + ".csv", results);
+    write_json(prefix + ".json", results);
+    cout << "Wrote " << prefix << ".csv and " << prefix << ".json" << endl;
+
+    return 0;
+}
@@ -0,0 +1,267 @@
+// This file contains thread pinning and NUMA placement helpers for the
+// pthread versions of Gaussian Elimination (Linux only)
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_AFFINITY_H
+#define GE_AFFINITY_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <cstdio>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+// Flags for get_mempolicy (from numaif.h, so we do not need libnuma)
+#ifndef MPOL_F_NODE
+#define MPOL_F_NODE (1 << 0)
+#endif
+#ifndef MPOL_F_ADDR
+#define MPOL_F_ADDR (1 << 1)
+#endif
+
+// How worker threads are placed on CPUs
+enum AffinityPolicy {
+    // Let the OS place threads
+    AFFINITY_NONE,
+    // Fill one NUMA node before moving to the next
+    AFFINITY_COMPACT,
+    // Spread consecutive threads over the NUMA nodes
+    AFFINITY_SCATTER,
+    // Use an explicit list of CPUs (thread i gets cpus[i % cpus.size()])
+    AFFINITY_LIST
+};
+
+struct Affinity {
+    AffinityPolicy policy;
+    // Only used by AFFINITY_LIST
+    std::vector<int> cpus;
+};
+
+// Reads a placement from the command line: none, compact, scatter, or a
+// comma separated list of CPUs
+// Takes the option value as an argument
+Affinity affinity_parse(const char *arg){
+    Affinity affinity;
+    if(strcmp(arg, "none") == 0){
+        affinity.policy = AFFINITY_NONE;
+    }else if(strcmp(arg, "compact") == 0){
+        affinity.policy = AFFINITY_COMPACT;
+    }else if(strcmp(arg, "scatter") == 0){
+        affinity.policy = AFFINITY_SCATTER;
+    }else{
+        affinity.policy = AFFINITY_LIST;
+        const char *p = arg;
+        while(true){
+            char *next;
+            long cpu = strtol(p, &next, 10);
+            if((next == p) || (cpu < 0) || (cpu >= CPU_SETSIZE) ||
+                    ((*next != ',') && (*next != '\0'))){
+                std::cerr << "Bad affinity " << arg << " (none, compact,"
+                    << " scatter, or a list of CPUs like 0,2,4)"
+                    << std::endl;
+                exit(1);
+            }
+            affinity.cpus.push_back((int)cpu);
+            if(*next == '\0'){
+                break;
+            }
+            p = next + 1;
+        }
+
+        // A thread pinned to a CPU we may not run on would never start
+        cpu_set_t allowed;
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        for(size_t i = 0; i < affinity.cpus.size(); i++){
+            if(!CPU_ISSET(affinity.cpus[i], &allowed)){
+                std::cerr << "CPU " << affinity.cpus[i] << " of affinity "
+                    << arg << " is not available to this process"
+                    << std::endl;
+                exit(1);
+            }
+        }
+    }
+    return affinity;
+}
+
+// Finds the NUMA node of a CPU from sysfs (0 if there is no NUMA info)
+// Takes the CPU number as an argument
+int cpu_node(int cpu){
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR *dir = opendir(path);
+    if(dir == NULL){
+        return 0;
+    }
+
+    // The CPU directory has a "nodeN" link to its node
+    int node = 0;
+    struct dirent *entry;
+    while((entry = readdir(dir)) != NULL){
+        if(sscanf(entry->d_name, "node%d", &node) == 1){
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+// Finds the NUMA node a page of memory was placed on
+// Takes an address as an argument
+// Returns -1 if the page is not mapped yet or the kernel has no NUMA
+int page_node(const void *addr){
+    int node = -1;
+    if(syscall(SYS_get_mempolicy, &node, NULL, 0, addr,
+                MPOL_F_NODE | MPOL_F_ADDR) != 0){
+        return -1;
+    }
+    return node;
+}
+
+// Orders the CPUs threads are pinned to under a policy
+// This reads sysfs for every allowed CPU, so it is done once per launch
+// rather than once per thread
+// Takes the policy as an argument
+// Returns the CPUs in order (thread i gets order[i % size]), or an empty
+// list if threads should not be pinned
+std::vector<int> affinity_order(const Affinity *affinity){
+    std::vector<int> order;
+    if((affinity == NULL) || (affinity->policy == AFFINITY_NONE)){
+        return order;
+    }
+    if(affinity->policy == AFFINITY_LIST){
+        return affinity->cpus;
+    }
+
+    // CPUs this process is allowed to run on, ordered by node
+    cpu_set_t allowed;
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    std::vector<std::pair<int, int> > cpus;
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+        if(CPU_ISSET(cpu, &allowed)){
+            cpus.push_back(std::make_pair(cpu_node(cpu), cpu));
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+
+    if(affinity->policy == AFFINITY_SCATTER){
+        // Deal the CPUs of each node out one at a time, round robin
+        std::vector<std::vector<int> > by_node;
+        for(size_t i = 0; i < cpus.size(); i++){
+            if((i == 0) || (cpus[i].first != cpus[i - 1].first)){
+                by_node.push_back(std::vector<int>());
+            }
+            by_node.back().push_back(cpus[i].second);
+        }
+        for(size_t round = 0; order.size() < cpus.size(); round++){
+            for(size_t n = 0; n < by_node.size(); n++){
+                if(round < by_node[n].size()){
+                    order.push_back(by_node[n][round]);
+                }
+            }
+        }
+        return order;
+    }
+
+    // Compact: consecutive threads on consecutive CPUs of the same node
+    for(size_t i = 0; i < cpus.size(); i++){
+        order.push_back(cpus[i].second);
+    }
+    return order;
+}
+
+// Picks the CPU for a thread
+// Takes the order from affinity_order and the thread ID as arguments
+// Returns -1 if the thread should not be pinned
+int affinity_cpu(const std::vector<int> &order, int tid){
+    if(order.empty()){
+        return -1;
+    }
+    return order[tid % order.size()];
+}
+
+// Creates thread attributes that pin a thread to a CPU before it runs
+// Takes the attributes to initialize and the CPU (-1 to not pin) as
+// arguments
+void affinity_attr(pthread_attr_t *attr, int cpu){
+    pthread_attr_init(attr);
+    if(cpu >= 0){
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+    }
+}
+
+// Starts a thread, pinned to a CPU before it runs
+// The threads of every version wait for each other, so one that can not
+// be started would leave the rest waiting forever, and the program ends
+// instead
+// Takes the thread, the thread function, its argument, and the CPU (-1
+// to not pin) as arguments
+void start_thread(pthread_t *thread, void *(*func)(void *), void *arg,
+        int cpu = -1){
+    pthread_attr_t attr;
+    affinity_attr(&attr, cpu);
+    int error = pthread_create(thread, &attr, func, arg);
+    pthread_attr_destroy(&attr);
+    if(error != 0){
+        std::cerr << "Could not start a thread: " << strerror(error)
+            << std::endl;
+        exit(1);
+    }
+}
+
+// Where one thread and its rows ended up
+struct Placement {
+    // CPU the thread ran on, and its node
+    int cpu;
+    int node;
+    // Number of rows whose first element is on each node
+    // (index 0 counts rows that could not be queried)
+    std::vector<int> rows_per_node;
+};
+
+// Records where the calling thread runs and where its rows live
+// Takes the placement to fill, the rows of this thread, and the number
+// of rows as arguments
+void record_placement(Placement *placement, float **rows, int num_rows){
+    placement->cpu = sched_getcpu();
+    placement->node = cpu_node(placement->cpu);
+    placement->rows_per_node.clear();
+    for(int r = 0; r < num_rows; r++){
+        int node = page_node(rows[r]) + 1;
+        if(node >= (int)placement->rows_per_node.size()){
+            placement->rows_per_node.resize(node + 1, 0);
+        }
+        placement->rows_per_node[node]++;
+    }
+}
+
+// Prints where each thread and its rows ended up
+// Takes the placements and the number of threads as arguments
+void print_placement(const Placement *placements, int num_threads){
+    for(int t = 0; t < num_threads; t++){
+        std::cout << "Thread " << t << ": cpu " << placements[t].cpu
+            << " (node " << placements[t].node << "), rows on node";
+        const std::vector<int> &counts = placements[t].rows_per_node;
+        for(size_t n = 0; n < counts.size(); n++){
+            if(counts[n] == 0){
+                continue;
+            }
+            if(n == 0){
+                std::cout << " ?: " << counts[n];
+            }else{
+                std::cout << " " << n - 1 << ": " << counts[n];
+            }
+        }
+        std::cout << std::endl;
+    }
+}
+
+#endif
@@ -0,0 +1,165 @@
+// This file contains a fill-reducing ordering for sparse elimination:
+// approximate minimum degree (Amestoy, Davis, and Duff) on the pattern
+// of A + A^T. Eliminated variables are kept as elements of a quotient
+// graph, so the graph never grows with the fill
+// This version has no supervariables or dense row handling, it only
+// keeps the approximate degrees and element absorption
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_AMD_H
+#define GE_AMD_H
+
+#include <vector>
+#include <set>
+#include <utility>
+#include <algorithm>
+
+// Orders the rows and columns of a sparse matrix
+// Takes the dimension, the row starts and column indices of the pattern
+// (CSR), and the order to fill in (perm[k] is the kth variable to
+// eliminate) as arguments
+void ge_amd(int n, const int *ptr, const int *idx, int *perm){
+    // Variables adjacent in A + A^T (without the diagonal)
+    std::vector<std::vector<int> > adj(n);
+    for(int i = 0; i < n; i++){
+        for(int e = ptr[i]; e < ptr[i + 1]; e++){
+            if(idx[e] != i){
+                adj[i].push_back(idx[e]);
+                adj[idx[e]].push_back(i);
+            }
+        }
+    }
+    for(int i = 0; i < n; i++){
+        std::sort(adj[i].begin(), adj[i].end());
+        adj[i].erase(std::unique(adj[i].begin(), adj[i].end()),
+                adj[i].end());
+    }
+
+    // Elements adjacent to each variable, and the variables of each
+    // element (element e is the eliminated variable e)
+    std::vector<std::vector<int> > elements(n);
+    std::vector<std::vector<int> > members(n);
+    std::vector<char> eliminated(n, 0);
+    std::vector<char> absorbed(n, 0);
+
+    // Variables by approximate degree
+    std::vector<int> degree(n);
+    std::set<std::pair<int, int> > queue;
+    for(int i = 0; i < n; i++){
+        degree[i] = (int)adj[i].size();
+        queue.insert({degree[i], i});
+    }
+
+    // Marks for building each new element, and |Le \ Lp| of the elements
+    // next to it
+    std::vector<int> mark(n, -1);
+    std::vector<int> w(n, 0);
+    std::vector<int> w_mark(n, -1);
+
+    for(int k = 0; k < n; k++){
+        // Eliminate a variable of least degree
+        int p = queue.begin()->second;
+        queue.erase(queue.begin());
+        eliminated[p] = 1;
+        perm[k] = p;
+
+        // New element: the variables of the elements of p and the
+        // variables next to p. The old elements are absorbed into it
+        std::vector<int> &lp = members[p];
+        mark[p] = k;
+        for(size_t t = 0; t < elements[p].size(); t++){
+            int e = elements[p][t];
+            if(absorbed[e]){
+                continue;
+            }
+            for(size_t s = 0; s < members[e].size(); s++){
+                int v = members[e][s];
+                if(mark[v] != k){
+                    mark[v] = k;
+                    lp.push_back(v);
+                }
+            }
+            absorbed[e] = 1;
+            std::vector<int>().swap(members[e]);
+        }
+        for(size_t t = 0; t < adj[p].size(); t++){
+            int v = adj[p][t];
+            if(!eliminated[v] && (mark[v] != k)){
+                mark[v] = k;
+                lp.push_back(v);
+            }
+        }
+        std::vector<int>().swap(adj[p]);
+        std::vector<int>().swap(elements[p]);
+
+        // Drop absorbed elements and covered variables from the
+        // variables of the new element, and link them to it
+        for(size_t t = 0; t < lp.size(); t++){
+            int i = lp[t];
+            std::vector<int> &ei = elements[i];
+            ei.erase(std::remove_if(ei.begin(), ei.end(),
+                        [&](int e){ return absorbed[e] != 0; }),
+                    ei.end());
+            ei.push_back(p);
+            std::vector<int> &ai = adj[i];
+            ai.erase(std::remove_if(ai.begin(), ai.end(),
+                        [&](int v){
+                            return eliminated[v] || (mark[v] == k);
+                        }),
+                    ai.end());
+        }
+
+        // |Le \ Lp| for every other element next to the new one
+        for(size_t t = 0; t < lp.size(); t++){
+            std::vector<int> &ei = elements[lp[t]];
+            for(size_t s = 0; s + 1 < ei.size(); s++){
+                int e = ei[s];
+                if(absorbed[e]){
+                    continue;
+                }
+                if(w_mark[e] != k){
+                    w_mark[e] = k;
+                    w[e] = (int)members[e].size();
+                }
+                w[e]--;
+            }
+        }
+
+        // Approximate degrees of the variables of the new element
+        // (elements inside the new one are absorbed on the way)
+        int lp_size = (int)lp.size();
+        for(size_t t = 0; t < lp.size(); t++){
+            int i = lp[t];
+            std::vector<int> &ei = elements[i];
+            long d = (long)adj[i].size() + lp_size - 1;
+            for(size_t s = 0; s + 1 < ei.size(); s++){
+                int e = ei[s];
+                if(absorbed[e]){
+                    continue;
+                }
+                if(w[e] == 0){
+                    absorbed[e] = 1;
+                }else{
+                    d += w[e];
+                }
+            }
+            d = std::min(d, (long)degree[i] + lp_size - 1);
+            d = std::min(d, (long)(n - k - 2));
+            queue.erase({degree[i], i});
+            degree[i] = (int)std::max(d, 0L);
+            queue.insert({degree[i], i});
+        }
+
+        // Elements absorbed above lose their variable lists
+        for(size_t t = 0; t < lp.size(); t++){
+            std::vector<int> &ei = elements[lp[t]];
+            for(size_t s = 0; s + 1 < ei.size(); s++){
+                if(absorbed[ei[s]]){
+                    std::vector<int>().swap(members[ei[s]]);
+                }
+            }
+        }
+    }
+}
+
+#endif
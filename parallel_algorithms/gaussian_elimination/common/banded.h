@@ -0,0 +1,363 @@
+// This file contains storage and elimination for banded matrices. Only
+// the diagonals inside the band are stored, and elimination only touches
+// the band, so factoring costs O(N b^2) work in O(N b) memory
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_BANDED_H
+#define GE_BANDED_H
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include "kernels.h"
+#include "random.h"
+#include "verify.h"
+
+// n x n matrix with kl diagonals below the main one and ku above it
+// Row i holds columns [i - kl, i + kl + ku]. Row swaps can move up to kl
+// extra columns of fill into the upper part, so the row is kl longer
+// than the band of the original matrix
+// After factoring, row i holds row i of U right of the diagonal (U has
+// a unit diagonal), the pivot on the diagonal, and the multipliers of
+// step k in rows (k, k + kl] of column k. Rows are swapped in place
+// (only from the current column on), so L is kept as the sequence of
+// swaps and eliminations rather than as P A = L U
+struct GeBanded {
+    int n;
+    int kl;
+    int ku;
+    // Elements per row (2 kl + ku + 1)
+    int ld;
+    float *data;
+    // Row swapped with row k at step k
+    int *piv;
+};
+
+// Operations of factoring a banded matrix (each of the n pivots updates
+// kl rows over kl + ku columns, counting the fill from row swaps)
+// Takes the dimension and the number of diagonals below and above the
+// main diagonal as arguments
+double ge_banded_flops(int n, int kl, int ku){
+    return 2.0 * n * kl * (double)(kl + ku);
+}
+
+// Allocates a banded matrix of zeros
+// Takes the matrix, the dimension, and the number of diagonals below
+// and above the main diagonal as arguments
+void ge_banded_init(GeBanded *a, int n, int kl, int ku){
+    a->n = n;
+    a->kl = kl;
+    a->ku = ku;
+    a->ld = 2 * kl + ku + 1;
+    a->data = new float[(size_t)n * a->ld]();
+    a->piv = new int[n];
+}
+
+// Frees a banded matrix
+void ge_banded_destroy(GeBanded *a){
+    delete[] a->data;
+    delete[] a->piv;
+}
+
+// Copies the elements of one banded matrix into another of the same
+// shape
+// Takes the destination and source as arguments
+void ge_banded_copy(GeBanded *dst, const GeBanded *src){
+    memcpy(dst->data, src->data, (size_t)src->n * src->ld * sizeof(float));
+}
+
+// Row i of a banded matrix, indexed by column (only columns
+// [i - kl, i + kl + ku] may be used)
+// Takes the matrix and the row as arguments
+inline float *ge_band_row(const GeBanded *a, int i){
+    return &a->data[(size_t)i * a->ld + a->kl - i];
+}
+
+// Fills the band with the same random numbers the dense matrix of the
+// seed has there (everything outside the band is zero), then grows each
+// diagonal element by the magnitude of the rest of its row
+// Narrow random bands (5 below and 9 above, say) give solutions that
+// grow exponentially and overflow float within a few thousand rows, so
+// the rows are kept diagonally dominant instead
+// Takes the matrix and the seed as arguments
+void ge_random_banded(GeBanded *a, uint32_t seed){
+    for(int i = 0; i < a->n; i++){
+        float *row = ge_band_row(a, i);
+        int c0 = std::max(0, i - a->kl);
+        int c1 = std::min(a->n, i + a->ku + 1);
+        memset(&row[i - a->kl], 0, a->ld * sizeof(float));
+        ge_random_cols(&row[c0], i, c0, c1, seed);
+        float off = 0;
+        for(int j = c0; j < c1; j++){
+            off += (j == i) ? 0 : std::fabs(row[j]);
+        }
+        row[i] += (row[i] < 0) ? -off : off;
+    }
+}
+
+// Copies a banded matrix into a dense n x n one
+// Takes the banded matrix and the dense matrix as arguments
+void ge_banded_to_dense(const GeBanded *a, float *dense){
+    int n = a->n;
+    memset(dense, 0, (size_t)n * n * sizeof(float));
+    for(int i = 0; i < n; i++){
+        const float *row = ge_band_row(a, i);
+        int c0 = std::max(0, i - a->kl);
+        int c1 = std::min(n, i + a->ku + 1);
+        memcpy(&dense[(size_t)i * n + c0], &row[c0],
+                (c1 - c0) * sizeof(float));
+    }
+}
+
+// Last row eliminated at step k
+// Takes the matrix and the step as arguments
+inline int ge_band_last_row(const GeBanded *a, int k){
+    return std::min(a->n - 1, k + a->kl);
+}
+
+// End of the columns updated at step k
+// Takes the matrix and the step as arguments
+inline int ge_band_end_col(const GeBanded *a, int k){
+    return std::min(a->n, k + a->kl + a->ku + 1);
+}
+
+// Picks the pivot of column k from rows [k, k + kl], swaps it into row
+// k, and normalizes row k to it
+// Takes the matrix and the step as arguments
+void ge_band_pivot(GeBanded *a, int k){
+    int last = ge_band_last_row(a, k);
+    int end = ge_band_end_col(a, k);
+
+    // Largest magnitude in column k
+    int p = k;
+    float best = std::fabs(ge_band_row(a, k)[k]);
+    for(int r = k + 1; r <= last; r++){
+        float v = std::fabs(ge_band_row(a, r)[k]);
+        if(v > best){
+            best = v;
+            p = r;
+        }
+    }
+    a->piv[k] = p;
+
+    // Swap from column k on (the multipliers left of it stay put)
+    float *row = ge_band_row(a, k);
+    if(p != k){
+        float *other = ge_band_row(a, p);
+        for(int j = k; j < end; j++){
+            std::swap(row[j], other[j]);
+        }
+    }
+
+    // Normalize the rest of the row, and keep the pivot on the diagonal
+    ge_scale(&row[k + 1], 1.0f / row[k], end - k - 1);
+}
+
+// Eliminates column k from row r, leaving the multiplier in column k
+// Takes the matrix, the step, and the row as arguments
+inline void ge_band_update(GeBanded *a, int k, int r){
+    int end = ge_band_end_col(a, k);
+    float *row = ge_band_row(a, r);
+    ge_eliminate(&row[k + 1], &ge_band_row(a, k)[k + 1], row[k],
+            end - k - 1);
+}
+
+// Factors a banded matrix in place (serial)
+// Takes the matrix as an argument
+void ge_banded_serial(GeBanded *a){
+    for(int k = 0; k < a->n; k++){
+        ge_band_pivot(a, k);
+        for(int r = k + 1; r <= ge_band_last_row(a, k); r++){
+            ge_band_update(a, k, r);
+        }
+    }
+}
+
+// Factors pivots [k0, k1) of a banded matrix on the columns of the
+// panel only (columns [k0, k1)). Everything right of the panel is left
+// for ge_banded_apply
+// Takes the matrix and the first and last (exclusive) pivots as
+// arguments
+void ge_banded_panel(GeBanded *a, int k0, int k1){
+    for(int k = k0; k < k1; k++){
+        int last = ge_band_last_row(a, k);
+        int end = std::min(k1, ge_band_end_col(a, k));
+
+        // Largest magnitude in column k
+        int p = k;
+        float best = std::fabs(ge_band_row(a, k)[k]);
+        for(int r = k + 1; r <= last; r++){
+            float v = std::fabs(ge_band_row(a, r)[k]);
+            if(v > best){
+                best = v;
+                p = r;
+            }
+        }
+        a->piv[k] = p;
+
+        // Swap, normalize, and eliminate inside the panel
+        float *row = ge_band_row(a, k);
+        if(p != k){
+            float *other = ge_band_row(a, p);
+            for(int j = k; j < end; j++){
+                std::swap(row[j], other[j]);
+            }
+        }
+        ge_scale(&row[k + 1], 1.0f / row[k], end - k - 1);
+        for(int r = k + 1; r <= last; r++){
+            float *target = ge_band_row(a, r);
+            ge_eliminate(&target[k + 1], &row[k + 1], target[k],
+                    end - k - 1);
+        }
+    }
+}
+
+// Floats of scratch space ge_banded_apply needs for panels of nb pivots
+// Takes the matrix and the number of pivots per panel as arguments
+int ge_banded_work_size(const GeBanded *a, int nb){
+    return (nb + a->kl) * nb + nb * (a->kl + a->ku);
+}
+
+// Applies pivots [k0, k1) (factored by ge_banded_panel) to columns
+// [c0, c1) right of the panel, which gives the same columns as
+// ge_banded_serial. As in a blocked dense LU, the swaps are done first
+// (the multipliers in work are swapped along with the rows), the pivot
+// rows are solved one after another, and the rest of the window is
+// updated four pivot rows at a time. Columns are independent of each
+// other, so threads may split them
+// Takes the matrix, the first and last (exclusive) pivots, the first
+// and last (exclusive) columns, and ge_banded_work_size floats of
+// scratch space as arguments
+void ge_banded_apply(GeBanded *a, int k0, int k1, int c0, int c1,
+        float *work){
+    int nb = k1 - k0;
+    int last = ge_band_last_row(a, k1 - 1);
+    int width = c1 - c0;
+
+    // Multipliers of the window rows (row r - k0, column k - k0), with
+    // the swaps of later pivots applied to them
+    float *l = work;
+    memset(l, 0, (size_t)(last - k0 + 1) * nb * sizeof(float));
+    for(int k = k0; k < k1; k++){
+        int p = a->piv[k];
+        for(int j = 0; j < k - k0; j++){
+            std::swap(l[(k - k0) * nb + j], l[(p - k0) * nb + j]);
+        }
+        for(int r = k + 1; r <= ge_band_last_row(a, k); r++){
+            l[(r - k0) * nb + k - k0] = ge_band_row(a, r)[k];
+        }
+    }
+
+    // Swap the rows (past its band, row k and the row swapped into it
+    // are both zero)
+    for(int k = k0; k < k1; k++){
+        int p = a->piv[k];
+        int end = std::min(c1, ge_band_end_col(a, k));
+        if(p != k && c0 < end){
+            float *row = ge_band_row(a, k);
+            float *other = ge_band_row(a, p);
+            for(int j = c0; j < end; j++){
+                std::swap(row[j], other[j]);
+            }
+        }
+    }
+
+    // Pivot rows, copied with zeros past their band for the update
+    float *u = &work[(size_t)(last - k0 + 1) * nb];
+    const float *src[4];
+    for(int k = k0; k < k1; k++){
+        int end = std::min(c1, ge_band_end_col(a, k));
+        float *row = ge_band_row(a, k);
+        float *u_row = &u[(size_t)(k - k0) * width];
+        if(c0 < end){
+            const float *scale = &l[(k - k0) * nb];
+            int j = 0;
+            for(; j + 4 <= k - k0; j += 4){
+                for(int q = 0; q < 4; q++){
+                    src[q] = &u[(size_t)(j + q) * width];
+                }
+                ge_eliminate4(&row[c0], src, &scale[j], end - c0);
+            }
+            for(; j < k - k0; j++){
+                ge_eliminate(&row[c0], &u[(size_t)j * width], scale[j],
+                        end - c0);
+            }
+            ge_scale(&row[c0], 1.0f / row[k], end - c0);
+            memcpy(u_row, &row[c0], (end - c0) * sizeof(float));
+        }
+        for(int j = std::max(c0, end); j < c1; j++){
+            u_row[j - c0] = 0;
+        }
+    }
+
+    // The rest of the window
+    for(int r = k1; r <= last; r++){
+        float *row = ge_band_row(a, r);
+        const float *scale = &l[(r - k0) * nb];
+        int j = 0;
+        for(; j + 4 <= nb; j += 4){
+            for(int q = 0; q < 4; q++){
+                src[q] = &u[(size_t)(j + q) * width];
+            }
+            ge_eliminate4(&row[c0], src, &scale[j], width);
+        }
+        for(; j < nb; j++){
+            ge_eliminate(&row[c0], &u[(size_t)j * width], scale[j], width);
+        }
+    }
+}
+
+// Solves Ax = b with a factored banded matrix
+// Takes the factored matrix, and b (replaced by x) as arguments
+void ge_banded_solve(const GeBanded *a, float *x){
+    int n = a->n;
+
+    // Replay the swaps and eliminations on b, and divide by the pivots
+    for(int k = 0; k < n; k++){
+        std::swap(x[k], x[a->piv[k]]);
+        x[k] /= ge_band_row(a, k)[k];
+        for(int r = k + 1; r <= ge_band_last_row(a, k); r++){
+            x[r] -= ge_band_row(a, r)[k] * x[k];
+        }
+    }
+
+    // Back substitution (U has a unit diagonal)
+    for(int i = n - 1; i >= 0; i--){
+        const float *row = ge_band_row(a, i);
+        float sum = x[i];
+        for(int j = i + 1; j < ge_band_end_col(a, i); j++){
+            sum -= row[j] * x[j];
+        }
+        x[i] = sum;
+    }
+}
+
+// Checks the solution of Ax = b with the original banded matrix:
+// ||A x - b|| / (||A|| ||x|| + ||b||) in the infinity norm
+// Takes the matrix, the solution, and the right-hand side as arguments
+// Returns the relative residual
+double ge_banded_residual(const GeBanded *a, const float *x,
+        const float *b){
+    double error = 0;
+    double norm = 0;
+    double x_norm = 0;
+    double b_norm = 0;
+    for(int i = 0; i < a->n; i++){
+        const float *row = ge_band_row(a, i);
+        int c0 = std::max(0, i - a->kl);
+        int c1 = std::min(a->n, i + a->ku + 1);
+        double r = -b[i];
+        double abs_sum = 0;
+        for(int j = c0; j < c1; j++){
+            r += (double)row[j] * x[j];
+            abs_sum += std::fabs(row[j]);
+        }
+        error = ge_max_error(error, std::fabs(r));
+        norm = ge_max_error(norm, abs_sum);
+        x_norm = ge_max_error(x_norm, std::fabs(x[i]));
+        b_norm = ge_max_error(b_norm, std::fabs(b[i]));
+    }
+    return ge_relative_error(error, norm * x_norm + b_norm);
+}
+
+#endif
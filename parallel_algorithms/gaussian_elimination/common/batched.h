@@ -0,0 +1,192 @@
+// This file contains a batched solver for many small independent
+// systems (Ax = b). Systems are stored interleaved in groups of
+// GE_BATCH_WIDTH, so element (i, j) of every system of a group is
+// contiguous and each step of elimination runs across SIMD lanes, one
+// system per lane, with its own partial pivoting
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_BATCHED_H
+#define GE_BATCHED_H
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// Number of systems interleaved in one group (one AVX-512 vector)
+const int GE_BATCH_WIDTH = 16;
+
+// A batch of count systems of dimension n
+// Group g holds systems [g * W, (g + 1) * W), with element (i, j) of
+// lane l at a[g][(i * n + j) * W + l] and b_i at b[g][i * W + l]
+// Unused lanes of the last group hold identity systems
+struct GeBatch {
+    int n;
+    int count;
+    int num_groups;
+    float *a;
+    float *b;
+};
+
+// Allocates a batch, with every system set to the identity
+// Takes the batch, the dimension, and the number of systems as
+// arguments
+void ge_batch_init(GeBatch *batch, int n, int count){
+    const int W = GE_BATCH_WIDTH;
+    batch->n = n;
+    batch->count = count;
+    batch->num_groups = (count + W - 1) / W;
+    size_t a_size = (size_t)batch->num_groups * n * n * W;
+    size_t b_size = (size_t)batch->num_groups * n * W;
+    batch->a = new float[a_size];
+    batch->b = new float[b_size];
+    memset(batch->a, 0, a_size * sizeof(float));
+    memset(batch->b, 0, b_size * sizeof(float));
+    for(int g = 0; g < batch->num_groups; g++){
+        float *a = &batch->a[(size_t)g * n * n * W];
+        for(int i = 0; i < n; i++){
+            for(int l = 0; l < W; l++){
+                a[(i * n + i) * W + l] = 1;
+            }
+        }
+    }
+}
+
+// Frees a batch
+void ge_batch_destroy(GeBatch *batch){
+    delete[] batch->a;
+    delete[] batch->b;
+}
+
+// Copies one system into its lane
+// Takes the batch, the system number, A (n x n), and b as arguments
+void ge_batch_pack(GeBatch *batch, int s, const float *A, const float *b){
+    const int W = GE_BATCH_WIDTH;
+    int n = batch->n;
+    int l = s % W;
+    float *a = &batch->a[(size_t)(s / W) * n * n * W];
+    float *bb = &batch->b[(size_t)(s / W) * n * W];
+    for(int i = 0; i < n; i++){
+        for(int j = 0; j < n; j++){
+            a[(i * n + j) * W + l] = A[i * n + j];
+        }
+        bb[i * W + l] = b[i];
+    }
+}
+
+// Copies the solution of one system out of its lane
+// Takes the batch, the system number, and x as arguments
+void ge_batch_unpack(const GeBatch *batch, int s, float *x){
+    const int W = GE_BATCH_WIDTH;
+    int n = batch->n;
+    const float *bb = &batch->b[(size_t)(s / W) * n * W];
+    for(int i = 0; i < n; i++){
+        x[i] = bb[i * W + s % W];
+    }
+}
+
+// dst[l] -= scale[l] * src[l] for every lane
+// Separate (restrict) pointers let the compiler vectorize the lanes
+// without checking for overlap
+// Takes the destination lanes, the source lanes, and the scales as
+// arguments
+inline void ge_lanes_eliminate(float *__restrict dst,
+        const float *__restrict src, const float *__restrict scale){
+    for(int l = 0; l < GE_BATCH_WIDTH; l++){
+        dst[l] -= scale[l] * src[l];
+    }
+}
+
+// dst[l] *= scale[l] for every lane
+// Takes the lanes and the scales as arguments
+inline void ge_lanes_scale(float *__restrict dst,
+        const float *__restrict scale){
+    for(int l = 0; l < GE_BATCH_WIDTH; l++){
+        dst[l] *= scale[l];
+    }
+}
+
+// Solves the W systems of one group in place (b is replaced by x)
+// Every loop over l is a loop over the lanes, so it vectorizes
+// Takes the interleaved A and b of the group, and the dimension as
+// arguments
+void ge_batch_solve_group(float *a, float *b, int n){
+    const int W = GE_BATCH_WIDTH;
+
+    for(int i = 0; i < n; i++){
+        // Each lane finds its own pivot in column i (ties go to the
+        // lowest row, as in ge_serial)
+        float best[W];
+        int piv[W];
+        for(int l = 0; l < W; l++){
+            best[l] = std::fabs(a[(i * n + i) * W + l]);
+            piv[l] = i;
+        }
+        for(int r = i + 1; r < n; r++){
+            const float *col = &a[(r * n + i) * W];
+            for(int l = 0; l < W; l++){
+                bool better = std::fabs(col[l]) > best[l];
+                best[l] = better ? std::fabs(col[l]) : best[l];
+                piv[l] = better ? r : piv[l];
+            }
+        }
+
+        // Lanes whose pivot is another row swap it in (only the columns
+        // still in use, and b)
+        for(int l = 0; l < W; l++){
+            int p = piv[l];
+            if(p == i){
+                continue;
+            }
+            for(int j = i; j < n; j++){
+                std::swap(a[(i * n + j) * W + l], a[(p * n + j) * W + l]);
+            }
+            std::swap(b[i * W + l], b[p * W + l]);
+        }
+
+        // Normalize the pivot row of every lane
+        float *pivot_row = &a[i * n * W];
+        float inv[W];
+        for(int l = 0; l < W; l++){
+            inv[l] = 1.0f / pivot_row[i * W + l];
+            pivot_row[i * W + l] = 1;
+            b[i * W + l] *= inv[l];
+        }
+        for(int j = i + 1; j < n; j++){
+            ge_lanes_scale(&pivot_row[j * W], inv);
+        }
+
+        // Eliminate column i from the rows below
+        for(int r = i + 1; r < n; r++){
+            float *row = &a[r * n * W];
+            float scale[W];
+            for(int l = 0; l < W; l++){
+                scale[l] = row[i * W + l];
+                row[i * W + l] = 0;
+                b[r * W + l] -= scale[l] * b[i * W + l];
+            }
+            for(int j = i + 1; j < n; j++){
+                ge_lanes_eliminate(&row[j * W], &pivot_row[j * W], scale);
+            }
+        }
+    }
+
+    // Back substitution against the unit upper-triangular matrix
+    for(int i = n - 2; i >= 0; i--){
+        for(int j = i + 1; j < n; j++){
+            ge_lanes_eliminate(&b[i * W], &b[j * W], &a[(i * n + j) * W]);
+        }
+    }
+}
+
+// Solves groups [g0, g1) of a batch in place
+// Takes the batch and the range of groups as arguments
+void ge_batch_solve(GeBatch *batch, int g0, int g1){
+    const int W = GE_BATCH_WIDTH;
+    int n = batch->n;
+    for(int g = g0; g < g1; g++){
+        ge_batch_solve_group(&batch->a[(size_t)g * n * n * W],
+                &batch->b[(size_t)g * n * W], n);
+    }
+}
+
+#endif
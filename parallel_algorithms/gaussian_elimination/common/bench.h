@@ -0,0 +1,192 @@
+// This file contains the command line options and result reporting
+// shared by the Gaussian Elimination programs and the benchmark driver
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_BENCH_H
+#define GE_BENCH_H
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+// Options every program accepts
+struct BenchConfig {
+    // Dimensions of square matrix (-n)
+    int N;
+    // Number of threads to launch (-t), threads per rank in the hybrid
+    // MPI program and ignored by the other MPI programs
+    int num_threads;
+    // Untimed runs before measuring (-w)
+    int warmup;
+    // Timed runs (-r)
+    int reps;
+    // Seed of the random matrix (-s)
+    uint32_t seed;
+    // Check against the serial version, or with an O(N^2) residual
+    // (-v serial or -v residual)
+    int verify;
+    // Row stride and pages of the pthread matrix (-l huge, hugetlb,
+    // padded, or dense)
+    int layout;
+    // How the row-mapped pthread programs move from pivot to pivot (-e
+    // lookahead, barrier, or both)
+    int schedule;
+};
+
+// Ways to check a result
+const int GE_VERIFY_SERIAL = 0;
+const int GE_VERIFY_RESIDUAL = 1;
+
+// Matrix layouts: padded rows on transparent huge pages, padded rows on
+// hugetlb pages, padded rows on regular pages, and rows of exactly N
+// Regular pages are the default: a 2 MB page holds rows of many threads
+// under a cyclic mapping, so first touch can not place each thread's
+// rows on its own NUMA node
+const int GE_LAYOUT_HUGE = 0;
+const int GE_LAYOUT_HUGETLB = 1;
+const int GE_LAYOUT_PADDED = 2;
+const int GE_LAYOUT_DENSE = 3;
+
+// Pivot schedules: the barrier-free lookahead pipeline, a barrier around
+// every pivot, or both one after the other (checked against each other)
+const int GE_SCHEDULE_LOOKAHEAD = 0;
+const int GE_SCHEDULE_BARRIER = 1;
+const int GE_SCHEDULE_BOTH = 2;
+
+// Default options of a program: no warmup, one timed run, seed 0, checked
+// against the serial version, padded rows on regular pages, and the
+// lookahead pipeline
+// Takes the default dimension and number of threads as arguments
+BenchConfig ge_bench_defaults(int N, int num_threads){
+    BenchConfig config;
+    config.N = N;
+    config.num_threads = num_threads;
+    config.warmup = 0;
+    config.reps = 1;
+    config.seed = 0;
+    config.verify = GE_VERIFY_SERIAL;
+    config.layout = GE_LAYOUT_PADDED;
+    config.schedule = GE_SCHEDULE_LOOKAHEAD;
+    return config;
+}
+
+// Reads "-n N -t threads -w warmup -r reps -s seed -v check -l layout
+// -e schedule" from the command line
+// Options that are not given keep the values already in config
+// Takes the argument count, the arguments, and the config as arguments
+void parse_bench_args(int argc, char *argv[], BenchConfig *config){
+    for(int i = 1; i + 1 < argc; i += 2){
+        int value = atoi(argv[i + 1]);
+        if(strcmp(argv[i], "-n") == 0){
+            config->N = value;
+        }else if(strcmp(argv[i], "-t") == 0){
+            config->num_threads = value;
+        }else if(strcmp(argv[i], "-w") == 0){
+            config->warmup = value;
+        }else if(strcmp(argv[i], "-r") == 0){
+            config->reps = value;
+        }else if(strcmp(argv[i], "-s") == 0){
+            config->seed = strtoul(argv[i + 1], NULL, 0);
+        }else if(strcmp(argv[i], "-v") == 0){
+            config->verify = (strcmp(argv[i + 1], "residual") == 0) ?
+                GE_VERIFY_RESIDUAL : GE_VERIFY_SERIAL;
+        }else if(strcmp(argv[i], "-l") == 0){
+            const char *name = argv[i + 1];
+            config->layout = (strcmp(name, "dense") == 0) ? GE_LAYOUT_DENSE
+                : (strcmp(name, "huge") == 0) ? GE_LAYOUT_HUGE
+                : (strcmp(name, "hugetlb") == 0) ? GE_LAYOUT_HUGETLB
+                : GE_LAYOUT_PADDED;
+        }else if(strcmp(argv[i], "-e") == 0){
+            const char *name = argv[i + 1];
+            if(strcmp(name, "lookahead") == 0){
+                config->schedule = GE_SCHEDULE_LOOKAHEAD;
+            }else if(strcmp(name, "barrier") == 0){
+                config->schedule = GE_SCHEDULE_BARRIER;
+            }else if(strcmp(name, "both") == 0){
+                config->schedule = GE_SCHEDULE_BOTH;
+            }else{
+                std::cerr << "Bad schedule " << name << " (lookahead,"
+                    << " barrier, or both)" << std::endl;
+                exit(1);
+            }
+        }else{
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            exit(1);
+        }
+    }
+}
+
+// Summary of repeated timings
+struct BenchStats {
+    double median;
+    double p95;
+};
+
+// Computes the median and 95th percentile (nearest rank) of timings
+// Takes the timings in seconds as an argument
+BenchStats bench_stats(std::vector<double> times){
+    BenchStats stats = {0, 0};
+    if(times.empty()){
+        return stats;
+    }
+    std::sort(times.begin(), times.end());
+    size_t n = times.size();
+    stats.median = (n % 2) ? times[n / 2] :
+        (times[n / 2 - 1] + times[n / 2]) / 2;
+    size_t rank = (95 * n + 99) / 100;
+    stats.p95 = times[std::max<size_t>(rank, 1) - 1];
+    return stats;
+}
+
+// Floating point rate of Gaussian Elimination (2/3 N^3 operations)
+// Takes the dimension and the time in seconds as arguments
+double ge_gflops(int N, double seconds){
+    return (2.0 / 3.0) * N * (double)N * N / seconds / 1e9;
+}
+
+// Prints the timings of one version as a machine-readable line:
+// BENCH,<version>,<N>,<workers>,<time 1>,<time 2>,...
+// Takes the version name, the dimension, the number of threads or
+// ranks, and the timings in seconds as arguments
+void print_bench_line(const char *version, int N, int workers,
+        const std::vector<double> &times){
+    std::cout << "BENCH," << version << "," << N << "," << workers;
+    for(size_t i = 0; i < times.size(); i++){
+        std::cout << "," << times[i];
+    }
+    std::cout << std::endl;
+}
+
+// Prints the operations of one run of a version whose structure (a band
+// or a sparse pattern) makes it do fewer than 2/3 N^3 as a
+// machine-readable line:
+// FLOPS,<version>,<operations>
+// The benchmark driver reports its GFLOP/s from this count, and no
+// efficiency against the dense serial version
+// Takes the version name and the number of operations as arguments
+void print_flops_line(const char *version, double flops){
+    std::cout << "FLOPS," << version << "," << flops << std::endl;
+}
+
+// Prints the timings of a version that solves many small systems per
+// run as a machine-readable line:
+// THROUGHPUT,<version>,<N>,<workers>,<systems>,<time 1>,<time 2>,...
+// Each time covers all of the systems, so the benchmark driver reports
+// systems per second instead of the GFLOP/s of one N x N elimination
+// Takes the version name, the size of each system, the number of
+// threads, the number of systems per run, and the timings in seconds as
+// arguments
+void print_throughput_line(const char *version, int N, int workers,
+        int count, const std::vector<double> &times){
+    std::cout << "THROUGHPUT," << version << "," << N << "," << workers
+        << "," << count;
+    for(size_t i = 0; i < times.size(); i++){
+        std::cout << "," << times[i];
+    }
+    std::cout << std::endl;
+}
+
+#endif
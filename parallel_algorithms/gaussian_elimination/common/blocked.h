@@ -0,0 +1,279 @@
+// This file contains the building blocks of blocked (right-looking)
+// Gaussian Elimination shared by the serial, pthread, and MPI versions
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_BLOCKED_H
+#define GE_BLOCKED_H
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <new>
+#include <stdlib.h>
+#include "kernels.h"
+
+// Default number of pivots eliminated together in one panel
+const int GE_BLOCK_SIZE = 32;
+
+// Number of columns in one tile of the trailing update
+// A tile of the panel's pivot rows (32 x 256 floats) stays in cache
+// while it is applied to every remaining row
+const int GE_TILE_COLS = 256;
+
+// Allocates and constructs an array of a cache-line aligned type
+// (new[] only respects alignas from C++17 on)
+// Takes the number of elements as an argument
+// Returns the array, to be freed with ge_aligned_delete
+template <typename T>
+T *ge_aligned_new(int count){
+    void *memory = NULL;
+    if(posix_memalign(&memory, alignof(T), count * sizeof(T)) != 0){
+        std::cerr << "Could not allocate " << count * sizeof(T)
+            << " bytes" << std::endl;
+        exit(1);
+    }
+    T *array = (T*)memory;
+    for(int i = 0; i < count; i++){
+        new (&array[i]) T();
+    }
+    return array;
+}
+
+// Destroys and frees an array from ge_aligned_new
+// Takes the array and the number of elements as arguments
+template <typename T>
+void ge_aligned_delete(T *array, int count){
+    for(int i = 0; i < count; i++){
+        array[i].~T();
+    }
+    free(array);
+}
+
+// Real type of an element (the type of its magnitude)
+template <typename T>
+struct GeReal {
+    typedef T type;
+};
+
+template <typename R>
+struct GeReal<std::complex<R> > {
+    typedef R type;
+};
+
+// Normalizes a pivot row to its pivot
+// Takes the row, the pivot column, and the row length as arguments
+template <typename T>
+void ge_normalize_row(T *row, int i, int N){
+    // Pivot is the diagonal element
+    T pivot = row[i];
+
+    // Multiply the rest of the row by the reciprocal of the pivot
+    ge_scale(&row[i + 1], T(1) / pivot, N - i - 1);
+
+    // Use assignment for the trivial self-division
+    row[i] = 1;
+}
+
+// Eliminates pivot i from the panel columns of a set of rows
+// Only columns (i, k1) are updated, the multiplier is left in column i
+// so the trailing columns can be updated later in one pass
+// Takes the rows to update, the number of rows, the normalized pivot
+// row, the pivot column, and the end of the panel as arguments
+template <typename T>
+void ge_panel_update(T **rows, int num_rows, const T *pivot_row, int i,
+        int k1){
+    for(int r = 0; r < num_rows; r++){
+        T *row = rows[r];
+
+        // Scale the subtraction by the ith element of this row
+        T scale = row[i];
+
+        // Subtract from the remaining panel columns
+        ge_eliminate(&row[i + 1], &pivot_row[i + 1], scale, k1 - i - 1);
+    }
+}
+
+// Applies the pivot rows [k0, k1) to columns [col_begin, N) of a set
+// of rows, using the multipliers stored in columns [k0, k1) of each row
+// The columns are processed in tiles so each tile of the pivot rows is
+// reused by all rows while it is still in cache
+// Takes the rows to update, the number of rows, the normalized pivot
+// rows (u_rows[0] is pivot row k0), the pivot range, the first column
+// to update, and the row length as arguments
+template <typename T>
+void ge_trailing_update(T **rows, int num_rows, const T **u_rows, int k0,
+        int k1, int col_begin, int N){
+    for(int c0 = col_begin; c0 < N; c0 += GE_TILE_COLS){
+        int c1 = std::min(c0 + GE_TILE_COLS, N);
+
+        for(int r = 0; r < num_rows; r++){
+            T *row = rows[r];
+
+            // Apply the pivot rows four at a time so each element of the
+            // tile is loaded and stored once per four pivots
+            // (subtractions still happen in the same order as unblocked)
+            int i = k0;
+            for(; i + 3 < k1; i += 4){
+                const T *u[4] = {&u_rows[i - k0][c0],
+                    &u_rows[i - k0 + 1][c0], &u_rows[i - k0 + 2][c0],
+                    &u_rows[i - k0 + 3][c0]};
+                ge_eliminate4(&row[c0], u, &row[i], c1 - c0);
+            }
+
+            // Apply any leftover pivot rows one at a time
+            for(; i < k1; i++){
+                ge_eliminate(&row[c0], &u_rows[i - k0][c0], row[i],
+                        c1 - c0);
+            }
+        }
+    }
+}
+
+// Zeroes the multipliers in columns [k0, k1) once they are consumed
+// Takes the rows, the number of rows, and the column range as arguments
+template <typename T>
+void ge_clear_multipliers(T **rows, int num_rows, int k0, int k1){
+    for(int r = 0; r < num_rows; r++){
+        for(int k = k0; k < k1; k++){
+            rows[r][k] = 0;
+        }
+    }
+}
+
+// Brings a pivot row up to date with the earlier pivots of its panel
+// and normalizes it
+// With keep_lu the multipliers and the pivot stay in the row (packed
+// LU), otherwise they are replaced by zeros and a one
+// Takes the row, the earlier pivot rows of the panel, the panel range,
+// the pivot column, the row length, and the packed LU flag as arguments
+template <typename T>
+void ge_factor_pivot_row(T *row, const T **u_rows, int k0, int k1, int i,
+        int N, bool keep_lu = false){
+    // Trailing columns were deferred while the panel was factored
+    ge_trailing_update(&row, 1, u_rows, k0, i, k1, N);
+
+    // Normalize this row to the pivot
+    T pivot = row[i];
+    ge_normalize_row(row, i, N);
+
+    if(keep_lu){
+        // The diagonal of L is the pivot (U has an implicit unit diagonal)
+        row[i] = pivot;
+    }else{
+        // Use assignment for the trivial eliminations
+        ge_clear_multipliers(&row, 1, k0, i);
+    }
+}
+
+// Candidate pivot: its magnitude and the matrix row it lives in
+template <typename R>
+struct GeBasicPivot {
+    R value;
+    int row;
+};
+
+// Candidate pivot of a float matrix (same layout as MPI_FLOAT_INT, so it
+// can be reduced with MPI_MAXLOC)
+typedef GeBasicPivot<float> GePivot;
+
+// Checks if candidate a should be the pivot instead of candidate b
+// The larger magnitude wins, and ties go to the lowest row
+template <typename R>
+bool ge_better_pivot(GeBasicPivot<R> a, GeBasicPivot<R> b){
+    return (a.value > b.value) || ((a.value == b.value) && (a.row < b.row));
+}
+
+// Finds the row with the largest magnitude in column i
+// Takes the candidate rows, their matrix row numbers, the number of
+// rows, the pivot column, and where to store the position of the best
+// row as arguments
+// Returns the best candidate (value -1 if there are no rows)
+template <typename T>
+GeBasicPivot<typename GeReal<T>::type> ge_find_pivot(T **rows,
+        const int *ids, int num_rows, int i, int *pos){
+    typedef GeBasicPivot<typename GeReal<T>::type> Pivot;
+    Pivot best = {-1, -1};
+    *pos = -1;
+    for(int r = 0; r < num_rows; r++){
+        Pivot c = {std::abs(rows[r][i]), ids[r]};
+        if(ge_better_pivot(c, best)){
+            best = c;
+            *pos = r;
+        }
+    }
+    return best;
+}
+
+// Swaps two entries of a row list (only the pointers move, not the rows)
+// Takes the row pointers, their matrix row numbers, and the two
+// positions as arguments
+template <typename T>
+void ge_swap_rows(T **rows, int *ids, int a, int b){
+    std::swap(rows[a], rows[b]);
+    std::swap(ids[a], ids[b]);
+}
+
+// Blocked Gaussian Elimination with partial pivoting
+// Each panel of block_size pivots only updates its own columns while it
+// is factored, then the rest of the matrix is updated once per panel
+// Rows are never moved: the pivot for column i is the remaining row
+// with the largest magnitude in that column, and perm[i] records which
+// matrix row it was
+// Rows may be longer than n (e.g. an augmented matrix [A | B]), and the
+// extra columns are eliminated along with the first n
+// With keep_lu, row perm[i] is left holding row i of L left of the
+// diagonal, the pivot on it, and row i of U right of it (packed LU)
+// Takes a pointer to a matrix (of float, double, or complex numbers),
+// its number of rows, the length of each row, the permutation vector,
+// the panel size, the packed LU flag, and the distance between rows (0
+// if rows are packed) as arguments
+template <typename T>
+void ge_blocked(T *matrix, int n, int ncols, int *perm, int block_size,
+        bool keep_lu = false, int ld = 0){
+    if(ld == 0){
+        ld = ncols;
+    }
+
+    // Pointers to every row, and to the pivot rows of the current panel
+    // rows[0, i) are the pivot rows so far, rows[i, n) still remain
+    T **rows = new T*[n];
+    int *ids = new int[n];
+    const T **u_rows = new const T*[block_size];
+    for(int i = 0; i < n; i++){
+        rows[i] = &matrix[(size_t)i * ld];
+        ids[i] = i;
+    }
+
+    for(int k0 = 0; k0 < n; k0 += block_size){
+        int k1 = std::min(k0 + block_size, n);
+
+        // Factor the panel
+        for(int i = k0; i < k1; i++){
+            // Pick the pivot and move its pointer to the front
+            int pos;
+            ge_find_pivot(&rows[i], &ids[i], n - i, i, &pos);
+            ge_swap_rows(rows, ids, i, i + pos);
+            perm[i] = ids[i];
+
+            ge_factor_pivot_row(rows[i], u_rows, k0, k1, i, ncols,
+                    keep_lu);
+            u_rows[i - k0] = rows[i];
+
+            // Eliminate the pivot from the panel columns of later rows
+            ge_panel_update(&rows[i + 1], n - i - 1, rows[i], i, k1);
+        }
+
+        // Update the trailing matrix with the whole panel
+        ge_trailing_update(&rows[k1], n - k1, u_rows, k0, k1, k1, ncols);
+        if(!keep_lu){
+            ge_clear_multipliers(&rows[k1], n - k1, k0, k1);
+        }
+    }
+
+    delete[] rows;
+    delete[] ids;
+    delete[] u_rows;
+}
+
+#endif
@@ -6,63 +6,45 @@
 #include <iomanip>
 #include <cstring>
 #include <assert.h>
-#include <time.h>
+#include "blocked.h"
+#include "random.h"
+#include "verify.h"
 
 using namespace std;
 
 // Serial function for computing Gaussian Elimination
-// Takes a pointer to a matrix and its dimension as arguments 
-void ge_serial(float *matrix, int n){
-    // Iterate over each row in the matrix
-    float pivot;
-    for(int i = 0; i < n - 1; i++){
-        // Pivot will be the diagonal
-        pivot = matrix[i * n + i];
-
-        // Iterate of the remaining row elements
-        for(int j = i + 1; j < n; j++){
-            // Divide by the pivot
-            matrix[i * n + j] /= pivot;
-        }
-
-        // Do direct assignment for trivial case (self-divide)
-        matrix[i * n + i] = 1.0;
-
-        // Eliminate ith element from the jth row
-        float scale;
-        for(int j = i + 1; j < n; j++){
-            // Factor we will use to scale subtraction by
-            scale = matrix[j * n + i];
-
-            // Iterate over the remaining columns
-            for(int k = i + 1; k < n; k++){
-                matrix[j * n + k] -= matrix[i * n + k] * scale;
-            }
-
-            // Do direct assignment for trivial case (eliminate position)
-            matrix[j * n + i] = 0;
-        }
-    }
+// Row perm[i] of the result holds the ith row of the upper-triangular
+// matrix (partial pivoting without moving any rows)
+// Takes a pointer to a matrix, its dimension, the permutation vector,
+// and the number of pivots per panel as arguments
+template <typename T>
+void ge_serial(T *matrix, int n, int *perm,
+        int block_size = GE_BLOCK_SIZE){
+    // Factor panel by panel and update the trailing matrix in tiles
+    ge_blocked(matrix, n, n, perm, block_size);
+}
 
-    // Trivial case of last row with only one element
-    matrix[(n - 1) * n + n - 1] = 1;
+// Initialize a matrix with random numbers (the same ones for the same
+// seed, however many threads fill it)
+// Takes a matrix, its number of rows, its number of columns, the seed,
+// and the number of threads to fill it with as arguments
+template <typename T>
+void init_matrix(T *matrix, int N, int M, uint32_t seed = 0,
+        int num_threads = 1){
+    ge_random_matrix(matrix, N, M, seed, num_threads);
 }
 
-// Initialize a matrix with random numbers
+// Initialize a square matrix with random numbers
 // Takes a matrix and its dimension as arguments
-void init_matrix(float *matrix, int N){
-    srand(time(NULL));
-    for(int i = 0; i < N; i++){
-        for(int j = 0; j < N; j++){
-            // Random number between 100 and -100
-            matrix[i * N + j] = (float(rand())/float(RAND_MAX)) * (100 - -100) + -100; 
-        }
-    }
+template <typename T>
+void init_matrix(T *matrix, int N){
+    init_matrix(matrix, N, N);
 }
 
 // Prints a matrix
 // Takes a matrix and its dimension as arguments
-void print_matrix(float *matrix, int N){
+template <typename T>
+void print_matrix(T *matrix, int N){
     for(int i = 0; i < N; i++){
         for(int j = 0; j < N; j++){
             cout << setprecision(3) << matrix[i * N + j] << "\t";
@@ -74,15 +56,69 @@ void print_matrix(float *matrix, int N){
 }
 
 // Verifies the solution of Gaussian Elimination to the serial impl.
-// Takes two matrices and a their dimensions as arguments
-void verify_solution(float *matrix1, float *matrix2, int N){
+// Takes two matrices, their number of rows, their number of columns, and
+// the distance between rows of the second and of the first one (0 if
+// its rows are packed) as arguments
+template <typename T>
+void verify_solution(T *matrix1, T *matrix2, int N, int M, int ld2 = 0,
+        int ld1 = 0){
     // Error can not exceed this bound
-    float epsilon = 0.005;
+    typename GeReal<T>::type epsilon = 0.005;
+    if(ld2 == 0){
+        ld2 = M;
+    }
+    if(ld1 == 0){
+        ld1 = M;
+    }
     for(int i = 0; i < N; i++){
-        for(int j = 0; j < N; j++){
+        for(int j = 0; j < M; j++){
             // Fail if error exceeds epsilon
-            assert(abs(matrix1[i * N + j] - matrix2[i * N + j]) <= epsilon);
+            assert(abs(matrix1[(size_t)i * ld1 + j] -
+                        matrix2[(size_t)i * ld2 + j]) <= epsilon);
+        }
+    }
+}
+
+// Verifies the solution of Gaussian Elimination to the serial impl.
+// Takes two matrices and a their dimensions as arguments
+template <typename T>
+void verify_solution(T *matrix1, T *matrix2, int N){
+    verify_solution(matrix1, matrix2, N, N);
+}
+
+// Relative residual of the solution of a system,
+// ||A x - b|| / (||A|| ||x|| + ||b||) in the infinity norm, which stays
+// near float rounding even for a nearly singular system whose solution
+// two solvers do not agree on
+// Takes the matrix, the solution, the right-hand side, and the dimension
+// as arguments
+// Returns the relative residual
+double relative_residual(const float *A, const float *x, const float *b,
+        int n){
+    double error = 0;
+    double norm = 0;
+    double x_norm = 0;
+    double b_norm = 0;
+    for(int i = 0; i < n; i++){
+        double r = -b[i];
+        double abs_sum = 0;
+        for(int j = 0; j < n; j++){
+            r += (double)A[(size_t)i * n + j] * x[j];
+            abs_sum += fabs(A[(size_t)i * n + j]);
         }
+        error = ge_max_error(error, fabs(r));
+        norm = ge_max_error(norm, abs_sum);
+        x_norm = ge_max_error(x_norm, fabs(x[i]));
+        b_norm = ge_max_error(b_norm, fabs(b[i]));
     }
+    return ge_relative_error(error, norm * x_norm + b_norm);
 }
 
+// Verifies the pivot order of Gaussian Elimination to the serial impl.
+// Takes two permutation vectors and their length as arguments
+void verify_permutation(int *perm1, int *perm2, int N){
+    for(int i = 0; i < N; i++){
+        // Fail if a different row was picked as a pivot
+        assert(perm1[i] == perm2[i]);
+    }
+}
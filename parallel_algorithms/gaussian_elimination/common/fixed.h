@@ -0,0 +1,139 @@
+// This file contains Gaussian Elimination for small matrices whose size
+// is known at compile time. Every loop is unrolled by the compiler, so
+// there is no loop overhead and a whole row can stay in registers
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_FIXED_H
+#define GE_FIXED_H
+
+#include <cmath>
+#include <complex>
+#include "blocked.h"
+
+// Largest size that is unrolled (the code grows with N^3)
+const int GE_FIXED_MAX = 32;
+
+// Calls f.template step<I>() for every I in [Begin, End), with I as a
+// constant, so each call is a separate unrolled step
+template <int Begin, int End>
+struct GeUnroll {
+    template <typename F>
+    static void run(F &f){
+        f.template step<Begin>();
+        GeUnroll<Begin + 1, End>::run(f);
+    }
+};
+
+template <int End>
+struct GeUnroll<End, End> {
+    template <typename F>
+    static void run(F &){
+    }
+};
+
+// dst[j] -= scale * src[j] for a whole row of M elements
+// The length is a constant and the rows can not overlap (restrict), so
+// this compiles to a few full-width vector instructions with no loop
+// Takes the destination row, the source row, and the scale as arguments
+template <typename T, int M>
+inline void ge_fixed_eliminate(T *__restrict dst, const T *__restrict src,
+        T scale){
+    for(int j = 0; j < M; j++){
+        dst[j] -= scale * src[j];
+    }
+}
+
+// row[j] *= scale for a whole row of M elements
+// Takes the row and the scale as arguments
+template <typename T, int M>
+inline void ge_fixed_scale(T *__restrict row, T scale){
+    for(int j = 0; j < M; j++){
+        row[j] *= scale;
+    }
+}
+
+// Finds the remaining row with the largest magnitude in column I (ties
+// go to the lowest row, as in ge_find_pivot)
+template <typename T, int I>
+struct GeFixedPivot {
+    T **rows;
+    const int *ids;
+    int pos;
+    typename GeReal<T>::type best;
+
+    template <int R>
+    void step(){
+        typename GeReal<T>::type value = std::abs(rows[R][I]);
+        if((value > best) || ((value == best) && (ids[R] < ids[pos]))){
+            best = value;
+            pos = R;
+        }
+    }
+};
+
+// Eliminates column I from one remaining row
+template <typename T, int M, int I>
+struct GeFixedUpdate {
+    T **rows;
+
+    template <int R>
+    void step(){
+        T *row = rows[R];
+        ge_fixed_eliminate<T, M>(row, rows[I], row[I]);
+        row[I] = 0;
+    }
+};
+
+// One pivot of the elimination
+template <typename T, int N, int M>
+struct GeFixedStep {
+    T **rows;
+    int *ids;
+    int *perm;
+
+    template <int I>
+    void step(){
+        GeFixedPivot<T, I> pivot = {rows, ids, I, std::abs(rows[I][I])};
+        GeUnroll<I + 1, N>::run(pivot);
+        ge_swap_rows(rows, ids, I, pivot.pos);
+        perm[I] = ids[I];
+
+        // Normalize the pivot row
+        T *pivot_row = rows[I];
+        ge_fixed_scale<T, M>(pivot_row, T(1) / pivot_row[I]);
+        pivot_row[I] = 1;
+
+        // Eliminate the Ith element from the remaining rows
+        GeFixedUpdate<T, M, I> update = {rows};
+        GeUnroll<I + 1, N>::run(update);
+    }
+};
+
+// Gaussian Elimination of an N x N matrix, fully unrolled
+// Every step and every row of a step is unrolled, and row operations
+// cover the whole row (the columns left of the pivot are zero in both
+// rows), so they are straight-line vector code
+// Rows may be longer than N (M columns, e.g. an augmented matrix
+// [A | b]), and the extra columns are eliminated along with the first N
+// Gives the same result as ge_serial: row perm[i] holds the ith row of
+// the upper-triangular matrix
+// Takes a pointer to the matrix and the permutation vector as arguments
+template <typename T, int N, int M = N>
+void ge_fixed(T *matrix, int *perm){
+    static_assert((N > 0) && (N <= GE_FIXED_MAX),
+            "ge_fixed is for small matrices, use ge_serial instead");
+    static_assert(M >= N, "rows need at least N columns");
+
+    // Rows are never moved, only the pointers to them
+    T *rows[N];
+    int ids[N];
+    for(int r = 0; r < N; r++){
+        rows[r] = &matrix[r * M];
+        ids[r] = r;
+    }
+
+    GeFixedStep<T, N, M> steps = {rows, ids, perm};
+    GeUnroll<0, N>::run(steps);
+}
+
+#endif
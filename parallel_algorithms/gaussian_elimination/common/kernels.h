@@ -0,0 +1,254 @@
+// This file contains the row kernels used by every version of the
+// Gaussian Elimination algorithm, with explicit SSE, AVX2, and AVX-512
+// versions selected at startup from CPUID
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_KERNELS_H
+#define GE_KERNELS_H
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GE_X86 1
+#include <immintrin.h>
+#endif
+
+// Subtracts a scaled row from another row (dst[k] -= src[k] * scale)
+typedef void (*ge_eliminate_fn)(float *dst, const float *src, float scale,
+        int n);
+
+// Subtracts four scaled rows from another row, in order
+// (dst[k] -= src[0][k] * scale[0], then src[1][k] * scale[1], ...)
+typedef void (*ge_eliminate4_fn)(float *dst, const float **src,
+        const float *scale, int n);
+
+// Multiplies a row by a scalar (row[k] *= scale)
+typedef void (*ge_scale_fn)(float *row, float scale, int n);
+
+// The kernel family picked for this CPU
+struct GeKernels {
+    // Name of the instruction set used
+    const char *name;
+    ge_eliminate_fn eliminate;
+    ge_eliminate4_fn eliminate4;
+    ge_scale_fn scale;
+};
+
+// Scalar fallback kernels
+void eliminate_scalar(float *dst, const float *src, float scale, int n){
+    for(int k = 0; k < n; k++){
+        dst[k] -= src[k] * scale;
+    }
+}
+
+void eliminate4_scalar(float *dst, const float **src, const float *scale,
+        int n){
+    for(int k = 0; k < n; k++){
+        float v = dst[k];
+        v -= src[0][k] * scale[0];
+        v -= src[1][k] * scale[1];
+        v -= src[2][k] * scale[2];
+        v -= src[3][k] * scale[3];
+        dst[k] = v;
+    }
+}
+
+void scale_scalar(float *row, float scale, int n){
+    for(int k = 0; k < n; k++){
+        row[k] *= scale;
+    }
+}
+
+// The scalar kernels as a family (they multiply then subtract, like any
+// plain loop compiled without FMA)
+const GeKernels ge_scalar_kernels = {"scalar", eliminate_scalar,
+    eliminate4_scalar, scale_scalar};
+
+#ifdef GE_X86
+// SSE kernels (no FMA, so multiply then subtract)
+__attribute__((target("sse2")))
+void eliminate_sse(float *dst, const float *src, float scale, int n){
+    __m128 s = _mm_set1_ps(scale);
+    int k = 0;
+    for(; k + 4 <= n; k += 4){
+        __m128 v = _mm_loadu_ps(&dst[k]);
+        v = _mm_sub_ps(v, _mm_mul_ps(_mm_loadu_ps(&src[k]), s));
+        _mm_storeu_ps(&dst[k], v);
+    }
+    eliminate_scalar(&dst[k], &src[k], scale, n - k);
+}
+
+__attribute__((target("sse2")))
+void eliminate4_sse(float *dst, const float **src, const float *scale,
+        int n){
+    __m128 s0 = _mm_set1_ps(scale[0]);
+    __m128 s1 = _mm_set1_ps(scale[1]);
+    __m128 s2 = _mm_set1_ps(scale[2]);
+    __m128 s3 = _mm_set1_ps(scale[3]);
+    int k = 0;
+    for(; k + 4 <= n; k += 4){
+        __m128 v = _mm_loadu_ps(&dst[k]);
+        v = _mm_sub_ps(v, _mm_mul_ps(_mm_loadu_ps(&src[0][k]), s0));
+        v = _mm_sub_ps(v, _mm_mul_ps(_mm_loadu_ps(&src[1][k]), s1));
+        v = _mm_sub_ps(v, _mm_mul_ps(_mm_loadu_ps(&src[2][k]), s2));
+        v = _mm_sub_ps(v, _mm_mul_ps(_mm_loadu_ps(&src[3][k]), s3));
+        _mm_storeu_ps(&dst[k], v);
+    }
+    const float *tail[4] = {&src[0][k], &src[1][k], &src[2][k], &src[3][k]};
+    eliminate4_scalar(&dst[k], tail, scale, n - k);
+}
+
+__attribute__((target("sse2")))
+void scale_sse(float *row, float scale, int n){
+    __m128 s = _mm_set1_ps(scale);
+    int k = 0;
+    for(; k + 4 <= n; k += 4){
+        _mm_storeu_ps(&row[k], _mm_mul_ps(_mm_loadu_ps(&row[k]), s));
+    }
+    scale_scalar(&row[k], scale, n - k);
+}
+
+// AVX2 kernels (fused negative multiply-add)
+__attribute__((target("avx2,fma")))
+void eliminate_avx2(float *dst, const float *src, float scale, int n){
+    __m256 s = _mm256_set1_ps(scale);
+    int k = 0;
+    for(; k + 8 <= n; k += 8){
+        __m256 v = _mm256_loadu_ps(&dst[k]);
+        v = _mm256_fnmadd_ps(_mm256_loadu_ps(&src[k]), s, v);
+        _mm256_storeu_ps(&dst[k], v);
+    }
+    eliminate_scalar(&dst[k], &src[k], scale, n - k);
+}
+
+__attribute__((target("avx2,fma")))
+void eliminate4_avx2(float *dst, const float **src, const float *scale,
+        int n){
+    __m256 s0 = _mm256_set1_ps(scale[0]);
+    __m256 s1 = _mm256_set1_ps(scale[1]);
+    __m256 s2 = _mm256_set1_ps(scale[2]);
+    __m256 s3 = _mm256_set1_ps(scale[3]);
+    int k = 0;
+    for(; k + 8 <= n; k += 8){
+        __m256 v = _mm256_loadu_ps(&dst[k]);
+        v = _mm256_fnmadd_ps(_mm256_loadu_ps(&src[0][k]), s0, v);
+        v = _mm256_fnmadd_ps(_mm256_loadu_ps(&src[1][k]), s1, v);
+        v = _mm256_fnmadd_ps(_mm256_loadu_ps(&src[2][k]), s2, v);
+        v = _mm256_fnmadd_ps(_mm256_loadu_ps(&src[3][k]), s3, v);
+        _mm256_storeu_ps(&dst[k], v);
+    }
+    const float *tail[4] = {&src[0][k], &src[1][k], &src[2][k], &src[3][k]};
+    eliminate4_scalar(&dst[k], tail, scale, n - k);
+}
+
+__attribute__((target("avx2,fma")))
+void scale_avx2(float *row, float scale, int n){
+    __m256 s = _mm256_set1_ps(scale);
+    int k = 0;
+    for(; k + 8 <= n; k += 8){
+        _mm256_storeu_ps(&row[k], _mm256_mul_ps(_mm256_loadu_ps(&row[k]), s));
+    }
+    scale_scalar(&row[k], scale, n - k);
+}
+
+// AVX-512 kernels (masked loads and stores handle the tail)
+__attribute__((target("avx512f")))
+void eliminate_avx512(float *dst, const float *src, float scale, int n){
+    __m512 s = _mm512_set1_ps(scale);
+    for(int k = 0; k < n; k += 16){
+        __mmask16 m = (n - k >= 16) ? 0xFFFF : (__mmask16)((1u << (n - k)) - 1);
+        __m512 v = _mm512_maskz_loadu_ps(m, &dst[k]);
+        v = _mm512_fnmadd_ps(_mm512_maskz_loadu_ps(m, &src[k]), s, v);
+        _mm512_mask_storeu_ps(&dst[k], m, v);
+    }
+}
+
+__attribute__((target("avx512f")))
+void eliminate4_avx512(float *dst, const float **src, const float *scale,
+        int n){
+    __m512 s0 = _mm512_set1_ps(scale[0]);
+    __m512 s1 = _mm512_set1_ps(scale[1]);
+    __m512 s2 = _mm512_set1_ps(scale[2]);
+    __m512 s3 = _mm512_set1_ps(scale[3]);
+    for(int k = 0; k < n; k += 16){
+        __mmask16 m = (n - k >= 16) ? 0xFFFF : (__mmask16)((1u << (n - k)) - 1);
+        __m512 v = _mm512_maskz_loadu_ps(m, &dst[k]);
+        v = _mm512_fnmadd_ps(_mm512_maskz_loadu_ps(m, &src[0][k]), s0, v);
+        v = _mm512_fnmadd_ps(_mm512_maskz_loadu_ps(m, &src[1][k]), s1, v);
+        v = _mm512_fnmadd_ps(_mm512_maskz_loadu_ps(m, &src[2][k]), s2, v);
+        v = _mm512_fnmadd_ps(_mm512_maskz_loadu_ps(m, &src[3][k]), s3, v);
+        _mm512_mask_storeu_ps(&dst[k], m, v);
+    }
+}
+
+__attribute__((target("avx512f")))
+void scale_avx512(float *row, float scale, int n){
+    __m512 s = _mm512_set1_ps(scale);
+    for(int k = 0; k < n; k += 16){
+        __mmask16 m = (n - k >= 16) ? 0xFFFF : (__mmask16)((1u << (n - k)) - 1);
+        __m512 v = _mm512_maskz_loadu_ps(m, &row[k]);
+        _mm512_mask_storeu_ps(&row[k], m, _mm512_mul_ps(v, s));
+    }
+}
+#endif
+
+// Picks the widest kernel family this CPU supports
+GeKernels ge_select_kernels(){
+#ifdef GE_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")){
+        return {"avx512", eliminate_avx512, eliminate4_avx512, scale_avx512};
+    }
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")){
+        return {"avx2", eliminate_avx2, eliminate4_avx2, scale_avx2};
+    }
+    if(__builtin_cpu_supports("sse2")){
+        return {"sse", eliminate_sse, eliminate4_sse, scale_sse};
+    }
+#endif
+    return ge_scalar_kernels;
+}
+
+// Kernels chosen once at startup
+GeKernels ge_kernels = ge_select_kernels();
+
+// Row kernels for any element type (double and complex numbers use
+// plain loops, float uses the kernels picked for this CPU)
+template <typename T>
+void ge_eliminate(T *dst, const T *src, T scale, int n){
+    for(int k = 0; k < n; k++){
+        dst[k] -= scale * src[k];
+    }
+}
+
+template <typename T>
+void ge_eliminate4(T *dst, const T **src, const T *scale, int n){
+    for(int k = 0; k < n; k++){
+        T v = dst[k];
+        v -= scale[0] * src[0][k];
+        v -= scale[1] * src[1][k];
+        v -= scale[2] * src[2][k];
+        v -= scale[3] * src[3][k];
+        dst[k] = v;
+    }
+}
+
+template <typename T>
+void ge_scale(T *row, T scale, int n){
+    for(int k = 0; k < n; k++){
+        row[k] *= scale;
+    }
+}
+
+inline void ge_eliminate(float *dst, const float *src, float scale, int n){
+    ge_kernels.eliminate(dst, src, scale, n);
+}
+
+inline void ge_eliminate4(float *dst, const float **src, const float *scale,
+        int n){
+    ge_kernels.eliminate4(dst, src, scale, n);
+}
+
+inline void ge_scale(float *row, float scale, int n){
+    ge_kernels.scale(row, scale, n);
+}
+
+#endif
@@ -0,0 +1,259 @@
+// This file contains the barrier-free lookahead pipeline used by the
+// pthread versions of Gaussian Elimination
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_LOOKAHEAD_H
+#define GE_LOOKAHEAD_H
+
+#include <atomic>
+#include <sched.h>
+#include "blocked.h"
+
+// Pivot candidate offered by one thread
+// Padded to a cache line so threads do not share one when writing
+struct alignas(64) Candidate {
+    GePivot pivot;
+};
+
+// Pivot candidate of the lookahead pipeline, for any element type (the
+// magnitudes of float and double elements fit in a double exactly)
+struct alignas(64) GeSlot {
+    GeBasicPivot<double> pivot;
+};
+
+// State shared by all threads of the lookahead pipeline
+// Instead of barriers, threads publish two sequence counters:
+// - offered: how many pivot candidates have been posted in total, so
+//   step i has every candidate once offered reaches (i + 1) * threads
+// - ready: how many pivot rows have been normalized, so pivot row i
+//   can be used as soon as ready passes i
+struct GeLookahead {
+    int num_threads;
+    // Leave the multipliers and pivots in place (packed LU)
+    bool keep_lu;
+    alignas(64) std::atomic<int> offered;
+    alignas(64) std::atomic<int> ready;
+    // Candidates of two consecutive steps (step i uses slots i % 2)
+    GeSlot *slots;
+};
+
+// Rewinds the shared state for another matrix (no thread may still be
+// using it)
+// Takes the state and the packed LU flag as arguments
+void ge_lookahead_reset(GeLookahead *la, bool keep_lu = false){
+    la->keep_lu = keep_lu;
+    la->offered.store(0);
+    la->ready.store(0);
+}
+
+// Sets up the shared state for a number of threads
+// Takes the state, the number of threads, and the packed LU flag as
+// arguments
+void ge_lookahead_init(GeLookahead *la, int num_threads,
+        bool keep_lu = false){
+    la->num_threads = num_threads;
+    la->slots = ge_aligned_new<GeSlot>(2 * num_threads);
+    ge_lookahead_reset(la, keep_lu);
+}
+
+// Frees the shared state
+void ge_lookahead_destroy(GeLookahead *la){
+    ge_aligned_delete(la->slots, 2 * la->num_threads);
+}
+
+// Trailing update of the previous panel that a thread has not done yet
+// Only the columns of the next panel are updated right away, the rest
+// is done in small chunks whenever the thread would otherwise wait
+template <typename T>
+struct GeDeferred {
+    // Previous panel, and its pivot rows
+    int k0;
+    int k1;
+    const T **u_rows;
+    // Columns that still need the update
+    int col_begin;
+    int col_end;
+    // Which rows of this thread still need it (by list position)
+    bool *pending;
+    // Every row in [done, cursor) of the list is already up to date
+    int cursor;
+    // Keep the multipliers once they are applied (packed LU)
+    bool keep_lu;
+};
+
+// Number of rows updated per chunk of deferred work
+const int GE_DEFERRED_CHUNK = 4;
+
+// Applies the deferred update to one chunk of rows
+// Takes the deferred work, the row list of this thread, and its length
+// as arguments
+// Returns false when there was nothing left to do
+template <typename T>
+bool ge_deferred_chunk(GeDeferred<T> *d, T **rows, int num_rows){
+    T *chunk[GE_DEFERRED_CHUNK];
+    int count = 0;
+    while((d->cursor < num_rows) && (count < GE_DEFERRED_CHUNK)){
+        if(d->pending[d->cursor]){
+            chunk[count++] = rows[d->cursor];
+            d->pending[d->cursor] = false;
+        }
+        d->cursor++;
+    }
+    if(count == 0){
+        return false;
+    }
+
+    // The multipliers of the previous panel are no longer needed after
+    ge_trailing_update(chunk, count, d->u_rows, d->k0, d->k1, d->col_begin,
+            d->col_end);
+    if(!d->keep_lu){
+        ge_clear_multipliers(chunk, count, d->k0, d->k1);
+    }
+    return true;
+}
+
+// Waits for a counter to reach a target, doing deferred work meanwhile
+// Takes the counter, the target, the deferred work, the row list of
+// this thread, and its length as arguments
+template <typename T>
+void ge_wait_for(std::atomic<int> *counter, int target, GeDeferred<T> *d,
+        T **rows, int num_rows){
+    while(counter->load(std::memory_order_acquire) < target){
+        // Give up the core if there is nothing useful to do
+        if(!ge_deferred_chunk(d, rows, num_rows)){
+            sched_yield();
+        }
+    }
+}
+
+// Lookahead Gaussian Elimination for one thread
+// No barriers are used: a thread uses pivot i as soon as its row is
+// published, and always searches for the next pivot before doing any
+// other work so the critical path is never delayed. The trailing update
+// of a panel only updates the next panel's columns right away, the rest
+// overlaps with the factorization of the next panel
+// Takes the shared state, the matrix, its number of rows, the length
+// of each row (N, or more for an augmented matrix), the panel size, the
+// permutation vector, the thread ID, the row list of this thread
+// (pointers and matrix row numbers), and the distance between rows (0 if
+// rows are packed) as arguments
+template <typename T>
+void ge_lookahead(GeLookahead *la, T *matrix, int N, int ncols,
+        int block_size, int *perm, int tid, T **rows, int *ids,
+        int num_rows, int ld = 0){
+    if(ld == 0){
+        ld = ncols;
+    }
+
+    int num_threads = la->num_threads;
+
+    // Pivot rows of the current and previous panels
+    const T **u_rows = new const T*[block_size];
+    const T **u_prev = new const T*[block_size];
+
+    // No deferred work before the first panel
+    GeDeferred<T> deferred;
+    deferred.k0 = 0;
+    deferred.k1 = 0;
+    deferred.u_rows = u_prev;
+    deferred.col_begin = ncols;
+    deferred.col_end = ncols;
+    deferred.pending = new bool[num_rows];
+    deferred.cursor = num_rows;
+    deferred.keep_lu = la->keep_lu;
+    for(int r = 0; r < num_rows; r++){
+        deferred.pending[r] = false;
+    }
+
+    // Rows [0, done) of the list are pivots, [done, num_rows) remain
+    int done = 0;
+
+    for(int k0 = 0; k0 < N; k0 += block_size){
+        int k1 = std::min(k0 + block_size, N);
+
+        for(int i = k0; i < k1; i++){
+            // Offer the best remaining row of this thread as the pivot
+            int pos;
+            GeSlot *slots = &la->slots[(i % 2) * num_threads];
+            GeBasicPivot<typename GeReal<T>::type> mine = ge_find_pivot(
+                    &rows[done], &ids[done], num_rows - done, i, &pos);
+            slots[tid].pivot.value = mine.value;
+            slots[tid].pivot.row = mine.row;
+            la->offered.fetch_add(1, std::memory_order_release);
+
+            // Wait for every candidate of this step
+            ge_wait_for(&la->offered, (i + 1) * num_threads, &deferred,
+                    rows, num_rows);
+
+            // Every thread combines the candidates the same way
+            GeBasicPivot<double> best = slots[0].pivot;
+            for(int t = 1; t < num_threads; t++){
+                if(ge_better_pivot(slots[t].pivot, best)){
+                    best = slots[t].pivot;
+                }
+            }
+
+            if((pos >= 0) && (ids[done + pos] == best.row)){
+                // The owner moves the row to its pivots, finishes any
+                // deferred work on it, then updates and normalizes it
+                ge_swap_rows(rows, ids, done, done + pos);
+                std::swap(deferred.pending[done],
+                        deferred.pending[done + pos]);
+                if(deferred.pending[done]){
+                    ge_trailing_update(&rows[done], 1, u_prev, deferred.k0,
+                            deferred.k1, deferred.col_begin,
+                            deferred.col_end);
+                    if(!la->keep_lu){
+                        ge_clear_multipliers(&rows[done], 1, deferred.k0,
+                                deferred.k1);
+                    }
+                    deferred.pending[done] = false;
+                }
+                ge_factor_pivot_row(rows[done], u_rows, k0, k1, i, ncols,
+                        la->keep_lu);
+                perm[i] = best.row;
+                done++;
+                deferred.cursor = std::max(deferred.cursor, done);
+
+                // Publish the pivot row
+                la->ready.store(i + 1, std::memory_order_release);
+            }else{
+                // Wait for the pivot row to be published
+                ge_wait_for(&la->ready, i + 1, &deferred, rows, num_rows);
+            }
+            u_rows[i - k0] = &matrix[(size_t)best.row * ld];
+
+            // Eliminate the ith element from the panel columns of the
+            // remaining rows of this thread
+            ge_panel_update(&rows[done], num_rows - done, u_rows[i - k0], i,
+                    k1);
+        }
+
+        // The previous panel must be fully applied before this one
+        while(ge_deferred_chunk(&deferred, rows, num_rows));
+
+        // Update the columns of the next panel first, and defer the rest
+        int k2 = std::min(k1 + block_size, N);
+        ge_trailing_update(&rows[done], num_rows - done, u_rows, k0, k1, k1,
+                k2);
+        std::swap(u_rows, u_prev);
+        deferred.k0 = k0;
+        deferred.k1 = k1;
+        deferred.u_rows = u_prev;
+        deferred.col_begin = k2;
+        deferred.col_end = ncols;
+        deferred.cursor = done;
+        for(int r = done; r < num_rows; r++){
+            deferred.pending[r] = true;
+        }
+    }
+
+    // Finish the trailing update of the last panel
+    while(ge_deferred_chunk(&deferred, rows, num_rows));
+
+    delete[] u_rows;
+    delete[] u_prev;
+    delete[] deferred.pending;
+}
+
+#endif
@@ -0,0 +1,219 @@
+// This file contains a factor-once, solve-many handle for Gaussian
+// Elimination. The matrix is factored once into a packed LU (Crout
+// form: L with the pivots on its diagonal, U with an implicit unit
+// diagonal), and each later solve only costs O(N^2)
+// The factorization is done serially or by threads running the
+// lookahead pipeline, for float or double elements
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_LU_H
+#define GE_LU_H
+
+#include <pthread.h>
+#include <cstring>
+#include "blocked.h"
+#include "lookahead.h"
+#include "affinity.h"
+
+// Packed LU factorization of an n x n matrix with partial pivoting
+// Row perm[i] of lu holds row i of L (columns [0, i]) and of U
+// (columns (i, n)), so PA = LU where row i of PA is row perm[i] of A
+// The handle is only read by solves, so any number of threads may
+// solve against it at the same time
+template <typename T>
+struct GeBasicFactorization {
+    int n;
+    T *lu;
+    int *perm;
+    // Pivot rows in order (rows[i] is row perm[i] of lu)
+    T **rows;
+};
+
+// Factorization of a float matrix
+typedef GeBasicFactorization<float> GeFactorization;
+
+// Allocates a handle for an n x n matrix
+// Takes the handle and the dimension as arguments
+template <typename T>
+void ge_factorization_init(GeBasicFactorization<T> *f, int n){
+    f->n = n;
+    f->lu = new T[(size_t)n * n];
+    f->perm = new int[n];
+    f->rows = new T*[n];
+}
+
+// Lists the pivot rows once the permutation is known
+// Takes the handle as an argument
+template <typename T>
+void ge_factorization_rows(GeBasicFactorization<T> *f){
+    for(int i = 0; i < f->n; i++){
+        f->rows[i] = &f->lu[(size_t)f->perm[i] * f->n];
+    }
+}
+
+// Frees a handle (an empty, zero-initialized handle is fine too)
+template <typename T>
+void ge_factorization_destroy(GeBasicFactorization<T> *f){
+    delete[] f->lu;
+    delete[] f->perm;
+    delete[] f->rows;
+    f->lu = NULL;
+    f->perm = NULL;
+    f->rows = NULL;
+}
+
+// Factors a matrix into a handle (A is left unchanged)
+// Takes the handle, the matrix, its dimension, and the number of pivots
+// per panel as arguments
+template <typename T>
+void ge_factor(GeBasicFactorization<T> *f, const T *A, int n,
+        int block_size = GE_BLOCK_SIZE){
+    ge_factorization_init(f, n);
+    memcpy(f->lu, A, (size_t)n * n * sizeof(T));
+    ge_blocked(f->lu, n, n, f->perm, block_size, true);
+    ge_factorization_rows(f);
+}
+
+// Arguments of one thread of a threaded factorization
+template <typename T, typename S>
+struct GeFactorArgs {
+    // Thread ID
+    int tid;
+    // Number of threads launched
+    int num_threads;
+    // Handle to factor into, and the matrix it comes from (converted to
+    // the element type of the handle)
+    GeBasicFactorization<T> *f;
+    const S *A;
+    // Number of pivots per blocked panel
+    int block_size;
+    // Counters used by the lookahead pipeline
+    GeLookahead *la;
+};
+
+// Pthread function for the packed LU factorization
+// Takes a pointer to a struct of args as an argument
+template <typename T, typename S>
+void *ge_factor_rows(void *args){
+    // Cast void pointer to struct pointer
+    GeFactorArgs<T, S> *local_args = (GeFactorArgs<T, S>*)args;
+
+    // Unpack the arguments
+    int tid = local_args->tid;
+    int num_threads = local_args->num_threads;
+    GeBasicFactorization<T> *f = local_args->f;
+    int n = f->n;
+
+    // Cyclic striped mapping of the rows to the threads
+    int num_rows = (n - tid + num_threads - 1) / num_threads;
+    T **rows = new T*[num_rows];
+    int *ids = new int[num_rows];
+    for(int j = 0; j < num_rows; j++){
+        ids[j] = j * num_threads + tid;
+        rows[j] = &f->lu[(size_t)ids[j] * n];
+
+        // Copy our own rows (this also places their pages near this
+        // thread)
+        const S *source = &local_args->A[(size_t)ids[j] * n];
+        for(int k = 0; k < n; k++){
+            rows[j][k] = (T)source[k];
+        }
+    }
+
+    // Eliminate without clearing the multipliers
+    ge_lookahead(local_args->la, f->lu, n, n, local_args->block_size,
+            f->perm, tid, rows, ids, num_rows);
+
+    // Free heap-allocated memory
+    delete[] rows;
+    delete[] ids;
+
+    return 0;
+}
+
+// Factors a matrix into a handle with threads (A is left unchanged)
+// Takes the handle, the matrix (of the same or a wider element type),
+// its dimension, the number of threads, and the number of pivots per
+// panel as arguments
+template <typename T, typename S>
+void ge_parallel_factor(GeBasicFactorization<T> *f, const S *A, int n,
+        int num_threads, int block_size = GE_BLOCK_SIZE){
+    ge_factorization_init(f, n);
+
+    // Create array of thread objects we will launch
+    pthread_t *threads = new pthread_t[num_threads];
+    GeFactorArgs<T, S> *thread_args = new GeFactorArgs<T, S>[num_threads];
+
+    // Create the counters used by the lookahead pipeline
+    GeLookahead la;
+    ge_lookahead_init(&la, num_threads, true);
+
+    // Launch threads
+    for(int i = 0; i < num_threads; i++){
+        thread_args[i].tid = i;
+        thread_args[i].num_threads = num_threads;
+        thread_args[i].f = f;
+        thread_args[i].A = A;
+        thread_args[i].block_size = block_size;
+        thread_args[i].la = &la;
+        start_thread(&threads[i], ge_factor_rows<T, S>,
+                (void*)&thread_args[i]);
+    }
+
+    for(int i = 0; i < num_threads; i++){
+        pthread_join(threads[i], NULL);
+    }
+    ge_factorization_rows(f);
+
+    // Free heap-allocated memory
+    ge_lookahead_destroy(&la);
+    delete[] threads;
+    delete[] thread_args;
+}
+
+// Solves AX = B with a factorization, for nrhs right-hand sides
+// Only X is written (it must not overlap B)
+// Takes the handle, B (n x nrhs), X (n x nrhs), and the number of
+// right-hand sides as arguments
+template <typename T>
+void ge_lu_solve(const GeBasicFactorization<T> *f, const T *B, T *X,
+        int nrhs = 1){
+    int n = f->n;
+    T **rows = f->rows;
+
+    // Forward substitution, Ly = Pb (each row of L ends in its pivot)
+    for(int i = 0; i < n; i++){
+        T *x = &X[(size_t)i * nrhs];
+        memcpy(x, &B[(size_t)f->perm[i] * nrhs], nrhs * sizeof(T));
+        if(nrhs == 1){
+            T sum = x[0];
+            for(int j = 0; j < i; j++){
+                sum -= rows[i][j] * X[j];
+            }
+            x[0] = sum / rows[i][i];
+        }else{
+            for(int j = 0; j < i; j++){
+                ge_eliminate(x, &X[(size_t)j * nrhs], rows[i][j], nrhs);
+            }
+            ge_scale(x, (T)1 / rows[i][i], nrhs);
+        }
+    }
+
+    // Back substitution, Ux = y (U has a unit diagonal)
+    for(int i = n - 1; i >= 0; i--){
+        T *x = &X[(size_t)i * nrhs];
+        if(nrhs == 1){
+            T sum = x[0];
+            for(int j = i + 1; j < n; j++){
+                sum -= rows[i][j] * X[j];
+            }
+            x[0] = sum;
+        }else{
+            for(int j = i + 1; j < n; j++){
+                ge_eliminate(x, &X[(size_t)j * nrhs], rows[i][j], nrhs);
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,99 @@
+// This file contains the row mapping policies for the parallel
+// Gaussian Elimination. A policy decides which rows each thread owns,
+// and is a template parameter so each thread builds its row list
+// directly, without testing every row of the matrix
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_MAPPING_H
+#define GE_MAPPING_H
+
+#include <algorithm>
+
+// Each thread owns one contiguous run of rows (the first N % p threads
+// get one extra row)
+struct BlockMapping {
+    // Number of rows owned by a thread
+    // Takes the dimension, the number of threads, and the thread ID as
+    // arguments
+    int num_rows(int N, int p, int tid) const {
+        return N / p + (tid < N % p ? 1 : 0);
+    }
+
+    // Matrix row of the jth row owned by a thread
+    int row(int j, int N, int p, int tid) const {
+        return tid * (N / p) + std::min(tid, N % p) + j;
+    }
+
+    // Thread that owns a matrix row
+    int owner(int row, int N, int p) const {
+        int extra = (N % p) * (N / p + 1);
+        return (row < extra) ? row / (N / p + 1) :
+            N % p + (row - extra) / (N / p);
+    }
+};
+
+// Rows are dealt to the threads one at a time, round robin
+struct CyclicMapping {
+    int num_rows(int N, int p, int tid) const {
+        return (N - tid + p - 1) / p;
+    }
+
+    int row(int j, int /*N*/, int p, int tid) const {
+        return j * p + tid;
+    }
+
+    int owner(int row, int /*N*/, int p) const {
+        return row % p;
+    }
+
+    // Position of a matrix row in its owner's row list
+    int local(int row, int p) const {
+        return row / p;
+    }
+};
+
+// Blocks of rows_per_block rows are dealt to the threads round robin
+// (1 is the cyclic mapping, and N / p is close to the block mapping)
+struct BlockCyclicMapping {
+    int rows_per_block;
+
+    int num_rows(int N, int p, int tid) const {
+        int full_blocks = N / rows_per_block;
+        int last = N % rows_per_block;
+        return ((full_blocks - tid + p - 1) / p) * rows_per_block +
+            ((full_blocks % p == tid) ? last : 0);
+    }
+
+    int row(int j, int /*N*/, int p, int tid) const {
+        return ((j / rows_per_block) * p + tid) * rows_per_block +
+            j % rows_per_block;
+    }
+
+    int owner(int row, int /*N*/, int p) const {
+        return (row / rows_per_block) % p;
+    }
+
+    // Position of a matrix row in its owner's row list
+    int local(int row, int p) const {
+        return (row / rows_per_block / p) * rows_per_block +
+            row % rows_per_block;
+    }
+};
+
+// Builds the row list of a thread under a mapping
+// Takes the mapping, the matrix, its dimension, the number of threads,
+// the thread ID, the row pointers and row numbers to fill, and the
+// distance between rows (0 if rows are packed) as arguments
+// Returns the number of rows owned by the thread
+template <typename Mapping>
+int map_rows(const Mapping &mapping, float *matrix, int N, int p, int tid,
+        float **rows, int *ids, int ld = 0){
+    int num_rows = mapping.num_rows(N, p, tid);
+    for(int j = 0; j < num_rows; j++){
+        ids[j] = mapping.row(j, N, p, tid);
+        rows[j] = &matrix[(size_t)ids[j] * (ld ? ld : N)];
+    }
+    return num_rows;
+}
+
+#endif
@@ -0,0 +1,177 @@
+// This file contains a row permutation for sparse elimination without
+// row pivoting: a maximum product matching (as in MC64 by Duff and
+// Koster) puts large entries on the diagonal, so matrices with zeros or
+// tiny values there can still be factored with diagonal pivots
+// Each column is matched by a shortest augmenting path (Dijkstra on
+// costs kept nonnegative by dual variables)
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_MATCHING_H
+#define GE_MATCHING_H
+
+#include <cmath>
+#include <vector>
+#include <queue>
+#include <functional>
+#include <utility>
+#include <algorithm>
+
+// Matches every column of a sparse matrix to a row, so the product of
+// the magnitudes of the matched entries is as large as possible
+// Entry (i, j) costs log(largest |a(:, j)|) - log|a(i, j)|, and the
+// matching of least total cost is found one column at a time
+// Columns that cannot be matched (the matrix is structurally singular)
+// get the rows left over
+// Takes the dimension, the column starts, row indices, and values of
+// the matrix (CSC), and the row of each column to fill in as arguments
+// Returns the number of columns matched by nonzero entries
+int ge_max_matching(int n, const int *ptr, const int *idx, const float *val,
+        int *row_of_col){
+    // Costs of the entries (zeros are not edges), and the smallest one of
+    // each column
+    std::vector<double> cost(ptr[n]);
+    std::vector<double> v(n, INFINITY);
+    for(int j = 0; j < n; j++){
+        double largest = 0;
+        for(int e = ptr[j]; e < ptr[j + 1]; e++){
+            largest = std::max(largest, (double)std::fabs(val[e]));
+        }
+        for(int e = ptr[j]; e < ptr[j + 1]; e++){
+            double a = std::fabs(val[e]);
+            cost[e] = (a > 0) ? std::log(largest) - std::log(a) : INFINITY;
+            v[j] = std::min(v[j], cost[e]);
+        }
+    }
+
+    // Dual variables of the rows and columns (cost - u - v is never
+    // negative, and is zero on matched entries)
+    std::vector<double> u(n, 0);
+    std::vector<int> col_of_row(n, -1);
+    for(int j = 0; j < n; j++){
+        row_of_col[j] = -1;
+    }
+
+    // Cheap start: match columns to free rows with zero reduced cost
+    int matched = 0;
+    for(int j = 0; j < n; j++){
+        for(int e = ptr[j]; e < ptr[j + 1]; e++){
+            int i = idx[e];
+            if((cost[e] == v[j]) && (cost[e] < INFINITY) &&
+                    (col_of_row[i] == -1)){
+                row_of_col[j] = i;
+                col_of_row[i] = j;
+                matched++;
+                break;
+            }
+        }
+    }
+
+    // Distance to each row, the column it was reached from, and the rows
+    // reached by the current search
+    std::vector<double> dist(n, INFINITY);
+    std::vector<double> col_dist(n, 0);
+    std::vector<int> pred(n, -1);
+    std::vector<char> done(n, 0);
+    std::vector<int> touched;
+    std::vector<int> finished;
+    std::vector<int> scanned;
+    typedef std::pair<double, int> Item;
+
+    for(int j0 = 0; j0 < n; j0++){
+        if(row_of_col[j0] != -1){
+            continue;
+        }
+
+        // Shortest path from column j0 to a free row, going back along
+        // matched entries (which cost nothing)
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item> >
+            heap;
+        int free_row = -1;
+        double shortest = 0;
+        int j = j0;
+        col_dist[j] = 0;
+        scanned.push_back(j);
+        while(true){
+            for(int e = ptr[j]; e < ptr[j + 1]; e++){
+                int i = idx[e];
+                double d = col_dist[j] + cost[e] - u[i] - v[j];
+                if(!done[i] && (d < dist[i])){
+                    if(dist[i] == INFINITY){
+                        touched.push_back(i);
+                    }
+                    dist[i] = d;
+                    pred[i] = j;
+                    heap.push({d, i});
+                }
+            }
+
+            // Closest row not finished yet
+            int i = -1;
+            while(!heap.empty()){
+                Item top = heap.top();
+                heap.pop();
+                if(!done[top.second] && (top.first == dist[top.second])){
+                    i = top.second;
+                    break;
+                }
+            }
+            if(i == -1){
+                break;
+            }
+            done[i] = 1;
+            finished.push_back(i);
+            if(col_of_row[i] == -1){
+                free_row = i;
+                shortest = dist[i];
+                break;
+            }
+            j = col_of_row[i];
+            col_dist[j] = dist[i];
+            scanned.push_back(j);
+        }
+
+        if(free_row != -1){
+            // Keep the reduced costs nonnegative, and zero along the path
+            for(size_t t = 0; t < finished.size(); t++){
+                u[finished[t]] += dist[finished[t]] - shortest;
+            }
+            for(size_t t = 0; t < scanned.size(); t++){
+                v[scanned[t]] += shortest - col_dist[scanned[t]];
+            }
+
+            // Flip the path
+            for(int i = free_row; i != -1;){
+                int jp = pred[i];
+                int next = row_of_col[jp];
+                row_of_col[jp] = i;
+                col_of_row[i] = jp;
+                i = (jp == j0) ? -1 : next;
+            }
+            matched++;
+        }
+
+        // Reset what this search touched
+        for(size_t t = 0; t < touched.size(); t++){
+            dist[touched[t]] = INFINITY;
+            done[touched[t]] = 0;
+        }
+        touched.clear();
+        finished.clear();
+        scanned.clear();
+    }
+
+    // Rows left over go to the columns that could not be matched
+    int next_row = 0;
+    for(int j = 0; j < n; j++){
+        if(row_of_col[j] == -1){
+            while(col_of_row[next_row] != -1){
+                next_row++;
+            }
+            row_of_col[j] = next_row;
+            col_of_row[next_row] = j;
+        }
+    }
+    return matched;
+}
+
+#endif
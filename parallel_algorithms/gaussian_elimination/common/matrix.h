@@ -0,0 +1,168 @@
+// This file contains the matrix container used by the pthread versions
+// of Gaussian Elimination. Rows start on cache lines, the row stride can
+// be padded so that rows do not fall into the same cache sets, and the
+// storage can be backed by huge pages (Linux only)
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_MATRIX_H
+#define GE_MATRIX_H
+
+#include <sys/mman.h>
+#include <stdint.h>
+#include <cstddef>
+#include "bench.h"
+
+// Size of a cache line and of a huge page
+const size_t GE_CACHE_LINE = 64;
+const size_t GE_HUGE_PAGE = 2 << 20;
+
+// What kind of pages back a matrix
+enum GePages {
+    // Regular pages
+    GE_PAGES_SMALL,
+    // Transparent huge pages (the mapping is 2 MB aligned and marked
+    // with MADV_HUGEPAGE). Each page lands on the node of the first
+    // thread to touch it, so rows of different threads that share a page
+    // share a node
+    GE_PAGES_TRANSPARENT,
+    // Huge pages from the hugetlb pool (MAP_HUGETLB), with transparent
+    // ones if the pool is empty
+    GE_PAGES_EXPLICIT
+};
+
+// How a matrix is laid out in memory
+struct GeLayout {
+    // Pad the row stride
+    bool pad;
+    GePages pages;
+};
+
+template <typename T>
+struct GeMatrix {
+    // First element, and the number of rows and columns
+    T *data;
+    int rows;
+    int cols;
+    // Elements from the start of one row to the next
+    int ld;
+    // Pages the matrix ended up on
+    GePages pages;
+    // The mapping holding the matrix
+    void *base;
+    size_t mapped;
+};
+
+// Picks the row stride of a matrix
+// Rows are rounded up to whole cache lines. A stride that is a multiple
+// of 512 bytes maps every row (or every other row) to the same cache
+// sets, and at 4 KB multiples loads and stores of different rows alias,
+// so one more cache line is added
+// Takes the number of columns, the element size, and whether to pad as
+// arguments
+// Returns the stride in elements
+int ge_leading_dim(int cols, size_t element_size, bool pad){
+    if(!pad){
+        return cols;
+    }
+    int per_line = (int)(GE_CACHE_LINE / element_size);
+    int ld = (cols + per_line - 1) / per_line * per_line;
+    if(((size_t)ld * element_size) % 512 == 0){
+        ld += per_line;
+    }
+    return ld;
+}
+
+// Layout picked on the command line
+// Takes one of the GE_LAYOUT values as an argument
+GeLayout ge_layout(int layout){
+    switch(layout){
+        case GE_LAYOUT_DENSE:
+            return {false, GE_PAGES_SMALL};
+        case GE_LAYOUT_HUGE:
+            return {true, GE_PAGES_TRANSPARENT};
+        case GE_LAYOUT_HUGETLB:
+            return {true, GE_PAGES_EXPLICIT};
+        default:
+            return {true, GE_PAGES_SMALL};
+    }
+}
+
+// Allocates a matrix (the pages are not touched, so each thread can
+// place its own rows)
+// Takes the number of rows and columns, and the layout as arguments
+// Returns the matrix, with data set to NULL if it could not be mapped
+template <typename T>
+GeMatrix<T> ge_matrix_alloc(int rows, int cols, GeLayout layout){
+    GeMatrix<T> m;
+    m.rows = rows;
+    m.cols = cols;
+    m.ld = ge_leading_dim(cols, sizeof(T), layout.pad);
+    m.pages = layout.pages;
+    size_t bytes = (size_t)rows * m.ld * sizeof(T);
+
+    // Whole huge pages from the pool
+    m.base = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if(layout.pages == GE_PAGES_EXPLICIT){
+        m.mapped = (bytes + GE_HUGE_PAGE - 1) / GE_HUGE_PAGE * GE_HUGE_PAGE;
+        m.base = mmap(NULL, m.mapped, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if(m.base != MAP_FAILED){
+        m.data = (T*)m.base;
+        return m;
+    }
+
+    // Regular pages (page aligned), or room to start the matrix on a huge
+    // page boundary for transparent huge pages
+    if(layout.pages == GE_PAGES_SMALL){
+        m.mapped = bytes;
+    }else{
+        m.pages = GE_PAGES_TRANSPARENT;
+        m.mapped = bytes + GE_HUGE_PAGE;
+    }
+    m.base = mmap(NULL, m.mapped, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(m.base == MAP_FAILED){
+        m.base = NULL;
+        m.data = NULL;
+        return m;
+    }
+    m.data = (T*)m.base;
+    if(m.pages == GE_PAGES_TRANSPARENT){
+        uintptr_t start = ((uintptr_t)m.base + GE_HUGE_PAGE - 1) &
+            ~(uintptr_t)(GE_HUGE_PAGE - 1);
+        m.data = (T*)start;
+#ifdef MADV_HUGEPAGE
+        madvise(m.data, bytes, MADV_HUGEPAGE);
+#endif
+    }
+    return m;
+}
+
+// Frees a matrix
+// Takes the matrix as an argument
+template <typename T>
+void ge_matrix_free(GeMatrix<T> *m){
+    if(m->base != NULL){
+        munmap(m->base, m->mapped);
+    }
+    m->base = NULL;
+    m->data = NULL;
+}
+
+// Name of the pages backing a matrix
+// Takes the kind of pages as an argument
+const char *ge_pages_name(GePages pages){
+    switch(pages){
+        case GE_PAGES_TRANSPARENT:
+            return "transparent huge";
+        case GE_PAGES_EXPLICIT:
+            return "explicit huge";
+        default:
+            return "small";
+    }
+}
+
+#endif
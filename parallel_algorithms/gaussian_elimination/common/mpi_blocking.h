@@ -0,0 +1,126 @@
+// This file contains the blocking panel elimination used by the MPI
+// versions of Gaussian Elimination. Every pivot row is picked with one
+// reduction and sent to all ranks before the next one is picked. How it
+// gets from its owner to the other ranks is left to a pivot policy
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_MPI_BLOCKING_H
+#define GE_MPI_BLOCKING_H
+
+#include <mpi.h>
+#include <algorithm>
+#include "blocked.h"
+#include "mpi_lookahead.h"
+
+// Pivot policy that sends every pivot row with MPI_Bcast
+// The owner sends the columns right of the pivot straight from its row,
+// and everyone else receives them into a panel buffer
+struct GeBcastPivots {
+    int N;
+    // Pivot rows of a panel sent to this rank (only the columns right of
+    // each pivot are filled in)
+    float *panel;
+    // Time spent in, and bytes moved by, the broadcasts
+    double seconds;
+    double bytes;
+};
+
+// Allocates the panel buffer of a broadcast policy
+// Takes the policy to fill, the dimension, and the number of pivots per
+// panel as arguments
+void ge_bcast_pivots_init(GeBcastPivots *p, int N, int block_size){
+    p->N = N;
+    p->panel = new float[(size_t)block_size * N];
+    p->seconds = 0;
+    p->bytes = 0;
+}
+
+// Frees the panel buffer of a broadcast policy
+void ge_bcast_pivots_destroy(GeBcastPivots *p){
+    delete[] p->panel;
+}
+
+// Gets pivot row i to every rank
+// Takes the policy, the factored pivot row (NULL if this rank does not
+// own it), the rank that owns it, which matrix row it is, the pivot
+// column, and the first column of the panel as arguments
+// Returns the pivot row on this rank
+float *ge_pivot_row(GeBcastPivots *p, float *own, int owner, int row,
+        int i, int k0){
+    int N = p->N;
+    float *pivot = own ? own : &p->panel[(size_t)(i - k0) * N];
+    double t_bcast = MPI_Wtime();
+    MPI_Bcast(&pivot[i + 1], N - i - 1, MPI_FLOAT, owner, MPI_COMM_WORLD);
+    p->seconds += MPI_Wtime() - t_bcast;
+    p->bytes += (N - i - 1) * sizeof(float);
+    return pivot;
+}
+
+// Blocking Gaussian Elimination for one rank
+// Every rank offers its best remaining row for the pivot, and the
+// largest one is picked with a single reduction. The rank that owns it
+// normalizes it, then the pivot policy gets it to all ranks. Rows only
+// eliminate the panel columns as each pivot row arrives, and the
+// trailing columns are updated once per panel
+// With keep_lu the rows are left holding the packed LU factorization
+// (as in ge_blocked)
+// Takes the mapping, the pivot policy, the rows of this rank, the
+// dimension, this rank, the number of ranks, the permutation vector, the
+// number of pivots per panel, and the packed LU flag as arguments
+template <typename Mapping, typename Pivots>
+void ge_mpi_blocking(const Mapping &mapping, Pivots *pivots,
+        float *sub_matrix, int N, int rank, int size, int *perm,
+        int block_size, bool keep_lu = false){
+    // Pointers to the rows of this rank, and the pivot rows of a panel
+    // (rows[0, done) are pivots, rows[done, num_rows) still remain)
+    int num_rows = mapping.num_rows(N, size, rank);
+    float **rows = new float*[num_rows];
+    int *ids = new int[num_rows];
+    const float **u_rows = new const float*[block_size];
+    for(int j = 0; j < num_rows; j++){
+        rows[j] = &sub_matrix[(size_t)j * N];
+        ids[j] = mapping.row(j, N, size, rank);
+    }
+    int done = 0;
+
+    // Iterate over all panels
+    for(int k0 = 0; k0 < N; k0 += block_size){
+        int k1 = std::min(k0 + block_size, N);
+
+        for(int i = k0; i < k1; i++){
+            // Find the largest element in this column across all ranks
+            int owner = ge_mpi_select_pivot(mapping, rows, ids, num_rows,
+                    done, i, N, size, perm);
+
+            // The owner updates and normalizes the pivot row in place
+            float *own = NULL;
+            if(rank == owner){
+                ge_factor_pivot_row(rows[done], u_rows, k0, k1, i, N,
+                        keep_lu);
+                own = rows[done];
+                done++;
+            }
+            const float *row = ge_pivot_row(pivots, own, owner, perm[i],
+                    i, k0);
+            u_rows[i - k0] = row;
+
+            // Eliminate this element from the panel columns of all the
+            // remaining rows mapped to this rank
+            ge_panel_update(&rows[done], num_rows - done, row, i, k1);
+        }
+
+        // Update the trailing columns of the remaining rows
+        ge_trailing_update(&rows[done], num_rows - done, u_rows, k0, k1,
+                k1, N);
+        if(!keep_lu){
+            ge_clear_multipliers(&rows[done], num_rows - done, k0, k1);
+        }
+    }
+
+    // Free heap-allocated memory
+    delete[] rows;
+    delete[] ids;
+    delete[] u_rows;
+}
+
+#endif
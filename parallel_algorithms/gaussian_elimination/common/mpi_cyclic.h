@@ -0,0 +1,74 @@
+// This file collects the rows of the ranks of a cyclic striped mapping
+// (row i belongs to rank i % size) into a matrix on rank 0. Every rank
+// makes its own rows, so nothing is scattered
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_MPI_CYCLIC_H
+#define GE_MPI_CYCLIC_H
+
+#include <mpi.h>
+
+// Datatype and sizes used to move cyclic stripes
+// The first (N / size) * size rows move as one stripe per rank, and the
+// last N % size rows (one for each of the first ranks) are contiguous,
+// so they move with a second gather (skipped when N is a multiple of
+// size). A single Gatherv can't do both, since it takes one datatype,
+// and a stripe one row longer would run past the matrix on the last
+// ranks
+struct GeCyclicRows {
+    int N;
+    int rank;
+    int size;
+    // Every size-th row of the first (N / size) * size rows, resized to
+    // the length of one row so rank r's stripe starts at row r
+    MPI_Datatype stripe;
+    // Floats of the last rows of each rank, and where they start
+    int *counts;
+    int *displs;
+};
+
+// Builds the datatype and sizes for a dimension
+// Takes the state to fill, the dimension, this rank, and the number of
+// ranks as arguments
+void ge_cyclic_rows_init(GeCyclicRows *c, int N, int rank, int size){
+    c->N = N;
+    c->rank = rank;
+    c->size = size;
+
+    MPI_Datatype rows;
+    MPI_Type_vector(N / size, N, N * size, MPI_FLOAT, &rows);
+    MPI_Type_create_resized(rows, 0, N * sizeof(float), &c->stripe);
+    MPI_Type_commit(&c->stripe);
+    MPI_Type_free(&rows);
+
+    c->counts = new int[size];
+    c->displs = new int[size];
+    for(int r = 0; r < size; r++){
+        c->counts[r] = (r < N % size) ? N : 0;
+        c->displs[r] = ((N / size) * size + r) * N;
+    }
+}
+
+// Frees the datatype and sizes
+void ge_cyclic_rows_destroy(GeCyclicRows *c){
+    MPI_Type_free(&c->stripe);
+    delete[] c->counts;
+    delete[] c->displs;
+}
+
+// Collects the rows of every rank into a matrix on rank 0
+// Takes the state, the rows of this rank, and the matrix (only written
+// on rank 0) as arguments
+void ge_gather_rows(const GeCyclicRows *c, const float *sub_matrix,
+        float *matrix){
+    int full_rows = c->N / c->size;
+    MPI_Gather(sub_matrix, c->N * full_rows, MPI_FLOAT, matrix, 1,
+            c->stripe, 0, MPI_COMM_WORLD);
+    if(c->N % c->size != 0){
+        MPI_Gatherv(&sub_matrix[(size_t)full_rows * c->N],
+                c->counts[c->rank], MPI_FLOAT, matrix, c->counts, c->displs,
+                MPI_FLOAT, 0, MPI_COMM_WORLD);
+    }
+}
+
+#endif
@@ -0,0 +1,134 @@
+// This file contains the binary matrix file format used by the MPI
+// versions of Gaussian Elimination, and collective MPI-IO readers and
+// writers that move each rank's rows straight between the file and its
+// sub-matrix (no rank ever holds the whole matrix)
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_MPI_IO_H
+#define GE_MPI_IO_H
+
+#include <mpi.h>
+#include <stdint.h>
+#include <cstring>
+#include <iostream>
+
+// File header, followed by the rows of the matrix as floats in row
+// order (all fields in the byte order of the machine that wrote them)
+struct GeFileHeader {
+    // "GEMATRIX"
+    char magic[8];
+    // Format version
+    int32_t version;
+    // Dimensions of the matrix
+    int32_t rows;
+    int32_t cols;
+    // Bytes per element (4 for float)
+    int32_t element_size;
+};
+
+const char GE_FILE_MAGIC[8] = {'G', 'E', 'M', 'A', 'T', 'R', 'I', 'X'};
+const int32_t GE_FILE_VERSION = 1;
+
+// Builds the file type that selects the rows of one rank
+// Takes the mapping, the dimension, the number of ranks, and the rank as
+// arguments
+// Returns the committed datatype (one block of N floats per row)
+template <typename Mapping>
+MPI_Datatype ge_file_rows(const Mapping &mapping, int N, int size,
+        int rank){
+    int num_rows = mapping.num_rows(N, size, rank);
+    MPI_Aint *displs = new MPI_Aint[num_rows];
+    for(int j = 0; j < num_rows; j++){
+        displs[j] = (MPI_Aint)mapping.row(j, N, size, rank) * N *
+            sizeof(float);
+    }
+    MPI_Datatype rows;
+    MPI_Type_create_hindexed_block(num_rows, N, displs, MPI_FLOAT, &rows);
+    MPI_Type_commit(&rows);
+    delete[] displs;
+    return rows;
+}
+
+// Opens a matrix file on every rank of a communicator and checks its
+// header
+// Takes the communicator, the path, and the file handle to fill as
+// arguments
+// Returns the dimension of the (square) matrix, or aborts if the file
+// can not be read
+int ge_file_open(MPI_Comm comm, const char *path, MPI_File *fh){
+    if(MPI_File_open(comm, path, MPI_MODE_RDONLY, MPI_INFO_NULL,
+                fh) != MPI_SUCCESS){
+        std::cerr << "Can not open " << path << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    GeFileHeader header;
+    MPI_File_read_at_all(*fh, 0, &header, sizeof(header), MPI_BYTE,
+            MPI_STATUS_IGNORE);
+    if((memcmp(header.magic, GE_FILE_MAGIC, sizeof(GE_FILE_MAGIC)) != 0) ||
+            (header.version != GE_FILE_VERSION) ||
+            (header.rows != header.cols) ||
+            (header.element_size != sizeof(float))){
+        std::cerr << path << " is not a square float matrix file"
+            << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    return header.rows;
+}
+
+// Reads the rows of this rank from an open matrix file with one
+// collective call, then closes it
+// Takes the file, the mapping, the dimension, the number of ranks, this
+// rank, and the sub-matrix to fill as arguments
+template <typename Mapping>
+void ge_file_read(MPI_File *fh, const Mapping &mapping, int N, int size,
+        int rank, float *sub_matrix){
+    MPI_Datatype rows = ge_file_rows(mapping, N, size, rank);
+    MPI_File_set_view(*fh, sizeof(GeFileHeader), MPI_FLOAT, rows, "native",
+            MPI_INFO_NULL);
+    MPI_File_read_all(*fh, sub_matrix, mapping.num_rows(N, size, rank) * N,
+            MPI_FLOAT, MPI_STATUS_IGNORE);
+    MPI_File_close(fh);
+    MPI_Type_free(&rows);
+}
+
+// Writes the rows of every rank of a communicator to a matrix file with
+// one collective call (rank 0 also writes the header)
+// Takes the communicator, the path, the mapping, the dimension, the
+// number of ranks, this rank, and the rows of this rank as arguments
+template <typename Mapping>
+void ge_file_write(MPI_Comm comm, const char *path, const Mapping &mapping,
+        int N, int size, int rank, float *sub_matrix){
+    MPI_File fh;
+    if(MPI_File_open(comm, path,
+                MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                &fh) != MPI_SUCCESS){
+        std::cerr << "Can not create " << path << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    // Drop anything left over from a larger file
+    MPI_File_set_size(fh, sizeof(GeFileHeader) +
+            (MPI_Offset)N * N * sizeof(float));
+
+    if(rank == 0){
+        GeFileHeader header;
+        memcpy(header.magic, GE_FILE_MAGIC, sizeof(GE_FILE_MAGIC));
+        header.version = GE_FILE_VERSION;
+        header.rows = N;
+        header.cols = N;
+        header.element_size = sizeof(float);
+        MPI_File_write_at(fh, 0, &header, sizeof(header), MPI_BYTE,
+                MPI_STATUS_IGNORE);
+    }
+
+    MPI_Datatype rows = ge_file_rows(mapping, N, size, rank);
+    MPI_File_set_view(fh, sizeof(GeFileHeader), MPI_FLOAT, rows, "native",
+            MPI_INFO_NULL);
+    MPI_File_write_all(fh, sub_matrix, mapping.num_rows(N, size, rank) * N,
+            MPI_FLOAT, MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+    MPI_Type_free(&rows);
+}
+
+#endif
@@ -0,0 +1,209 @@
+// This file contains the lookahead elimination used by the MPI versions
+// of Gaussian Elimination. Pivot rows are sent with MPI_Ibcast, and
+// each rank keeps eliminating with pivot i while pivot row i + 1 is
+// still on its way
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_MPI_LOOKAHEAD_H
+#define GE_MPI_LOOKAHEAD_H
+
+#include <mpi.h>
+#include <cstring>
+#include <algorithm>
+#include "blocked.h"
+
+// Columns updated ahead of the rest so the next pivot can be picked
+// It is a multiple of every vector width (and GE_TILE_COLS is a
+// multiple of it), so the two calls split a row on the same vector
+// boundaries as the single call of the blocking version, and every
+// element is rounded the same way (fused or not)
+const int GE_LOOKAHEAD_COLS = 16;
+
+// Picks pivot i across all ranks (the largest element of column i), and
+// moves it to rows[done] if this rank owns it
+// Takes the mapping, the row list of this rank and its length, the
+// number of pivot rows in it so far, the pivot column, the dimension,
+// the number of ranks, and the permutation vector as arguments
+// Returns the rank that owns the pivot row
+template <typename Mapping>
+int ge_mpi_select_pivot(const Mapping &mapping, float **rows, int *ids,
+        int num_rows, int done, int i, int N, int size, int *perm){
+    int pos;
+    GePivot local = ge_find_pivot(&rows[done], &ids[done], num_rows - done,
+            i, &pos);
+    GePivot best;
+    MPI_Allreduce(&local, &best, 1, MPI_FLOAT_INT, MPI_MAXLOC,
+            MPI_COMM_WORLD);
+    perm[i] = best.row;
+
+    // The owner moves the pivot to the front of its remaining rows
+    if((pos >= 0) && (ids[done + pos] == best.row)){
+        ge_swap_rows(rows, ids, done, done + pos);
+    }
+    return mapping.owner(best.row, N, size);
+}
+
+// Lookahead Gaussian Elimination for one rank
+// Once pivot row i arrives, column i + 1 of the remaining rows (and the
+// columns after it up to GE_LOOKAHEAD_COLS) is updated first so pivot
+// i + 1 can be picked. Its owner brings that row up to date, normalizes
+// it, and starts broadcasting it, and only then does every rank
+// eliminate pivot i from the rest of its rows. At the end of a panel
+// the same is done with the first columns of the trailing matrix. Only
+// the columns right of each pivot are sent, straight from the owner's
+// row. Pivot rows are received into a ring of two panel buffers, so the
+// next panel can arrive while the last one is still being applied
+// Gives the same result as the blocking version (the same kernels are
+// applied to every element in the same order, on the same vector
+// boundaries)
+// With keep_lu the rows are left holding the packed LU factorization
+// (as in ge_blocked)
+// Takes the mapping, the rows of this rank, the dimension, this rank,
+// the number of ranks, the permutation vector, the number of pivots per
+// panel, the length of each row (0 for N, or more for an augmented
+// matrix), and the packed LU flag as arguments
+template <typename Mapping>
+void ge_mpi_lookahead(const Mapping &mapping, float *sub_matrix, int N,
+        int rank, int size, int *perm, int block_size, int ncols = 0,
+        bool keep_lu = false){
+    if(ncols == 0){
+        ncols = N;
+    }
+
+    // Ring of panel buffers (panel p receives into ring[p % 2]), and
+    // the pivot rows of the current and previous panels
+    float *ring[2];
+    const float **u_ring[2];
+    for(int b = 0; b < 2; b++){
+        ring[b] = new float[(size_t)block_size * ncols];
+        u_ring[b] = new const float*[block_size];
+    }
+
+    // Pointers to the rows of this rank (rows[0, done) are pivots,
+    // rows[done, num_rows) still remain)
+    int num_rows = mapping.num_rows(N, size, rank);
+    float **rows = new float*[num_rows];
+    int *ids = new int[num_rows];
+    for(int j = 0; j < num_rows; j++){
+        rows[j] = &sub_matrix[(size_t)j * ncols];
+        ids[j] = mapping.row(j, N, size, rank);
+    }
+    int done = 0;
+
+    // Start the broadcast of the first pivot row (the owner sends the
+    // columns right of the pivot straight from its row, everyone else
+    // receives them into the panel buffer)
+    MPI_Request request;
+    int root = ge_mpi_select_pivot(mapping, rows, ids, num_rows, done, 0,
+            N, size, perm);
+    float *next = ring[0];
+    if(rank == root){
+        float pivot = rows[done][0];
+        ge_normalize_row(rows[done], 0, ncols);
+        if(keep_lu){
+            rows[done][0] = pivot;
+        }
+        next = rows[done];
+        done++;
+    }
+    u_ring[0][0] = next;
+    MPI_Ibcast(&next[1], ncols - 1, MPI_FLOAT, root, MPI_COMM_WORLD, &request);
+
+    for(int k0 = 0; k0 < N; k0 += block_size){
+        int k1 = std::min(k0 + block_size, N);
+        float *panel = ring[(k0 / block_size) % 2];
+        const float **u_rows = u_ring[(k0 / block_size) % 2];
+
+        for(int i = k0; i < k1; i++){
+            // Wait for pivot row i
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+            const float *row = u_rows[i - k0];
+
+            // The last pivot of a panel leaves no panel columns
+            if(i + 1 == k1){
+                break;
+            }
+
+            // Column i + 1 first (with the columns after it up to the
+            // split), so the next pivot can be picked
+            int lead = std::min(GE_LOOKAHEAD_COLS, k1 - i - 1);
+            for(int r = done; r < num_rows; r++){
+                ge_eliminate(&rows[r][i + 1], &row[i + 1], rows[r][i], lead);
+            }
+            int c = i + 1 + lead;
+            root = ge_mpi_select_pivot(mapping, rows, ids, num_rows, done,
+                    i + 1, N, size, perm);
+
+            // The owner finishes pivot i on its row, then factors it and
+            // starts sending it
+            next = &panel[(size_t)(i + 1 - k0) * ncols];
+            if(rank == root){
+                ge_eliminate(&rows[done][c], &row[c], rows[done][i],
+                        k1 - c);
+                ge_factor_pivot_row(rows[done], u_rows, k0, k1, i + 1,
+                        ncols, keep_lu);
+                next = rows[done];
+                done++;
+            }
+            u_rows[i + 1 - k0] = next;
+            MPI_Ibcast(&next[i + 2], ncols - i - 2, MPI_FLOAT, root,
+                    MPI_COMM_WORLD, &request);
+
+            // Eliminate pivot i from the rest of the panel columns while
+            // pivot row i + 1 is in flight
+            for(int r = done; r < num_rows; r++){
+                ge_eliminate(&rows[r][c], &row[c], rows[r][i], k1 - c);
+            }
+        }
+
+        if(k1 == N){
+            break;
+        }
+
+        // First columns of the trailing matrix, so the first pivot of the
+        // next panel can be picked
+        int lead = std::min(GE_LOOKAHEAD_COLS, ncols - k1);
+        ge_trailing_update(&rows[done], num_rows - done, u_rows, k0, k1, k1,
+                k1 + lead);
+        root = ge_mpi_select_pivot(mapping, rows, ids, num_rows, done, k1,
+                N, size, perm);
+
+        // The owner finishes this panel on its row, then normalizes it
+        // and starts sending it into the other panel buffer
+        next = ring[(k1 / block_size) % 2];
+        if(rank == root){
+            ge_trailing_update(&rows[done], 1, u_rows, k0, k1, k1 + lead,
+                    ncols);
+            float pivot = rows[done][k1];
+            if(!keep_lu){
+                ge_clear_multipliers(&rows[done], 1, k0, k1);
+            }
+            ge_normalize_row(rows[done], k1, ncols);
+            if(keep_lu){
+                rows[done][k1] = pivot;
+            }
+            next = rows[done];
+            done++;
+        }
+        u_ring[(k1 / block_size) % 2][0] = next;
+        MPI_Ibcast(&next[k1 + 1], ncols - k1 - 1, MPI_FLOAT, root,
+                MPI_COMM_WORLD, &request);
+
+        // Update the rest of the trailing columns while it is in flight
+        ge_trailing_update(&rows[done], num_rows - done, u_rows, k0, k1,
+                k1 + lead, ncols);
+        if(!keep_lu){
+            ge_clear_multipliers(&rows[done], num_rows - done, k0, k1);
+        }
+    }
+
+    // Free heap-allocated memory
+    for(int b = 0; b < 2; b++){
+        delete[] ring[b];
+        delete[] u_ring[b];
+    }
+    delete[] rows;
+    delete[] ids;
+}
+
+#endif
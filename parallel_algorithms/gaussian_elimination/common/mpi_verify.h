@@ -0,0 +1,100 @@
+// This file contains the check of a packed LU factorization spread over
+// the ranks of the MPI versions of Gaussian Elimination. Every rank
+// checks its own rows, so no rank needs the whole matrix
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_MPI_VERIFY_H
+#define GE_MPI_VERIFY_H
+
+#include <mpi.h>
+#include <cmath>
+#include <algorithm>
+#include "random.h"
+#include "verify.h"
+
+// Checks the packed LU factorization in the rows of every rank with a
+// random vector v: ||P A v - L (U v)|| / (||A|| ||v||) in the infinity
+// norm (O(N^2) work in all)
+// Row perm[i] holds row i of L left of the diagonal and the pivot on
+// it, and row i of U right of it (as in ge_blocked)
+// Takes the mapping, the rows of A of this rank (NULL to make each one
+// again from the seed), the rows of the packed LU of this rank, the
+// dimension, this rank, the number of ranks, the permutation vector,
+// and the seed of A as arguments
+// Returns the relative error (on every rank)
+template <typename Mapping>
+double ge_mpi_check_lu(const Mapping &mapping, const float *a_rows,
+        const float *lu_rows, int N, int rank, int size, const int *perm,
+        uint32_t seed = 0){
+    int num_rows = mapping.num_rows(N, size, rank);
+
+    // Which pivot each row of the matrix became
+    int *pivot_of = new int[N];
+    for(int i = 0; i < N; i++){
+        pivot_of[perm[i]] = i;
+    }
+
+    // Every rank makes the same v, and computes y = U v for its rows
+    // (U has a unit diagonal), then the pieces are summed on every rank
+    double *v = new double[N];
+    double *y_local = new double[N];
+    double *y = new double[N];
+    ge_random_row(v, 0, N, 0x5eed);
+    for(int i = 0; i < N; i++){
+        y_local[i] = 0;
+    }
+    for(int j = 0; j < num_rows; j++){
+        const float *row = &lu_rows[(size_t)j * N];
+        int i = pivot_of[mapping.row(j, N, size, rank)];
+        double sum = v[i];
+        for(int k = i + 1; k < N; k++){
+            sum += (double)row[k] * v[k];
+        }
+        y_local[i] = sum;
+    }
+    MPI_Allreduce(y_local, y, N, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+    // Largest error of row i of L y against row perm[i] of A v, row sum
+    // of |A|, and |v| over the rows of this rank, then over all ranks
+    float *a_made = new float[N];
+    double local[3] = {0, 0, 0};
+    for(int j = 0; j < num_rows; j++){
+        const float *row = &lu_rows[(size_t)j * N];
+        int id = mapping.row(j, N, size, rank);
+        int i = pivot_of[id];
+        const float *a_row = a_made;
+        if(a_rows){
+            a_row = &a_rows[(size_t)j * N];
+        }else{
+            ge_random_row(a_made, id, N, seed);
+        }
+        double ly = 0;
+        for(int k = 0; k <= i; k++){
+            ly += (double)row[k] * y[k];
+        }
+        double av = 0;
+        double abs_sum = 0;
+        for(int k = 0; k < N; k++){
+            av += (double)a_row[k] * v[k];
+            abs_sum += std::fabs(a_row[k]);
+        }
+        local[0] = ge_max_error(local[0], std::fabs(av - ly));
+        local[1] = ge_max_error(local[1], abs_sum);
+    }
+    for(int k = 0; k < N; k++){
+        local[2] = ge_max_error(local[2], std::fabs(v[k]));
+    }
+    double global[3];
+    MPI_Allreduce(local, global, 3, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+    // Free heap-allocated memory
+    delete[] pivot_of;
+    delete[] v;
+    delete[] y_local;
+    delete[] y;
+    delete[] a_made;
+
+    return ge_relative_error(global[0], global[1] * global[2]);
+}
+
+#endif
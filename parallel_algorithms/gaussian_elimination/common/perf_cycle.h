@@ -0,0 +1,48 @@
+// This file contains the timing rendezvous of the pthread versions of
+// Gaussian Elimination: the last thread to arrive takes the time, so a
+// parallel section is timed from when every thread exists to when every
+// thread is done
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_PERF_CYCLE_H
+#define GE_PERF_CYCLE_H
+
+#include <pthread.h>
+#include <chrono>
+
+using namespace std::chrono;
+
+// Waits for every thread, and records the time once the last one
+// arrives
+// Takes the number of threads, the count of threads still to arrive
+// (starting at the number of threads), the lock and condition guarding
+// it, and where to record the time as arguments
+void perf_cycle(int num_threads, int *counter, pthread_mutex_t *mtx,
+        pthread_cond_t *cond,
+        high_resolution_clock::time_point *time){
+    // Get the lock
+    pthread_mutex_lock(mtx);
+
+    // Atomically decrement number of outstanding threads
+    *counter -= 1;
+    // Check if we are the last thread
+    // If not, wait to be signaled
+    if(*counter == 0){
+        // Update a timing variable
+        *time = high_resolution_clock::now();
+
+        // Reset the counter
+        *counter = num_threads;
+
+        // Signal everyone to continue
+        pthread_cond_broadcast(cond);
+    }else{
+        // Wait for the last thread before continuing
+        pthread_cond_wait(cond, mtx);
+    }
+
+    // Everyone unlocks
+    pthread_mutex_unlock(mtx);
+}
+
+#endif
@@ -0,0 +1,147 @@
+// This file contains the counter-based random number generator used to
+// fill matrices. Every element comes from Philox4x32-10 applied to its
+// row and column, so any thread or rank can fill exactly its own rows,
+// and a seed always gives the same matrix
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_RANDOM_H
+#define GE_RANDOM_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <complex>
+#include "affinity.h"
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as
+// 1, 2, 3")
+// Takes the counter (replaced by the 4 random words) and the key as
+// arguments
+inline void ge_philox(uint32_t ctr[4], uint32_t key[2]){
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+    for(int round = 0; round < 10; round++){
+        uint64_t p0 = (uint64_t)0xD2511F53 * ctr[0];
+        uint64_t p1 = (uint64_t)0xCD9E8D57 * ctr[2];
+        uint32_t c1 = ctr[1];
+        uint32_t c3 = ctr[3];
+        ctr[0] = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        ctr[1] = (uint32_t)p1;
+        ctr[2] = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        ctr[3] = (uint32_t)p0;
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+}
+
+// Random matrix elements made from random words
+template <typename T>
+struct GeRandom {
+    // Words used per element
+    static const int words = 1;
+
+    // Number between -100 and 100 (from the top 24 bits)
+    static T make(const uint32_t *w){
+        return T((w[0] >> 8) * (1.0 / 16777216.0) * 200 - 100);
+    }
+};
+
+// Complex elements get a random real and imaginary part
+template <typename R>
+struct GeRandom<std::complex<R> > {
+    static const int words = 2;
+
+    static std::complex<R> make(const uint32_t *w){
+        return std::complex<R>(GeRandom<R>::make(&w[0]),
+                GeRandom<R>::make(&w[1]));
+    }
+};
+
+// Fills columns [c0, c1) of one row of a matrix (out[0] is column c0)
+// Element j of row i is always the same for a seed, no matter who fills
+// it or in what order
+// Takes the output, the row number, the first and end columns, and the
+// seed as arguments
+template <typename T>
+void ge_random_cols(T *out, int i, int c0, int c1, uint32_t seed){
+    const int per_block = 4 / GeRandom<T>::words;
+    uint32_t key[2] = {seed, 0};
+    for(int j0 = c0 - c0 % per_block; j0 < c1; j0 += per_block){
+        uint32_t ctr[4] = {(uint32_t)(j0 / per_block), (uint32_t)i, 0, 0};
+        ge_philox(ctr, key);
+        for(int e = 0; (e < per_block) && (j0 + e < c1); e++){
+            if(j0 + e >= c0){
+                out[j0 + e - c0] =
+                    GeRandom<T>::make(&ctr[e * GeRandom<T>::words]);
+            }
+        }
+    }
+}
+
+// Fills one row of a matrix
+// Takes the row, its row number, its length, and the seed as arguments
+template <typename T>
+void ge_random_row(T *row, int i, int M, uint32_t seed){
+    ge_random_cols(row, i, 0, M, seed);
+}
+
+// Fills the rows a mapping gives one thread or rank (row j of the
+// output is its jth row), so no one needs the whole matrix
+// Takes the mapping, the output, the number of rows and columns of the
+// matrix, the number of threads or ranks, its ID, and the seed as
+// arguments
+template <typename Mapping, typename T>
+void ge_random_mapped(const Mapping &mapping, T *rows, int N, int M,
+        int p, int tid, uint32_t seed){
+    int num_rows = mapping.num_rows(N, p, tid);
+    for(int j = 0; j < num_rows; j++){
+        ge_random_row(&rows[(size_t)j * M], mapping.row(j, N, p, tid), M,
+                seed);
+    }
+}
+
+// Rows filled by one thread
+template <typename T>
+struct GeRandomArgs {
+    T *matrix;
+    int first;
+    int last;
+    int M;
+    uint32_t seed;
+};
+
+// Pthread function that fills rows [first, last) of a matrix
+// Takes a pointer to a struct of args as an argument
+template <typename T>
+void *ge_random_rows(void *args){
+    GeRandomArgs<T> *a = (GeRandomArgs<T>*)args;
+    for(int i = a->first; i < a->last; i++){
+        ge_random_row(&a->matrix[(size_t)i * a->M], i, a->M, a->seed);
+    }
+    return 0;
+}
+
+// Fills a matrix with one contiguous run of rows per thread (each thread
+// also touches its rows first)
+// Takes the matrix, its number of rows and columns, the seed, and the
+// number of threads as arguments
+template <typename T>
+void ge_random_matrix(T *matrix, int N, int M, uint32_t seed,
+        int num_threads){
+    pthread_t *threads = new pthread_t[num_threads];
+    GeRandomArgs<T> *args = new GeRandomArgs<T>[num_threads];
+    for(int t = 0; t < num_threads; t++){
+        args[t].matrix = matrix;
+        args[t].first = (int)((long)N * t / num_threads);
+        args[t].last = (int)((long)N * (t + 1) / num_threads);
+        args[t].M = M;
+        args[t].seed = seed;
+        start_thread(&threads[t], ge_random_rows<T>, (void*)&args[t]);
+    }
+    for(int t = 0; t < num_threads; t++){
+        pthread_join(threads[t], NULL);
+    }
+    delete[] threads;
+    delete[] args;
+}
+
+#endif
@@ -0,0 +1,194 @@
+// This file contains mixed-precision solving: the matrix is factored in
+// float (the O(N^3) part), then the solution is refined in double with
+// O(N^2) residual corrections until it reaches double accuracy
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_REFINE_H
+#define GE_REFINE_H
+
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include "lu.h"
+
+// What happened during a mixed-precision solve
+struct GeRefineStats {
+    // Number of corrections applied
+    int iterations;
+    // The tolerance was reached by refinement
+    bool converged;
+    // Refinement failed and the system was solved in double instead
+    bool fell_back;
+    // Normwise backward error of the returned solution
+    double backward_error;
+    // Time spent factoring, refining, and in the fallback
+    double factor_seconds;
+    double refine_seconds;
+    double fallback_seconds;
+};
+
+// Infinity norm (largest row sum) of a matrix
+// Takes the matrix and its dimension as arguments
+double ge_norm_inf(const double *A, int n){
+    double norm = 0;
+    for(int i = 0; i < n; i++){
+        double sum = 0;
+        for(int j = 0; j < n; j++){
+            sum += std::fabs(A[(size_t)i * n + j]);
+        }
+        norm = std::max(norm, sum);
+    }
+    return norm;
+}
+
+// Computes r = b - Ax in double
+// Takes A, b, x, the residual to fill, the dimension, and the infinity
+// norm of A as arguments
+// Returns the normwise backward error ||r|| / (||A|| ||x|| + ||b||)
+double ge_residual(const double *A, const double *b, const double *x,
+        double *r, int n, double a_norm){
+    double r_norm = 0;
+    double x_norm = 0;
+    double b_norm = 0;
+    for(int i = 0; i < n; i++){
+        const double *row = &A[(size_t)i * n];
+        double sum = b[i];
+        for(int j = 0; j < n; j++){
+            sum -= row[j] * x[j];
+        }
+        r[i] = sum;
+        r_norm = std::max(r_norm, std::fabs(sum));
+        x_norm = std::max(x_norm, std::fabs(x[i]));
+        b_norm = std::max(b_norm, std::fabs(b[i]));
+    }
+    return r_norm / (a_norm * x_norm + b_norm);
+}
+
+// Refines a solution with a float factorization of A
+// x starts as the float solution, then each step solves A d = r in
+// float and adds d to x in double. Refinement stops when the backward
+// error reaches tol, stops shrinking, or after max_iter corrections
+// Takes the factorization, A and b in double, x, the tolerance, the
+// maximum number of corrections, and the stats to fill as arguments
+// Returns true if the tolerance was reached
+bool ge_refine(const GeFactorization *f, const double *A, const double *b,
+        double *x, double tol, int max_iter, GeRefineStats *stats){
+    int n = f->n;
+    float *r_float = new float[n];
+    float *d_float = new float[n];
+    double *r = new double[n];
+    double a_norm = ge_norm_inf(A, n);
+
+    // Starting point: the float solve of b
+    for(int i = 0; i < n; i++){
+        r_float[i] = (float)b[i];
+    }
+    ge_lu_solve(f, r_float, d_float);
+    for(int i = 0; i < n; i++){
+        x[i] = d_float[i];
+    }
+
+    stats->iterations = 0;
+    stats->converged = false;
+    double previous = INFINITY;
+    while(true){
+        double error = ge_residual(A, b, x, r, n, a_norm);
+        stats->backward_error = error;
+        if(error <= tol){
+            stats->converged = true;
+            break;
+        }
+
+        // Give up if the error is not shrinking (or is not a number)
+        if(!(error < previous) || (stats->iterations == max_iter)){
+            break;
+        }
+        previous = error;
+
+        // Correct x with the float solve of the residual
+        for(int i = 0; i < n; i++){
+            r_float[i] = (float)r[i];
+        }
+        ge_lu_solve(f, r_float, d_float);
+        for(int i = 0; i < n; i++){
+            x[i] += d_float[i];
+        }
+        stats->iterations++;
+    }
+
+    delete[] r_float;
+    delete[] d_float;
+    delete[] r;
+    return stats->converged;
+}
+
+// Solves in double with a fallback if refinement did not converge, or
+// always when forced (a double factorization, by threads when there is
+// more than one), and records the time and final error
+// Takes A, b, x, the dimension, the stats, the number of threads, the
+// number of pivots per panel, and whether to fall back anyway as
+// arguments
+void ge_refine_fallback(const double *A, const double *b, double *x, int n,
+        GeRefineStats *stats, int num_threads = 1,
+        int block_size = GE_BLOCK_SIZE, bool force = false){
+    stats->fell_back = force || !stats->converged;
+    stats->fallback_seconds = 0;
+    if(!stats->fell_back){
+        return;
+    }
+
+    std::chrono::high_resolution_clock::time_point start =
+        std::chrono::high_resolution_clock::now();
+    GeBasicFactorization<double> f;
+    if(num_threads > 1){
+        ge_parallel_factor(&f, A, n, num_threads, block_size);
+    }else{
+        ge_factor(&f, A, n, block_size);
+    }
+    ge_lu_solve(&f, b, x);
+    ge_factorization_destroy(&f);
+    std::chrono::high_resolution_clock::time_point end =
+        std::chrono::high_resolution_clock::now();
+    stats->fallback_seconds =
+        std::chrono::duration<double>(end - start).count();
+
+    double *r = new double[n];
+    stats->backward_error = ge_residual(A, b, x, r, n, ge_norm_inf(A, n));
+    delete[] r;
+}
+
+// Serial mixed-precision solve of Ax = b
+// Takes A (n x n) and b in double, x, the dimension, the tolerance on
+// the backward error, the maximum number of corrections, the stats to
+// fill, and the number of pivots per panel as arguments
+void ge_serial_mixed_solve(const double *A, const double *b, double *x,
+        int n, double tol, int max_iter, GeRefineStats *stats,
+        int block_size = GE_BLOCK_SIZE){
+    std::chrono::high_resolution_clock::time_point t0 =
+        std::chrono::high_resolution_clock::now();
+
+    // Factor a float copy of A
+    float *A_float = new float[(size_t)n * n];
+    for(size_t i = 0; i < (size_t)n * n; i++){
+        A_float[i] = (float)A[i];
+    }
+    GeFactorization f;
+    ge_factor(&f, A_float, n, block_size);
+    delete[] A_float;
+
+    std::chrono::high_resolution_clock::time_point t1 =
+        std::chrono::high_resolution_clock::now();
+
+    // Refine in double
+    ge_refine(&f, A, b, x, tol, max_iter, stats);
+    ge_factorization_destroy(&f);
+
+    std::chrono::high_resolution_clock::time_point t2 =
+        std::chrono::high_resolution_clock::now();
+    stats->factor_seconds = std::chrono::duration<double>(t1 - t0).count();
+    stats->refine_seconds = std::chrono::duration<double>(t2 - t1).count();
+
+    ge_refine_fallback(A, b, x, n, stats, 1, block_size);
+}
+
+#endif
@@ -0,0 +1,322 @@
+// This file contains the threads of the pthread parallel Gaussian
+// Elimination, with the row mapping as a template parameter. The naive
+// (BlockMapping), cyclic striped (CyclicMapping), and block-cyclic
+// (BlockCyclicMapping) versions all launch them
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_ROW_THREADS_H
+#define GE_ROW_THREADS_H
+
+#include <pthread.h>
+#include <chrono>
+#include "common.h"
+#include "lookahead.h"
+#include "affinity.h"
+#include "bench.h"
+#include "verify.h"
+#include "matrix.h"
+#include "mapping.h"
+#include "perf_cycle.h"
+
+using namespace std::chrono;
+
+template <typename Mapping>
+struct Args {
+    // Thread ID
+    int tid;
+    // Number of threads launched
+    int num_threads;
+    // Which rows belong to which thread
+    Mapping mapping;
+    // Matrix of floating point numbers
+    float *matrix;
+    // Dimensions of the square matrix
+    int N;
+    // Elements from the start of one row to the next
+    int ld;
+    // Number of pivots per blocked panel
+    int block_size;
+    // Row of the matrix picked as each pivot
+    int *perm;
+    // Pivot candidates from each thread
+    Candidate *candidates;
+    // Use the barrier-free lookahead pipeline instead of barriers
+    bool lookahead;
+    // Leave the multipliers and pivots in place (packed LU)
+    bool keep_lu;
+    GeLookahead *la;
+    // Rows are copied from here by their own thread (first touch), or
+    // made by it from the seed when this is NULL
+    const float *source;
+    uint32_t seed;
+    // Where this thread and its rows ended up
+    Placement *placement;
+    // Barrier to synchronize at
+    pthread_barrier_t *barrier;
+    // Variables needed for timing
+    int *counter;
+    pthread_mutex_t *mtx;
+    pthread_cond_t *cond;
+    high_resolution_clock::time_point *start;
+    high_resolution_clock::time_point *end;
+};
+
+// Pivot policy of the barrier version when every row is in the
+// matrix the threads share
+struct GeLocalPivots {
+    // Matrix of floating point numbers, and the distance between rows
+    float *matrix;
+    int ld;
+    // Barrier to synchronize at
+    pthread_barrier_t *barrier;
+
+    // The best candidate of the threads is the pivot
+    GePivot select(int /*tid*/, GePivot best){
+        return best;
+    }
+
+    // Pivot row i, once its owner has updated and normalized it
+    const float *row(int /*tid*/, GePivot best, int /*i*/, int /*k0*/){
+        // All threads must wait for pivot before continuing
+        pthread_barrier_wait(barrier);
+        return &matrix[(size_t)best.row * ld];
+    }
+};
+
+// Barrier version of Gaussian Elimination for one thread
+// Every thread offers its best remaining row for each pivot, and the
+// thread that owns the pivot updates and normalizes it. The pivot
+// policy picks the pivot from the best candidate of the threads and
+// hands out the pivot row, so the same loop also runs across MPI ranks
+// Takes the pivot policy, the dimension, the panel size, the
+// permutation vector, the thread ID, the number of threads, the
+// candidate slots, the row list of this thread (pointers and matrix row
+// numbers), and the packed LU flag as arguments
+template <typename Pivots>
+void ge_barrier_rows(Pivots &pivots, int N, int block_size, int *perm,
+        int tid, int num_threads, Candidate *candidates, float **rows,
+        int *ids, int num_rows, bool keep_lu = false){
+    // Pivot rows of a panel
+    const float **u_rows = new const float*[block_size];
+
+    // Index of the first row of this thread that is not a pivot yet
+    // (rows[0, done) are pivots, rows[done, num_rows) still remain)
+    int done = 0;
+
+    // Loop over all panels in the matrix
+    for(int k0 = 0; k0 < N; k0 += block_size){
+        int k1 = min(k0 + block_size, N);
+
+        // Loop over all pivots in the panel
+        for(int i = k0; i < k1; i++){
+            // Offer the best remaining row of this thread as the pivot
+            int pos;
+            candidates[tid].pivot = ge_find_pivot(&rows[done], &ids[done],
+                    num_rows - done, i, &pos);
+
+            // All threads must offer a candidate before picking one
+            pthread_barrier_wait(pivots.barrier);
+
+            // Every thread combines the candidates the same way
+            GePivot best = candidates[0].pivot;
+            for(int t = 1; t < num_threads; t++){
+                if(ge_better_pivot(candidates[t].pivot, best)){
+                    best = candidates[t].pivot;
+                }
+            }
+            best = pivots.select(tid, best);
+            if(tid == 0){
+                perm[i] = best.row;
+            }
+
+            // Check if pivot row belongs to this thread
+            if((pos >= 0) && (ids[done + pos] == best.row)){
+                // Move it to the pivots of this thread, then update and
+                // normalize this row to the pivot
+                ge_swap_rows(rows, ids, done, done + pos);
+                ge_factor_pivot_row(rows[done], u_rows, k0, k1, i, N,
+                        keep_lu);
+                done++;
+            }
+            u_rows[i - k0] = pivots.row(tid, best, i, k0);
+
+            // Eliminate the ith element from the panel columns of the
+            // remaining rows of this thread
+            ge_panel_update(&rows[done], num_rows - done, u_rows[i - k0], i,
+                    k1);
+        }
+
+        // Update the rest of the rows of this thread with the whole panel
+        ge_trailing_update(&rows[done], num_rows - done, u_rows, k0, k1, k1,
+                N);
+        if(!keep_lu){
+            ge_clear_multipliers(&rows[done], num_rows - done, k0, k1);
+        }
+    }
+
+    delete[] u_rows;
+}
+
+// Pthread function for computing Gaussian Elimination
+// Takes a pointer to a struct of args as an argument
+template <typename Mapping>
+void *ge_parallel(void *args){
+    // Cast void pointer to struct pointer
+    Args<Mapping> *local_args = (Args<Mapping>*)args;
+
+    // Unpack the arguments
+    int tid = local_args->tid;
+    int num_threads = local_args->num_threads;
+    float *matrix = local_args->matrix;
+    int N = local_args->N;
+    int ld = local_args->ld;
+    int block_size = local_args->block_size;
+    int *perm = local_args->perm;
+    Candidate *candidates = local_args->candidates;
+    bool lookahead = local_args->lookahead;
+    bool keep_lu = local_args->keep_lu;
+    pthread_barrier_t *barrier = local_args->barrier;
+
+    int *counter = local_args->counter;
+    pthread_mutex_t *mtx = local_args->mtx;
+    pthread_cond_t *cond = local_args->cond;
+    high_resolution_clock::time_point *start = local_args->start;
+    high_resolution_clock::time_point *end = local_args->end;
+
+    // Pointers to the rows of this thread
+    Mapping mapping = local_args->mapping;
+    int num_rows = mapping.num_rows(N, num_threads, tid);
+    float **rows = new float*[num_rows];
+    int *ids = new int[num_rows];
+    map_rows(mapping, matrix, N, num_threads, tid, rows, ids, ld);
+
+    // Touch our own rows first so their pages land on our NUMA node
+    for(int j = 0; j < num_rows; j++){
+        if(local_args->source != NULL){
+            memcpy(rows[j], &local_args->source[(size_t)ids[j] * N],
+                    N * sizeof(float));
+        }else{
+            ge_random_row(rows[j], ids[j], N, local_args->seed);
+        }
+    }
+
+    // Wait for all threads to be created before profiling
+    perf_cycle(num_threads, counter, mtx, cond, start);
+
+    if(lookahead){
+        // Threads wait on published pivot rows instead of barriers
+        ge_lookahead(local_args->la, matrix, N, N, block_size, perm, tid,
+                rows, ids, num_rows, ld);
+    }else{
+        // Threads pick each pivot between barriers
+        GeLocalPivots pivots = {matrix, ld, barrier};
+        ge_barrier_rows(pivots, N, block_size, perm, tid, num_threads,
+                candidates, rows, ids, num_rows, keep_lu);
+    }
+
+    // Stop monitoring when last thread exits
+    perf_cycle(num_threads, counter, mtx, cond, end);
+
+    // Report where this thread ran and where its rows are
+    record_placement(local_args->placement, rows, num_rows);
+
+    // Free heap-allocated memory
+    delete[] rows;
+    delete[] ids;
+
+    return 0;
+}
+
+// Helper function create thread
+// Returns the elapsed time of the parallel section in seconds
+template <typename Mapping>
+double launch_threads(Mapping mapping, int num_threads,
+        const GeMatrix<float> &matrix, int *perm,
+        int block_size = GE_BLOCK_SIZE, bool lookahead = false,
+        const float *source = NULL, const Affinity *affinity = NULL,
+        bool keep_lu = false, uint32_t seed = 0){
+    // Dimensions of the square matrix
+    int N = matrix.cols;
+
+    // Create array of thread objects we will launch
+    pthread_t *threads = new pthread_t[num_threads];
+
+    // Create a barrier and initialize it
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, num_threads);
+
+    // Create an array of structs to pass to the threads
+    Args<Mapping> *thread_args = new Args<Mapping>[num_threads];
+
+    // Create a slot for the pivot candidate of each thread
+    Candidate *candidates = ge_aligned_new<Candidate>(num_threads);
+
+    // Create the counters used by the lookahead pipeline
+    GeLookahead la;
+    ge_lookahead_init(&la, num_threads, keep_lu);
+
+    // Create space to record where each thread ended up
+    Placement *placements = new Placement[num_threads];
+
+    // Order the CPUs of the affinity policy once for every thread
+    std::vector<int> cpu_order = affinity_order(affinity);
+
+    // Create variables for performance monitoring
+    int counter = num_threads;
+    pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    high_resolution_clock::time_point start;
+    high_resolution_clock::time_point end;
+
+    // Launch threads
+    for(int i = 0; i < num_threads; i++){
+        // Pack struct with its arguments
+        thread_args[i].tid = i;
+        thread_args[i].num_threads = num_threads;
+        thread_args[i].mapping = mapping;
+        thread_args[i].matrix = matrix.data;
+        thread_args[i].N = N;
+        thread_args[i].ld = matrix.ld;
+        thread_args[i].block_size = block_size;
+        thread_args[i].perm = perm;
+        thread_args[i].candidates = candidates;
+        thread_args[i].lookahead = lookahead;
+        thread_args[i].keep_lu = keep_lu;
+        thread_args[i].la = &la;
+        thread_args[i].source = source;
+        thread_args[i].seed = seed;
+        thread_args[i].placement = &placements[i];
+        thread_args[i].barrier = &barrier;
+
+        thread_args[i].counter = &counter;
+        thread_args[i].mtx = &mtx;
+        thread_args[i].cond = &cond;
+        thread_args[i].start = &start;
+        thread_args[i].end = &end;
+
+        // Launch the thread, pinned by the affinity policy
+        start_thread(&threads[i], ge_parallel<Mapping>,
+                (void*)&thread_args[i], affinity_cpu(cpu_order, i));
+    }
+
+    for(int i = 0; i < num_threads; i++){
+        pthread_join(threads[i], NULL);
+    }
+
+    // Print where the threads and their rows ended up
+    if(affinity != NULL){
+        print_placement(placements, num_threads);
+    }
+
+    delete[] threads;
+    delete[] thread_args;
+    ge_aligned_delete(candidates, num_threads);
+    delete[] placements;
+    ge_lookahead_destroy(&la);
+
+    // Cast timers as double to return
+    duration<double> elapsed = duration_cast<duration<double>>(end - start);
+    return elapsed.count();
+}
+
+#endif
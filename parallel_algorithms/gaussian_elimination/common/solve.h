@@ -0,0 +1,131 @@
+// This file contains the solve (Ax = b) building blocks shared by the
+// serial and pthread versions. Systems are solved on an augmented
+// matrix [A | B] with nrhs right-hand sides: elimination of the extra
+// columns does the forward substitution, then back substitution against
+// the unit upper-triangular U leaves the solution in place of B
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_SOLVE_H
+#define GE_SOLVE_H
+
+#include <algorithm>
+#include <cstring>
+#include "blocked.h"
+
+// Builds the list of pivot rows of an eliminated augmented matrix
+// Takes the matrix, the length of each row, the permutation vector, the
+// number of pivots, and the list to fill (rows[i] is pivot row i) as
+// arguments
+template <typename T>
+void ge_pivot_rows(T *matrix, int ncols, const int *perm, int n, T **rows){
+    for(int i = 0; i < n; i++){
+        rows[i] = &matrix[(size_t)perm[i] * ncols];
+    }
+}
+
+// Back substitution inside the diagonal block [b0, b1) of U
+// Only right-hand side columns [c0, c1) are touched
+// Takes the pivot rows, the block range, and the column range as
+// arguments
+template <typename T>
+void ge_solve_diagonal(T **rows, int b0, int b1, int c0, int c1){
+    for(int i = b1 - 1; i > b0; i--){
+        for(int r = b0; r < i; r++){
+            ge_eliminate(&rows[r][c0], &rows[i][c0], rows[r][i],
+                    c1 - c0);
+        }
+    }
+}
+
+// Removes the solved block [b0, b1) from pivot rows [r0, r1) above it
+// The entries of U in columns [b0, b1) are the multipliers, so this is
+// the same tiled update as the trailing update of elimination
+// Takes the pivot rows, the rows to update, the solved block, and the
+// column range as arguments
+template <typename T>
+void ge_solve_update(T **rows, int r0, int r1, int b0, int b1, int c0,
+        int c1){
+    ge_trailing_update(&rows[r0], r1 - r0, (const T**)&rows[b0], b0,
+            b1, c0, c1);
+}
+
+// Blocked back substitution for right-hand side columns [c0, c1)
+// Blocks of U are solved bottom up, and each solved block is applied to
+// every row above it at once, so all right-hand sides share each pass
+// over U
+// Takes the pivot rows, the number of pivots, the column range, and the
+// block size as arguments
+template <typename T>
+void ge_back_substitution(T **rows, int n, int c0, int c1, int block_size){
+    for(int b0 = ((n - 1) / block_size) * block_size; b0 >= 0;
+            b0 -= block_size){
+        int b1 = std::min(b0 + block_size, n);
+        ge_solve_diagonal(rows, b0, b1, c0, c1);
+        ge_solve_update(rows, 0, b0, b0, b1, c0, c1);
+    }
+}
+
+// Serial solve of an augmented matrix [A | B] (n x (n + nrhs))
+// Row perm[i] of the result holds x_i in columns [n, n + nrhs)
+// Takes the augmented matrix, the number of equations, the number of
+// right-hand sides, the permutation vector, and the block size as
+// arguments
+template <typename T>
+void ge_serial_solve(T *matrix, int n, int nrhs, int *perm,
+        int block_size = GE_BLOCK_SIZE){
+    int ncols = n + nrhs;
+
+    // Eliminate A, and forward substitute B along with it
+    ge_blocked(matrix, n, ncols, perm, block_size);
+
+    // Back substitute every right-hand side together
+    T **rows = new T*[n];
+    ge_pivot_rows(matrix, ncols, perm, n, rows);
+    ge_back_substitution(rows, n, n, ncols, block_size);
+    delete[] rows;
+}
+
+// Packs A (n x n) and B (n x nrhs) into an augmented matrix
+// Takes the augmented matrix to fill, A, B, and the dimensions as
+// arguments
+template <typename T>
+void ge_augment(T *matrix, const T *A, const T *B, int n, int nrhs){
+    int ncols = n + nrhs;
+    for(int i = 0; i < n; i++){
+        memcpy(&matrix[(size_t)i * ncols], &A[(size_t)i * n],
+                n * sizeof(T));
+        memcpy(&matrix[(size_t)i * ncols + n], &B[(size_t)i * nrhs],
+                nrhs * sizeof(T));
+    }
+}
+
+// Copies the solution X (n x nrhs) out of a solved augmented matrix
+// Takes X, the solved matrix, the permutation vector, and the
+// dimensions as arguments
+template <typename T>
+void ge_extract_solution(T *X, const T *matrix, const int *perm,
+        int n, int nrhs){
+    int ncols = n + nrhs;
+    for(int i = 0; i < n; i++){
+        memcpy(&X[(size_t)i * nrhs], &matrix[(size_t)perm[i] * ncols + n],
+                nrhs * sizeof(T));
+    }
+}
+
+// Serial solve of AX = B with a separate right-hand side block
+// A and B are left unchanged
+// Takes A (n x n), B (n x nrhs), X (n x nrhs) of any element type, and
+// the dimensions as arguments
+template <typename T>
+void ge_serial_solve(const T *A, const T *B, T *X, int n,
+        int nrhs, int block_size = GE_BLOCK_SIZE){
+    T *matrix = new T[(size_t)n * (n + nrhs)];
+    int *perm = new int[n];
+    ge_augment(matrix, A, B, n, nrhs);
+    ge_serial_solve(matrix, n, nrhs, perm, block_size);
+    ge_extract_solution(X, matrix, perm, n, nrhs);
+    delete[] matrix;
+    delete[] perm;
+}
+
+#endif
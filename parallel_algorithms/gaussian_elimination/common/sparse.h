@@ -0,0 +1,279 @@
+// This file contains compressed sparse row (CSR) and column (CSC)
+// storage, a Matrix Market reader, and a random sparse test matrix
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_SPARSE_H
+#define GE_SPARSE_H
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "random.h"
+#include "verify.h"
+
+// n x n sparse matrix in compressed form
+// As CSR, ptr runs over rows and idx holds columns. As CSC, ptr runs
+// over columns and idx holds rows. Indices are sorted within each row
+// (or column) and appear once
+struct GeCsr {
+    int n;
+    int nnz;
+    int *ptr;
+    int *idx;
+    float *val;
+};
+
+// Allocates a sparse matrix
+// Takes the matrix, the dimension, and the number of nonzeros as
+// arguments
+void ge_csr_init(GeCsr *a, int n, int nnz){
+    a->n = n;
+    a->nnz = nnz;
+    a->ptr = new int[n + 1];
+    a->idx = new int[nnz];
+    a->val = new float[nnz];
+}
+
+// Frees a sparse matrix
+void ge_csr_destroy(GeCsr *a){
+    delete[] a->ptr;
+    delete[] a->idx;
+    delete[] a->val;
+}
+
+// Transposes a sparse matrix (CSR to CSC, or CSC to CSR of the same
+// matrix)
+// Takes the matrix, the output, and where to store the entry of a each
+// output entry came from (NULL if not needed) as arguments
+void ge_csr_transpose(const GeCsr *a, GeCsr *t, int *src){
+    int n = a->n;
+    ge_csr_init(t, n, a->nnz);
+
+    // Count the entries of each output row, then turn counts into starts
+    memset(t->ptr, 0, (n + 1) * sizeof(int));
+    for(int e = 0; e < a->nnz; e++){
+        t->ptr[a->idx[e] + 1]++;
+    }
+    for(int i = 0; i < n; i++){
+        t->ptr[i + 1] += t->ptr[i];
+    }
+
+    // Going through a in order keeps the output indices sorted
+    int *next = new int[n];
+    memcpy(next, t->ptr, n * sizeof(int));
+    for(int i = 0; i < n; i++){
+        for(int e = a->ptr[i]; e < a->ptr[i + 1]; e++){
+            int pos = next[a->idx[e]]++;
+            t->idx[pos] = i;
+            t->val[pos] = a->val[e];
+            if(src != NULL){
+                src[pos] = e;
+            }
+        }
+    }
+    delete[] next;
+}
+
+// Builds a CSR matrix from (row, column, value) entries
+// Duplicate entries are added together
+// Takes the matrix, the dimension, and the entries as arguments
+void ge_csr_from_entries(GeCsr *a, int n,
+        std::vector<std::pair<std::pair<int, int>, float> > &entries){
+    std::sort(entries.begin(), entries.end(),
+            [](const std::pair<std::pair<int, int>, float> &x,
+                const std::pair<std::pair<int, int>, float> &y){
+                return x.first < y.first;
+            });
+
+    // Count the distinct entries
+    int nnz = 0;
+    for(size_t e = 0; e < entries.size(); e++){
+        if((e == 0) || (entries[e].first != entries[e - 1].first)){
+            nnz++;
+        }
+    }
+
+    ge_csr_init(a, n, nnz);
+    memset(a->ptr, 0, (n + 1) * sizeof(int));
+    int pos = -1;
+    for(size_t e = 0; e < entries.size(); e++){
+        if((e == 0) || (entries[e].first != entries[e - 1].first)){
+            pos++;
+            a->idx[pos] = entries[e].first.second;
+            a->val[pos] = 0;
+            a->ptr[entries[e].first.first + 1]++;
+        }
+        a->val[pos] += entries[e].second;
+    }
+    for(int i = 0; i < n; i++){
+        a->ptr[i + 1] += a->ptr[i];
+    }
+}
+
+// Reads a square matrix from a Matrix Market coordinate file (real,
+// integer, or pattern entries, general or symmetric)
+// Takes the path and the matrix as arguments
+// Returns false if the file could not be read, or has an index outside
+// the matrix
+bool ge_sparse_read(const char *path, GeCsr *a){
+    FILE *f = fopen(path, "r");
+    if(f == NULL){
+        return false;
+    }
+
+    // Banner, then comments, then the size line
+    char line[1024];
+    if(fgets(line, sizeof(line), f) == NULL ||
+            strncmp(line, "%%MatrixMarket matrix coordinate", 32) != 0){
+        fclose(f);
+        return false;
+    }
+    bool pattern = (strstr(line, "pattern") != NULL);
+    bool symmetric = (strstr(line, "symmetric") != NULL);
+    do{
+        if(fgets(line, sizeof(line), f) == NULL){
+            fclose(f);
+            return false;
+        }
+    }while(line[0] == '%');
+    int rows;
+    int cols;
+    long count;
+    if((sscanf(line, "%d %d %ld", &rows, &cols, &count) != 3) ||
+            (rows != cols) || (rows < 1) || (count < 0)){
+        fclose(f);
+        return false;
+    }
+
+    // Entries are 1-based, symmetric files only list the lower half
+    std::vector<std::pair<std::pair<int, int>, float> > entries;
+    for(long e = 0; e < count; e++){
+        int i;
+        int j;
+        double v = 1;
+        if(fgets(line, sizeof(line), f) == NULL ||
+                sscanf(line, "%d %d %lf", &i, &j, &v) < (pattern ? 2 : 3) ||
+                (i < 1) || (i > rows) || (j < 1) || (j > rows)){
+            fclose(f);
+            return false;
+        }
+        entries.push_back({{i - 1, j - 1}, (float)v});
+        if(symmetric && (i != j)){
+            entries.push_back({{j - 1, i - 1}, (float)v});
+        }
+    }
+    fclose(f);
+
+    ge_csr_from_entries(a, rows, entries);
+    return true;
+}
+
+// Fills a random sparse matrix with the pattern of a 2D grid (5-point
+// stencil on a grid about sqrt(N) wide) plus the neighbor down and to
+// the right of each point, so the pattern is not symmetric
+// The pattern only depends on N, and each value is the element of the
+// random dense matrix of the seed at that position. The diagonal is made
+// larger than the rest of its row, so the diagonal pivots are stable
+// Takes the matrix, the dimension, and the seed as arguments
+void ge_random_sparse(GeCsr *a, int N, uint32_t seed){
+    int width = (int)std::ceil(std::sqrt((double)N));
+    std::vector<std::pair<std::pair<int, int>, float> > entries;
+    for(int i = 0; i < N; i++){
+        // Columns of this row
+        int cols[6] = {i, i - 1, i + 1, i - width, i + width,
+            i + width + 1};
+        if(i % width == 0){
+            cols[1] = -1;
+        }
+        if(i % width == width - 1){
+            cols[2] = -1;
+            cols[5] = -1;
+        }
+
+        // Off-diagonal values, and the sum of their magnitudes
+        float sum = 0;
+        for(int c = 1; c < 6; c++){
+            int j = cols[c];
+            if((j < 0) || (j >= N)){
+                continue;
+            }
+            float v;
+            ge_random_cols(&v, i, j, j + 1, seed);
+            entries.push_back({{i, j}, v});
+            sum += std::fabs(v);
+        }
+
+        // Diagonal, with the sign of the random element
+        float d;
+        ge_random_cols(&d, i, i, i + 1, seed);
+        entries.push_back({{i, i}, std::copysign(sum + std::fabs(d), d)});
+    }
+    ge_csr_from_entries(a, N, entries);
+}
+
+// Copies a sparse matrix into a dense one
+// Takes the sparse matrix and the dense matrix as arguments
+void ge_sparse_to_dense(const GeCsr *a, float *dense){
+    int n = a->n;
+    memset(dense, 0, (size_t)n * n * sizeof(float));
+    for(int i = 0; i < n; i++){
+        for(int e = a->ptr[i]; e < a->ptr[i + 1]; e++){
+            dense[(size_t)i * n + a->idx[e]] = a->val[e];
+        }
+    }
+}
+
+// Computes r = b - A x in double
+// Takes the matrix, x, b, and r as arguments
+// Returns the normwise backward error ||r|| / (||A|| ||x|| + ||b||) in
+// the infinity norm
+double ge_sparse_residual_vector(const GeCsr *a, const double *x,
+        const double *b, double *r){
+    double r_norm = 0;
+    double norm = 0;
+    double x_norm = 0;
+    double b_norm = 0;
+    for(int i = 0; i < a->n; i++){
+        double sum = b[i];
+        double abs_sum = 0;
+        for(int e = a->ptr[i]; e < a->ptr[i + 1]; e++){
+            sum -= (double)a->val[e] * x[a->idx[e]];
+            abs_sum += std::fabs(a->val[e]);
+        }
+        r[i] = sum;
+        r_norm = ge_max_error(r_norm, std::fabs(sum));
+        norm = ge_max_error(norm, abs_sum);
+        x_norm = ge_max_error(x_norm, std::fabs(x[i]));
+        b_norm = ge_max_error(b_norm, std::fabs(b[i]));
+    }
+    return ge_relative_error(r_norm, norm * x_norm + b_norm);
+}
+
+// Checks the solution of Ax = b:
+// ||A x - b|| / (||A|| ||x|| + ||b||) in the infinity norm
+// Takes the matrix, the solution, and the right-hand side as arguments
+// Returns the relative residual
+double ge_sparse_residual(const GeCsr *a, const float *x, const float *b){
+    double error = 0;
+    double norm = 0;
+    double x_norm = 0;
+    double b_norm = 0;
+    for(int i = 0; i < a->n; i++){
+        double r = -b[i];
+        double abs_sum = 0;
+        for(int e = a->ptr[i]; e < a->ptr[i + 1]; e++){
+            r += (double)a->val[e] * x[a->idx[e]];
+            abs_sum += std::fabs(a->val[e]);
+        }
+        error = ge_max_error(error, std::fabs(r));
+        norm = ge_max_error(norm, abs_sum);
+        x_norm = ge_max_error(x_norm, std::fabs(x[i]));
+        b_norm = ge_max_error(b_norm, std::fabs(b[i]));
+    }
+    return ge_relative_error(error, norm * x_norm + b_norm);
+}
+
+#endif
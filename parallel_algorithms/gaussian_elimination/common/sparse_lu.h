@@ -0,0 +1,398 @@
+// This file contains sparse LU factorization in three steps:
+// ordering, symbolic analysis, and numeric factorization
+// The symbolic analysis only depends on the pattern of the matrix (and
+// the row matching on the values it was done with), so it is done once
+// and reused for every matrix with the same pattern. The
+// numeric factorization is left-looking over the elimination tree: node
+// k only reads the finished nodes below it, so separate subtrees can be
+// factored by separate threads
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_SPARSE_LU_H
+#define GE_SPARSE_LU_H
+
+#include <cfloat>
+#include "sparse.h"
+#include "amd.h"
+#include "matching.h"
+
+// Fill-reducing orderings
+enum GeOrdering {
+    // Rows and columns in their original order
+    GE_ORDER_NATURAL,
+    // Approximate minimum degree on A + A^T
+    GE_ORDER_AMD
+};
+
+// Everything about the factorization that only depends on the pattern
+// The rows of A are first matched to its columns, so A' = Q A has large
+// entries on its diagonal (row j of A' is row row_perm[j] of A). The
+// factor is B = P A' P^T = L U, where row and column k of B are row and
+// column perm[k] of A'. It uses the pattern of B + B^T, so column k of L
+// below the diagonal and row k of U right of it share one index list,
+// and the pivots stay on the diagonal (no row pivoting after the
+// matching)
+struct GeSparseSymbolic {
+    int n;
+    // Row of A matched to each column, and its inverse
+    std::vector<int> row_perm;
+    std::vector<int> row_iperm;
+    // Order of the rows and columns, and its inverse
+    std::vector<int> perm;
+    std::vector<int> iperm;
+    // Parent of each node in the elimination tree (-1 for a root), and
+    // the number of children
+    std::vector<int> parent;
+    std::vector<int> num_children;
+    // Rows of column k of L below the diagonal (sorted), in
+    // idx[ptr[k], ptr[k + 1])
+    std::vector<int> ptr;
+    std::vector<int> idx;
+    // Columns j of row k of L left of the diagonal in
+    // row_col[row_ptr[k], row_ptr[k + 1]), and where k is in the list of
+    // column j
+    std::vector<int> row_ptr;
+    std::vector<int> row_col;
+    std::vector<int> row_pos;
+    // Columns of A (CSC), and the CSR entry of A each one came from
+    GeCsr csc;
+    std::vector<int> csc_src;
+};
+
+// Values of a factorization on the pattern of its symbolic analysis
+// L holds the pivots on its diagonal, U has a unit diagonal
+struct GeSparseNumeric {
+    // Pivots, L below the diagonal, and U right of it
+    std::vector<float> diag;
+    std::vector<float> lx;
+    std::vector<float> ux;
+    // Pivots smaller than this were replaced by it (static pivoting),
+    // and which ones were
+    float tiny;
+    std::vector<char> perturbed;
+};
+
+// Finds the row matching, order, elimination tree, and pattern of the
+// factors
+// Takes the matrix (only the matching uses its values), the ordering,
+// and the analysis to fill in as arguments
+// Returns the number of columns matched by nonzero entries (less than
+// the dimension if the matrix is structurally singular)
+int ge_sparse_analyze(const GeCsr *a, GeOrdering ordering,
+        GeSparseSymbolic *s){
+    int n = a->n;
+    s->n = n;
+    s->csc_src.resize(a->nnz);
+    ge_csr_transpose(a, &s->csc, s->csc_src.data());
+
+    // Match the rows to the columns
+    s->row_perm.resize(n);
+    s->row_iperm.resize(n);
+    int matched = ge_max_matching(n, s->csc.ptr, s->csc.idx, s->csc.val,
+            s->row_perm.data());
+    for(int j = 0; j < n; j++){
+        s->row_iperm[s->row_perm[j]] = j;
+    }
+
+    // Order the rows and columns of A' (its pattern is the rows of A in
+    // matched order)
+    s->perm.resize(n);
+    s->iperm.resize(n);
+    if(ordering == GE_ORDER_AMD){
+        std::vector<int> q_ptr(n + 1, 0);
+        std::vector<int> q_idx(a->nnz);
+        for(int j = 0; j < n; j++){
+            int row = s->row_perm[j];
+            std::copy(&a->idx[a->ptr[row]], &a->idx[a->ptr[row + 1]],
+                    &q_idx[q_ptr[j]]);
+            q_ptr[j + 1] = q_ptr[j] + a->ptr[row + 1] - a->ptr[row];
+        }
+        ge_amd(n, q_ptr.data(), q_idx.data(), s->perm.data());
+    }else{
+        for(int k = 0; k < n; k++){
+            s->perm[k] = k;
+        }
+    }
+    for(int k = 0; k < n; k++){
+        s->iperm[s->perm[k]] = k;
+    }
+
+    // Nodes j < k next to node k in B + B^T (row k of B left of the
+    // diagonal, and column k of B above it)
+    std::vector<int> below_ptr(n + 1, 0);
+    std::vector<int> below;
+    for(int k = 0; k < n; k++){
+        int old = s->perm[k];
+        int row = s->row_perm[old];
+        for(int e = a->ptr[row]; e < a->ptr[row + 1]; e++){
+            if(s->iperm[a->idx[e]] < k){
+                below.push_back(s->iperm[a->idx[e]]);
+            }
+        }
+        for(int e = s->csc.ptr[old]; e < s->csc.ptr[old + 1]; e++){
+            int i = s->iperm[s->row_iperm[s->csc.idx[e]]];
+            if(i < k){
+                below.push_back(i);
+            }
+        }
+        below_ptr[k + 1] = (int)below.size();
+    }
+
+    // Elimination tree (Liu), with path compression through ancestor
+    s->parent.assign(n, -1);
+    s->num_children.assign(n, 0);
+    std::vector<int> ancestor(n, -1);
+    for(int k = 0; k < n; k++){
+        for(int t = below_ptr[k]; t < below_ptr[k + 1]; t++){
+            int j = below[t];
+            while((j != -1) && (j != k)){
+                int next = ancestor[j];
+                ancestor[j] = k;
+                if(next == -1){
+                    s->parent[j] = k;
+                    s->num_children[k]++;
+                }
+                j = next;
+            }
+        }
+    }
+
+    // Row k of L holds the nodes on the tree paths from each j < k next
+    // to k up to k (the row subtree of k)
+    std::vector<int> mark(n, -1);
+    std::vector<int> count(n, 0);
+    s->row_ptr.assign(n + 1, 0);
+    s->row_col.clear();
+    for(int k = 0; k < n; k++){
+        mark[k] = k;
+        for(int t = below_ptr[k]; t < below_ptr[k + 1]; t++){
+            for(int j = below[t]; mark[j] != k; j = s->parent[j]){
+                mark[j] = k;
+                s->row_col.push_back(j);
+            }
+        }
+        s->row_ptr[k + 1] = (int)s->row_col.size();
+    }
+
+    // Columns of L are the transpose of the rows. Going through the
+    // rows in order keeps each column sorted
+    s->ptr.assign(n + 1, 0);
+    for(size_t t = 0; t < s->row_col.size(); t++){
+        s->ptr[s->row_col[t] + 1]++;
+    }
+    for(int k = 0; k < n; k++){
+        s->ptr[k + 1] += s->ptr[k];
+    }
+    s->idx.resize(s->row_col.size());
+    s->row_pos.resize(s->row_col.size());
+    for(int k = 0; k < n; k++){
+        for(int t = s->row_ptr[k]; t < s->row_ptr[k + 1]; t++){
+            int j = s->row_col[t];
+            s->row_pos[t] = count[j];
+            s->idx[s->ptr[j] + count[j]++] = k;
+        }
+    }
+    return matched;
+}
+
+// Frees an analysis
+void ge_sparse_symbolic_destroy(GeSparseSymbolic *s){
+    ge_csr_destroy(&s->csc);
+}
+
+// Number of nonzeros of L + U (counting the diagonal once)
+// Takes the analysis as an argument
+long ge_sparse_factor_nnz(const GeSparseSymbolic *s){
+    return s->n + 2 * (long)s->idx.size();
+}
+
+// Operations of the numeric factorization, from the nonzeros of L + U
+// Column k of L and row k of U share c_k indices, so node k takes c_k
+// divisions, and its later nodes subtract c_k^2 products from each of L
+// and U (2 c_k^2 + c_k in all)
+// Takes the analysis as an argument
+double ge_sparse_flops(const GeSparseSymbolic *s){
+    double flops = 0;
+    for(int k = 0; k < s->n; k++){
+        double c = s->ptr[k + 1] - s->ptr[k];
+        flops += 2 * c * c + c;
+    }
+    return flops;
+}
+
+// Allocates the values of a factorization of a
+// Takes the analysis, the matrix, and the factorization as arguments
+void ge_sparse_numeric_init(const GeSparseSymbolic *s, const GeCsr *a,
+        GeSparseNumeric *f){
+    f->diag.assign(s->n, 0);
+    f->lx.assign(s->idx.size(), 0);
+    f->ux.assign(s->idx.size(), 0);
+    f->perturbed.assign(s->n, 0);
+
+    // Pivots are kept at least sqrt(eps) times the largest entry
+    float largest = 0;
+    for(int e = 0; e < a->nnz; e++){
+        largest = std::max(largest, std::fabs(a->val[e]));
+    }
+    f->tiny = std::sqrt(FLT_EPSILON) * largest;
+}
+
+// Factors node k (column k of L and row k of U)
+// Every node j < k with L(k, j) != 0 must be done already
+// Takes the analysis, the matrix, the factorization, the node, and two
+// zeroed work vectors of length n (left zeroed) as arguments
+void ge_sparse_node(const GeSparseSymbolic *s, const GeCsr *a,
+        GeSparseNumeric *f, int k, float *x, float *y){
+    const int *ptr = s->ptr.data();
+    const int *idx = s->idx.data();
+    float *lx = f->lx.data();
+    float *ux = f->ux.data();
+
+    // Column k of B on and below the diagonal, and row k right of it
+    int old = s->perm[k];
+    for(int e = s->csc.ptr[old]; e < s->csc.ptr[old + 1]; e++){
+        int i = s->iperm[s->row_iperm[s->csc.idx[e]]];
+        if(i >= k){
+            x[i] += a->val[s->csc_src[e]];
+        }
+    }
+    int row = s->row_perm[old];
+    for(int e = a->ptr[row]; e < a->ptr[row + 1]; e++){
+        int i = s->iperm[a->idx[e]];
+        if(i > k){
+            y[i] += a->val[e];
+        }
+    }
+
+    // Subtract L(:, j) U(j, k) and L(k, j) U(j, :) for every earlier
+    // node j in row k of L
+    for(int t = s->row_ptr[k]; t < s->row_ptr[k + 1]; t++){
+        int j = s->row_col[t];
+        int p = ptr[j] + s->row_pos[t];
+        float l_kj = lx[p];
+        float u_jk = ux[p];
+        x[k] -= l_kj * u_jk;
+        for(int q = p + 1; q < ptr[j + 1]; q++){
+            x[idx[q]] -= lx[q] * u_jk;
+            y[idx[q]] -= l_kj * ux[q];
+        }
+    }
+
+    // Pivot (replaced if it is too small), then gather the column of L
+    // and the normalized row of U
+    float d = x[k];
+    if(std::fabs(d) < f->tiny){
+        d = std::copysign(f->tiny, d);
+        f->perturbed[k] = 1;
+    }
+    f->diag[k] = d;
+    x[k] = 0;
+    for(int q = ptr[k]; q < ptr[k + 1]; q++){
+        lx[q] = x[idx[q]];
+        ux[q] = y[idx[q]] / d;
+        x[idx[q]] = 0;
+        y[idx[q]] = 0;
+    }
+}
+
+// Factors a matrix with an existing analysis (serial)
+// Takes the analysis, the matrix, and the factorization as arguments
+void ge_sparse_factor(const GeSparseSymbolic *s, const GeCsr *a,
+        GeSparseNumeric *f){
+    ge_sparse_numeric_init(s, a, f);
+    std::vector<float> x(s->n, 0);
+    std::vector<float> y(s->n, 0);
+    for(int k = 0; k < s->n; k++){
+        ge_sparse_node(s, a, f, k, x.data(), y.data());
+    }
+}
+
+// Number of pivots that were replaced
+// Takes the factorization as an argument
+int ge_sparse_perturbed(const GeSparseNumeric *f){
+    int count = 0;
+    for(size_t k = 0; k < f->perturbed.size(); k++){
+        count += f->perturbed[k];
+    }
+    return count;
+}
+
+// Solves A x = b in place with the factors
+// Takes the analysis, the factorization, and b (replaced by x) as
+// arguments
+void ge_sparse_lu_solve(const GeSparseSymbolic *s, const GeSparseNumeric *f,
+        double *x){
+    int n = s->n;
+    const int *ptr = s->ptr.data();
+    const int *idx = s->idx.data();
+    std::vector<double> z(n);
+    for(int k = 0; k < n; k++){
+        z[k] = x[s->row_perm[s->perm[k]]];
+    }
+
+    // L z = P Q b, a column at a time
+    for(int k = 0; k < n; k++){
+        z[k] /= f->diag[k];
+        for(int q = ptr[k]; q < ptr[k + 1]; q++){
+            z[idx[q]] -= f->lx[q] * z[k];
+        }
+    }
+
+    // U (P x) = z, a row at a time (U has a unit diagonal)
+    for(int k = n - 1; k >= 0; k--){
+        for(int q = ptr[k]; q < ptr[k + 1]; q++){
+            z[k] -= f->ux[q] * z[idx[q]];
+        }
+    }
+
+    for(int k = 0; k < n; k++){
+        x[s->perm[k]] = z[k];
+    }
+}
+
+// Largest backward error ge_sparse_solve accepts (about float
+// precision, since the solution is returned in float)
+const double GE_SPARSE_TOL = FLT_EPSILON;
+
+// Solves A x = b with the factors
+// The solution is refined with residual corrections in double until its
+// backward error reaches GE_SPARSE_TOL (replaced pivots make the factors
+// inexact). Refinement stops early if the error is not shrinking
+// Takes the analysis, the factorization, the matrix, b, x, and the most
+// corrections to apply as arguments
+// Returns false if the backward error did not reach GE_SPARSE_TOL
+bool ge_sparse_solve(const GeSparseSymbolic *s, const GeSparseNumeric *f,
+        const GeCsr *a, const float *b, float *x, int max_refine = 10){
+    int n = s->n;
+    std::vector<double> xd(b, b + n);
+    std::vector<double> bd(b, b + n);
+    std::vector<double> r(n);
+    ge_sparse_lu_solve(s, f, xd.data());
+    bool converged = false;
+    double previous = INFINITY;
+    for(int it = 0; ; it++){
+        double error = ge_sparse_residual_vector(a, xd.data(), bd.data(),
+                r.data());
+        if(error <= GE_SPARSE_TOL){
+            converged = true;
+            break;
+        }
+
+        // Give up if the error is not shrinking (or is not a number)
+        if(!(error < previous) || (it == max_refine)){
+            break;
+        }
+        previous = error;
+
+        ge_sparse_lu_solve(s, f, r.data());
+        for(int i = 0; i < n; i++){
+            xd[i] += r[i];
+        }
+    }
+    for(int i = 0; i < n; i++){
+        x[i] = (float)xd[i];
+    }
+    return converged;
+}
+
+#endif
@@ -0,0 +1,251 @@
+// This file contains checks of a factorization or solution that need
+// O(N^2) work and no reference solve. They run in parallel over rows and
+// report a relative error instead of aborting
+// By: Nick from CoffeeBeforeArch
+
+#ifndef GE_VERIFY_H
+#define GE_VERIFY_H
+
+#include <pthread.h>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include "random.h"
+#include "affinity.h"
+
+// Larger of the error so far and a new one. Anything not finite counts
+// as an infinite error (std::max would drop a NaN, and a broken result
+// would read as a small error)
+// Takes the error so far and the new error as arguments
+// Returns the larger error
+inline double ge_max_error(double error, double e){
+    if(!std::isfinite(e)){
+        return std::numeric_limits<double>::infinity();
+    }
+    return std::max(error, e);
+}
+
+// Error relative to a scale, which stays infinite if the error is
+// Takes the error and the scale as arguments
+// Returns the relative error
+inline double ge_relative_error(double error, double scale){
+    return std::isinf(error) ? error : error / scale;
+}
+
+// Rows checked by one thread, and what it found
+struct GeVerifyArgs {
+    // Original matrix (NULL to make its rows again from the seed), and
+    // the packed LU or the solution
+    const float *A;
+    uint32_t seed;
+    const float *result;
+    // Permutation of the factorization, or the right-hand sides
+    const int *perm;
+    const float *B;
+    // Dimension, number of right-hand sides, and distance between the
+    // rows of the result
+    int N;
+    int nrhs;
+    int ld;
+    // Random vector and U times it (shared by all threads)
+    const double *v;
+    double *y;
+    // Rows of this thread
+    int first;
+    int last;
+    // Barrier between the two passes of the LU check
+    pthread_barrier_t *barrier;
+    // Largest error, and largest row sums of |A|, |X|, and |B| in these
+    // rows
+    double error;
+    double norm;
+    double x_norm;
+    double b_norm;
+};
+
+// Pthread function for the LU check (row perm[i] of the result holds
+// row i of L left of the diagonal and the pivot on it, and row i of U
+// right of it)
+// Computes y = U v for its rows, then compares row i of L y with row
+// perm[i] of A v
+// Takes a pointer to a struct of args as an argument
+void *ge_verify_lu_rows(void *args){
+    GeVerifyArgs *a = (GeVerifyArgs*)args;
+    int N = a->N;
+
+    // y = U v (U has a unit diagonal)
+    for(int i = a->first; i < a->last; i++){
+        const float *row = &a->result[(size_t)a->perm[i] * a->ld];
+        double sum = a->v[i];
+        for(int j = i + 1; j < N; j++){
+            sum += (double)row[j] * a->v[j];
+        }
+        a->y[i] = sum;
+    }
+    pthread_barrier_wait(a->barrier);
+
+    // L y against P A v
+    float *a_made = a->A ? NULL : new float[N];
+    a->error = 0;
+    a->norm = 0;
+    for(int i = a->first; i < a->last; i++){
+        const float *row = &a->result[(size_t)a->perm[i] * a->ld];
+        const float *a_row = a_made;
+        if(a->A){
+            a_row = &a->A[(size_t)a->perm[i] * N];
+        }else{
+            ge_random_row(a_made, a->perm[i], N, a->seed);
+        }
+        double ly = 0;
+        for(int j = 0; j <= i; j++){
+            ly += (double)row[j] * a->y[j];
+        }
+        double av = 0;
+        double abs_sum = 0;
+        for(int j = 0; j < N; j++){
+            av += (double)a_row[j] * a->v[j];
+            abs_sum += std::fabs(a_row[j]);
+        }
+        a->error = ge_max_error(a->error, std::fabs(av - ly));
+        a->norm = ge_max_error(a->norm, abs_sum);
+    }
+    delete[] a_made;
+    return 0;
+}
+
+// Pthread function for the solution check
+// Computes rows of A X - B, and the row sums of |A|, |X|, and |B|
+// Takes a pointer to a struct of args as an argument
+void *ge_verify_solve_rows(void *args){
+    GeVerifyArgs *a = (GeVerifyArgs*)args;
+    int N = a->N;
+    int nrhs = a->nrhs;
+
+    a->error = 0;
+    a->norm = 0;
+    a->x_norm = 0;
+    a->b_norm = 0;
+    double *r = new double[nrhs];
+    for(int i = a->first; i < a->last; i++){
+        // Row i of A X - B, going along the rows of X
+        const float *a_row = &a->A[(size_t)i * N];
+        const float *b_row = &a->B[(size_t)i * nrhs];
+        double abs_sum = 0;
+        for(int k = 0; k < nrhs; k++){
+            r[k] = -b_row[k];
+        }
+        for(int j = 0; j < N; j++){
+            const float *x_row = &a->result[(size_t)j * nrhs];
+            for(int k = 0; k < nrhs; k++){
+                r[k] += (double)a_row[j] * x_row[k];
+            }
+            abs_sum += std::fabs(a_row[j]);
+        }
+
+        const float *x_row = &a->result[(size_t)i * nrhs];
+        double x_sum = 0;
+        double b_sum = 0;
+        for(int k = 0; k < nrhs; k++){
+            a->error = ge_max_error(a->error, std::fabs(r[k]));
+            x_sum += std::fabs(x_row[k]);
+            b_sum += std::fabs(b_row[k]);
+        }
+        a->norm = ge_max_error(a->norm, abs_sum);
+        a->x_norm = ge_max_error(a->x_norm, x_sum);
+        a->b_norm = ge_max_error(a->b_norm, b_sum);
+    }
+    delete[] r;
+    return 0;
+}
+
+// Runs a check with one contiguous run of rows per thread
+// Takes the thread function, the args shared by every thread (first,
+// last, and the barrier are filled in here), the number of threads,
+// and the array of per-thread args to fill as arguments
+void ge_verify_launch(void *(*check)(void *), const GeVerifyArgs &shared,
+        int num_threads, GeVerifyArgs *args){
+    pthread_t *threads = new pthread_t[num_threads];
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, num_threads);
+    for(int t = 0; t < num_threads; t++){
+        args[t] = shared;
+        args[t].first = (int)((long)shared.N * t / num_threads);
+        args[t].last = (int)((long)shared.N * (t + 1) / num_threads);
+        args[t].barrier = &barrier;
+        start_thread(&threads[t], check, (void*)&args[t]);
+    }
+    for(int t = 0; t < num_threads; t++){
+        pthread_join(threads[t], NULL);
+    }
+    pthread_barrier_destroy(&barrier);
+    delete[] threads;
+}
+
+// Checks a packed LU factorization with a random vector v:
+// ||P A v - L (U v)|| / (||A|| ||v||) in the infinity norm
+// A random matrix need not be kept for the check: with A NULL each row
+// is made again from the seed
+// Takes the original matrix (or NULL), the packed LU, the permutation
+// vector, the dimension, the number of threads, the distance between
+// rows of the packed LU (0 if its rows are packed), and the seed of A as
+// arguments
+// Returns the relative error (around the float rounding error times the
+// growth of the elimination when the factorization is right, and
+// infinite if anything is not finite)
+double ge_verify_lu(const float *A, const float *lu, const int *perm,
+        int N, int num_threads, int ld = 0, uint32_t seed = 0){
+    double *v = new double[N];
+    double *y = new double[N];
+    ge_random_row(v, 0, N, 0x5eed);
+    double v_norm = 0;
+    for(int j = 0; j < N; j++){
+        v_norm = ge_max_error(v_norm, std::fabs(v[j]));
+    }
+
+    GeVerifyArgs shared = {A, seed, lu, perm, NULL, N, 0, ld ? ld : N, v,
+        y, 0, 0, NULL, 0, 0, 0, 0};
+    GeVerifyArgs *args = new GeVerifyArgs[num_threads];
+    ge_verify_launch(ge_verify_lu_rows, shared, num_threads, args);
+
+    double error = 0;
+    double norm = 0;
+    for(int t = 0; t < num_threads; t++){
+        error = ge_max_error(error, args[t].error);
+        norm = ge_max_error(norm, args[t].norm);
+    }
+
+    delete[] v;
+    delete[] y;
+    delete[] args;
+    return ge_relative_error(error, norm * v_norm);
+}
+
+// Checks the solution of A X = B:
+// ||A X - B|| / (||A|| ||X|| + ||B||) in the infinity norm
+// Takes the matrix, the solution, the right-hand sides, the dimension,
+// the number of right-hand sides, and the number of threads as
+// arguments
+// Returns the relative residual
+double ge_verify_solve(const float *A, const float *X, const float *B,
+        int N, int nrhs, int num_threads){
+    GeVerifyArgs *args = new GeVerifyArgs[num_threads];
+    GeVerifyArgs shared = {A, 0, X, NULL, B, N, nrhs, nrhs, NULL, NULL, 0,
+        0, NULL, 0, 0, 0, 0};
+    ge_verify_launch(ge_verify_solve_rows, shared, num_threads, args);
+
+    double error = 0;
+    double norm = 0;
+    double x_norm = 0;
+    double b_norm = 0;
+    for(int t = 0; t < num_threads; t++){
+        error = ge_max_error(error, args[t].error);
+        norm = ge_max_error(norm, args[t].norm);
+        x_norm = ge_max_error(x_norm, args[t].x_norm);
+        b_norm = ge_max_error(b_norm, args[t].b_norm);
+    }
+
+    delete[] args;
+    return ge_relative_error(error, norm * x_norm + b_norm);
+}
+
+#endif
@@ -6,15 +6,33 @@
 #include <mpi.h>
 #include <cstring>
 #include "../../common/common.h"
+#include "../../common/bench.h"
+#include "../../common/mapping.h"
+#include "../../common/mpi_lookahead.h"
+#include "../../common/mpi_blocking.h"
+#include "../../common/mpi_cyclic.h"
+#include "../../common/mpi_verify.h"
+
+// Time spent and bytes moved by one phase of communication
+struct GePhase {
+    double seconds;
+    double bytes;
+};
 
 int main(int argc, char *argv[]){
+    // Problem size and runs (-n, -w, -r on the command line), and the
+    // check (-v serial or residual)
+    BenchConfig config = ge_bench_defaults(1024, 1);
+    parse_bench_args(argc, argv, &config);
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
     // Declare a problem size
-    int N = 1024;
+    int N = config.N;
 
     // Declate variables for timing
-    double t_start;
+    double t_start = 0;
     double t_end;
-    double t_total;
+    vector<double> times;
 
     // Unique rank for this process
     int rank;
@@ -30,155 +48,165 @@ int main(int argc, char *argv[]){
 
     // Get the total number ranks in this communicator
     MPI_Comm_size(MPI_COMM_WORLD, &size);
-    
-    // Calulate the number of rows based on the number of ranks
-    int num_rows = N / size; 
 
-    /*
-     * Distribute Work to Ranks:
-     * Rank 0 needs to send the appropriate rows to each process
-     * before they are able to proceed
-     */
-    // Declare our problem matrices
-    // This work is duplicated just for code simplicity
-    float *matrix;
-    if(rank == 0){
-        // Only rank 0 needs space for the total solution 
-        matrix = new float[N * N];
+    // Calulate the number of rows based on the number of ranks (the
+    // first N % size ranks get one more)
+    CyclicMapping mapping;
+    int num_rows = mapping.num_rows(N, size, rank);
+
+    // Only rank 0 needs space for the total solution, and only for the
+    // serial check (every rank makes its own rows of the matrix)
+    float *matrix = NULL;
+    if((rank == 0) && !residual){
+        matrix = new float[(size_t)N * N];
 
         // Initialize the matrix
-        init_matrix(matrix, N);
+        init_matrix(matrix, N, N, config.seed);
     }
 
     // Declare our sub-matrix for each process
-    float *sub_matrix = new float[N * num_rows];
-
-    // Cyclic stripe the rows to all the ranks
-    if(size == 1){
-        // All rows to the single rank
-        memcpy(sub_matrix, matrix, N * N * sizeof(float));
-    }else{
-        // Scatter "num_rows" rows to "size" processes
-        for(int i = 0; i < num_rows; i++){
-            MPI_Scatter(&matrix[i * N * size], N, MPI_FLOAT,
-                &sub_matrix[i * N], N, MPI_FLOAT, 0, MPI_COMM_WORLD);
-        }
-    }
-
-    /*
-     * Gaussian Elimination:
-     * One rank normalizes the pivot row, then sends it to all
-     * later ranks for elimination
-     */
-    // Allocate space for a single row to be sent to this rank
-    float *row = new float[N];
-
-    // Get start time
-    if(rank == 0){
-        t_start = MPI_Wtime();
-    }
-    
-    // Local variables for code clarity
-    int local_row;
-    int which_rank;
-    int pivot;
-    int scale;
-
-    // Iterate over all rows
-    for(int i = 0; i < N; i++){
-        // Which row in the sub-matrix are we accessing?
-        local_row = i / size;
-        // Which rank does this row belong to?
-        which_rank = i % size;
-        
-        // Eliminate if the pivot belongs to this rank
-        if(rank == which_rank){
-            pivot = sub_matrix[local_row * N + i];
-            
-            // Divide the rest of the row by the pivot
-            for(int j = i + 1; j < N; j++){
-                sub_matrix[local_row * N + j] /= pivot;
+    float *sub_matrix = new float[(size_t)N * num_rows];
+
+    // Time and bytes of each communication phase (rank 0's share)
+    GePhase bcast = {0, 0};
+    GePhase gather = {0, 0};
+
+    // Number of pivots per blocked panel
+    int block_size = GE_BLOCK_SIZE;
+
+    // Row of the matrix picked as each pivot
+    int *perm = new int[N];
+
+    // Pivot rows of the blocking version are sent with MPI_Bcast
+    GeBcastPivots pivots;
+    ge_bcast_pivots_init(&pivots, N, block_size);
+
+    // Run the elimination with blocking and with lookahead broadcasts
+    // (warmup runs are not recorded). The residual check needs the
+    // packed LU factorization
+    vector<double> lookahead_times;
+    float *sub_blocking = new float[(size_t)N * num_rows];
+    int *perm_blocking = new int[N];
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        for(int lookahead = 0; lookahead < 2; lookahead++){
+            // Every rank fills its own rows
+            ge_random_mapped(mapping, sub_matrix, N, N, size, rank,
+                    config.seed);
+
+            // Get start time once every rank has its rows
+            MPI_Barrier(MPI_COMM_WORLD);
+            if(rank == 0){
+                t_start = MPI_Wtime();
             }
 
-            // Use assignment for the trivial self-division
-            sub_matrix[local_row * N + i] = 1;
-
-            // Copy the row into our send buffer
-            memcpy(row, &sub_matrix[local_row * N], N * sizeof(float));
-
-            // Broadcast this row to all the ranks
-            MPI_Bcast(row, N, MPI_FLOAT, which_rank, MPI_COMM_WORLD);
-
-            // Eliminate for the other rows mapped to this rank
-            for(int j = local_row + 1; j < num_rows; j++){
-                scale = sub_matrix[j * N + i];
-
-                // Subtract to eliminate pivot from later rows
-                for(int k = i + 1; k < N; k++){
-                    sub_matrix[j * N + k] -= scale * row[k];
+            if(lookahead){
+                ge_mpi_lookahead(mapping, sub_matrix, N, rank, size, perm,
+                        block_size, N, residual);
+            }else{
+                pivots.seconds = 0;
+                pivots.bytes = 0;
+                ge_mpi_blocking(mapping, &pivots, sub_matrix, N, rank, size,
+                        perm_blocking, block_size, residual);
+                if(r >= config.warmup){
+                    bcast.seconds += pivots.seconds;
+                    bcast.bytes += pivots.bytes;
                 }
-
-                // Use assignment for the trivial elimination
-                sub_matrix[j * N + i] = 0;
+                memcpy(sub_blocking, sub_matrix,
+                        (size_t)N * num_rows * sizeof(float));
             }
-        }else{
-            // Receive a row to use for elimination
-            MPI_Bcast(row, N, MPI_FLOAT, which_rank, MPI_COMM_WORLD);
-
-            // Eliminate for all the rows mapped to this rank
-            for(int j = local_row; j < num_rows; j++){
-                if((which_rank < rank) || (j > local_row)){
-                    scale = sub_matrix[j * N + i];
-
-                    //Subtract to eliminate pivot from later rows
-                    for(int k = i + 1; k < N; k++){
-                        sub_matrix[j * N + k] -= scale * row[k];
-                    }
-
-                    // Use assignment for the trivial elimination
-                    sub_matrix[j * N + i] = 0;
+
+            // Barrier to track when calculations are done
+            MPI_Barrier(MPI_COMM_WORLD);
+
+            // Stop the time before the gather phase
+            if(rank == 0){
+                t_end = MPI_Wtime();
+                if((r >= config.warmup) && lookahead){
+                    lookahead_times.push_back(t_end - t_start);
+                }else if(r >= config.warmup){
+                    times.push_back(t_end - t_start);
                 }
             }
         }
     }
 
-    // Barrier to track when calculations are done
-    MPI_Barrier(MPI_COMM_WORLD);
+    // Both versions give the same rows and pivots
+    verify_solution(sub_blocking, sub_matrix, num_rows, N);
+    verify_permutation(perm_blocking, perm, N);
 
-    // Stop the time before the gather phase
-    if(rank == 0){
-        t_end = MPI_Wtime();
-        t_total = t_end - t_start;
+    // Check the factorization over the rows of every rank, making the
+    // rows of the matrix again
+    double error = 0;
+    if(residual){
+        error = ge_mpi_check_lu(mapping, NULL, sub_matrix, N, rank, size,
+                perm, config.seed);
     }
 
     /*
      * Collect all Sub-Matrices
-     * All sub-matrices are gathered using the gather function
+     * All sub-matrices are gathered with one cyclic stripe per rank
+     * (plus the last N % size rows) for the serial check
      */
-    if(size == 1){
-        memcpy(matrix, sub_matrix, N * N * sizeof(float));
-    }else{
-        // Gather "size" rows at a time
-        for(int i = 0; i < num_rows; i++){
-            MPI_Gather(&sub_matrix[i * N], N, MPI_FLOAT,
-                &matrix[i * size * N], N, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    float *gathered = NULL;
+    if(!residual){
+        // Datatype that moves the rows of every rank with one gather
+        GeCyclicRows cyclic_rows;
+        ge_cyclic_rows_init(&cyclic_rows, N, rank, size);
+        if(rank == 0){
+            gathered = new float[(size_t)N * N];
         }
+        double t_gather = MPI_Wtime();
+        ge_gather_rows(&cyclic_rows, sub_matrix, gathered);
+        gather.seconds = MPI_Wtime() - t_gather;
+        gather.bytes = (double)N * N * sizeof(float);
+        ge_cyclic_rows_destroy(&cyclic_rows);
     }
+
+    ge_bcast_pivots_destroy(&pivots);
     MPI_Finalize();
 
-    // Print the output and the time
+    // Print the median time, and every run for the benchmark driver
     if(rank == 0){
         //print_matrix(matrix, N);
-        cout << t_total << " Seconds" << endl;
+        cout << bench_stats(times).median << " Seconds" << endl;
+        cout << bench_stats(lookahead_times).median
+            << " Seconds (lookahead)" << endl;
+        print_bench_line("parallel", N, size, times);
+        print_bench_line("lookahead", N, size, lookahead_times);
+
+        // Average time and bytes of each phase per run (the pivot
+        // broadcasts would move N * N floats if whole rows were sent).
+        // There is no scatter: every rank makes its own rows
+        GePhase phases[2] = {bcast, gather};
+        const char *names[2] = {"pivot broadcast", "gather"};
+        int runs[2] = {config.reps, 1};
+        for(int p = 0; p < (residual ? 1 : 2); p++){
+            cout << "Phase " << names[p] << ": "
+                << phases[p].bytes / runs[p] << " bytes, "
+                << phases[p].seconds / runs[p] << " seconds" << endl;
+        }
+        cout << "Pivot broadcast bytes with whole rows: "
+            << (double)N * N * sizeof(float) << endl;
     }
 
-    // Free heap-allocated memory
-    if(rank == 0){
-        delete[] matrix;
+    // Verify the lookahead solution
+    if((rank == 0) && residual){
+        cout << "Relative residual = " << error << endl;
+    }else if(rank == 0){
+        int *perm_serial = new int[N];
+        ge_serial(matrix, N, perm_serial, block_size);
+        verify_solution(matrix, gathered, N);
+        verify_permutation(perm_serial, perm, N);
+        delete[] perm_serial;
     }
+
+    // Free heap-allocated memory
+    delete[] matrix;
+    delete[] gathered;
     delete[] sub_matrix;
-    delete[] row;
+    delete[] sub_blocking;
+    delete[] perm;
+    delete[] perm_blocking;
 
     return 0;
 }
-
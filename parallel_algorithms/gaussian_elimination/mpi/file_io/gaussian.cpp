@@ -0,0 +1,230 @@
+// This program implements parallel gaussian elimination in C++ using
+// MPI, with every rank reading its own rows from a matrix file and
+// writing its rows of the packed LU factorization back with MPI-IO
+// (assumes square matrix)
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include <mpi.h>
+#include <cstring>
+#include "../../common/common.h"
+#include "../../common/bench.h"
+#include "../../common/mapping.h"
+#include "../../common/mpi_lookahead.h"
+#include "../../common/mpi_io.h"
+#include "../../common/mpi_verify.h"
+
+// Fills the rows of this rank with random numbers and writes them to a
+// new matrix file (every rank makes its own rows, and the file is the
+// same for a seed no matter how many ranks there are)
+// Takes the path, the mapping, the dimension, the seed, the number of
+// ranks, and this rank as arguments
+template <typename Mapping>
+void ge_generate(const char *path, const Mapping &mapping, int N,
+        uint32_t seed, int size, int rank){
+    int num_rows = mapping.num_rows(N, size, rank);
+    float *sub_matrix = new float[(size_t)num_rows * N];
+    ge_random_mapped(mapping, sub_matrix, N, N, size, rank, seed);
+    ge_file_write(MPI_COMM_WORLD, path, mapping, N, size, rank, sub_matrix);
+    delete[] sub_matrix;
+}
+
+// Checks the packed LU factorization written to the output file against
+// the input, over the rows of each rank (so no rank holds the whole
+// matrix), with a random vector v: ||P A v - L (U v)|| / (||A|| ||v||)
+// in the infinity norm (O(N^2) work in all)
+// Takes the mapping, the input and output paths, the dimension, this
+// rank, the number of ranks, and the permutation vector as arguments
+// Returns the relative error (on every rank)
+template <typename Mapping>
+double ge_file_check_lu(const Mapping &mapping, const char *in,
+        const char *out, int N, int rank, int size, const int *perm){
+    // Read the rows of this rank from both files
+    int num_rows = mapping.num_rows(N, size, rank);
+    float *a_rows = new float[(size_t)num_rows * N];
+    float *lu_rows = new float[(size_t)num_rows * N];
+    MPI_File fh;
+    ge_file_open(MPI_COMM_WORLD, in, &fh);
+    ge_file_read(&fh, mapping, N, size, rank, a_rows);
+    ge_file_open(MPI_COMM_WORLD, out, &fh);
+    ge_file_read(&fh, mapping, N, size, rank, lu_rows);
+
+    double error = ge_mpi_check_lu(mapping, a_rows, lu_rows, N, rank,
+            size, perm);
+
+    // Free heap-allocated memory
+    delete[] a_rows;
+    delete[] lu_rows;
+
+    return error;
+}
+
+// Reads the matrix, factors it, and writes the packed LU factorization
+// Takes the mapping, the input and output paths, whether to create the
+// input first, whether to also check against the serial version on rank
+// 0, the benchmark options, this rank, and the number of ranks as
+// arguments
+template <typename Mapping>
+void ge_file_run(const Mapping &mapping, const char *in, const char *out,
+        bool generate, bool check_serial, BenchConfig config, int rank,
+        int size){
+    // Create the input if asked to
+    if(generate){
+        ge_generate(in, mapping, config.N, config.seed, size, rank);
+    }
+
+    // Declate variables for timing
+    double t_start = 0;
+    double t_end;
+    vector<double> times;
+    double t_read = 0;
+
+    // Open the file once to find the problem size
+    MPI_File fh;
+    int N = ge_file_open(MPI_COMM_WORLD, in, &fh);
+    MPI_File_close(&fh);
+
+    // Space for the rows of this rank only
+    int num_rows = mapping.num_rows(N, size, rank);
+    float *sub_matrix = new float[(size_t)num_rows * N];
+
+    // Number of pivots per blocked panel
+    int block_size = GE_BLOCK_SIZE;
+
+    // Row of the matrix picked as each pivot
+    int *perm = new int[N];
+
+    // Run the elimination (warmup runs are not recorded)
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        // Every rank reads its own rows with one collective read
+        double t = MPI_Wtime();
+        ge_file_open(MPI_COMM_WORLD, in, &fh);
+        ge_file_read(&fh, mapping, N, size, rank, sub_matrix);
+        if(r >= config.warmup){
+            t_read += MPI_Wtime() - t;
+        }
+
+        // Get start time once every rank has its rows
+        MPI_Barrier(MPI_COMM_WORLD);
+        if(rank == 0){
+            t_start = MPI_Wtime();
+        }
+
+        ge_mpi_lookahead(mapping, sub_matrix, N, rank, size, perm,
+                block_size, N, true);
+
+        // Barrier to track when calculations are done
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        // Stop the time before the write phase
+        if(rank == 0){
+            t_end = MPI_Wtime();
+            if(r >= config.warmup){
+                times.push_back(t_end - t_start);
+            }
+        }
+    }
+
+    // Every rank writes its rows back with one collective write
+    double t_write = MPI_Wtime();
+    ge_file_write(MPI_COMM_WORLD, out, mapping, N, size, rank, sub_matrix);
+    t_write = MPI_Wtime() - t_write;
+
+    // Print the median time, and every run for the benchmark driver
+    if(rank == 0){
+        cout << bench_stats(times).median << " Seconds" << endl;
+        cout << "Read: " << t_read / config.reps << " seconds, write: "
+            << t_write << " seconds" << endl;
+        print_bench_line("parallel", N, size, times);
+    }
+
+    // Check what was written over the rows of every rank
+    double error = ge_file_check_lu(mapping, in, out, N, rank, size, perm);
+    if(rank == 0){
+        cout << "Relative error of the factorization = " << error << endl;
+    }
+
+    // Verify the solution against the serial version only if asked to
+    // (rank 0 loads the whole matrix twice)
+    if((rank == 0) && check_serial){
+        BlockMapping whole;
+        float *matrix = new float[(size_t)N * N];
+        float *matrix_mpi = new float[(size_t)N * N];
+        ge_file_open(MPI_COMM_SELF, in, &fh);
+        ge_file_read(&fh, whole, N, 1, 0, matrix);
+        ge_file_open(MPI_COMM_SELF, out, &fh);
+        ge_file_read(&fh, whole, N, 1, 0, matrix_mpi);
+
+        int *perm_serial = new int[N];
+        ge_blocked(matrix, N, N, perm_serial, block_size, true);
+        verify_solution(matrix, matrix_mpi, N);
+        verify_permutation(perm_serial, perm, N);
+        delete[] matrix;
+        delete[] matrix_mpi;
+        delete[] perm_serial;
+    }
+
+    // Free heap-allocated memory
+    delete[] sub_matrix;
+    delete[] perm;
+}
+
+int main(int argc, char *argv[]){
+    // Problem size and runs (-n, -w, -r on the command line), the input
+    // and output files (-f, -o), whether to create a random input of
+    // size -n first (-g), the row mapping (-m block or cyclic), and
+    // whether to also check against the serial version on rank 0 (-c)
+    BenchConfig config = ge_bench_defaults(1024, 1);
+    const char *in = "matrix.bin";
+    const char *out = "matrix_lu.bin";
+    bool generate = false;
+    bool check_serial = false;
+    bool cyclic = true;
+    int bench_argc = 1;
+    char **bench_argv = new char*[argc];
+    bench_argv[0] = argv[0];
+    for(int i = 1; i < argc; i++){
+        if((i + 1 < argc) && (strcmp(argv[i], "-f") == 0)){
+            in = argv[++i];
+        }else if((i + 1 < argc) && (strcmp(argv[i], "-o") == 0)){
+            out = argv[++i];
+        }else if((i + 1 < argc) && (strcmp(argv[i], "-m") == 0)){
+            cyclic = (strcmp(argv[++i], "block") != 0);
+        }else if(strcmp(argv[i], "-g") == 0){
+            generate = true;
+        }else if(strcmp(argv[i], "-c") == 0){
+            check_serial = true;
+        }else{
+            bench_argv[bench_argc++] = argv[i];
+        }
+    }
+    parse_bench_args(bench_argc, bench_argv, &config);
+    delete[] bench_argv;
+
+    // Unique rank for this process
+    int rank;
+
+    // Total number of ranks
+    int size;
+
+    // Initializes the MPI execution environment
+    MPI_Init(&argc, &argv);
+
+    // Get the rank
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Get the total number ranks in this communicator
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if(cyclic){
+        ge_file_run(CyclicMapping(), in, out, generate, check_serial, config,
+                rank, size);
+    }else{
+        ge_file_run(BlockMapping(), in, out, generate, check_serial, config,
+                rank, size);
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,174 @@
+// This program implements parallel gaussian elimination in C++ using
+// MPI on a 2D grid of ranks with block-cyclic tiles (assumes square
+// matrix)
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include "utils.h"
+
+int main(int argc, char *argv[]){
+    // Problem size and runs (-n, -w, -r on the command line), the check
+    // (-v serial or residual), and the grid shape and tile size (-p
+    // rows, -q columns, -b tile size)
+    BenchConfig config = ge_bench_defaults(1024, 1);
+    int P = 0;
+    int Q = 0;
+    int nb = GE_BLOCK_SIZE;
+    int bench_argc = 1;
+    char **bench_argv = new char*[argc];
+    bench_argv[0] = argv[0];
+    for(int i = 1; i < argc; i++){
+        if((i + 1 < argc) && (strcmp(argv[i], "-p") == 0)){
+            P = atoi(argv[++i]);
+        }else if((i + 1 < argc) && (strcmp(argv[i], "-q") == 0)){
+            Q = atoi(argv[++i]);
+        }else if((i + 1 < argc) && (strcmp(argv[i], "-b") == 0)){
+            nb = atoi(argv[++i]);
+        }else{
+            bench_argv[bench_argc++] = argv[i];
+        }
+    }
+    parse_bench_args(bench_argc, bench_argv, &config);
+    delete[] bench_argv;
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
+    // Declare a problem size
+    int N = config.N;
+
+    // Declate variables for timing
+    double t_start = 0;
+    double t_end;
+    vector<double> times;
+
+    // Unique rank for this process
+    int rank;
+
+    // Total number of ranks
+    int size;
+
+    // Initializes the MPI execution environment
+    MPI_Init(&argc, &argv);
+
+    // Get the rank
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Get the total number ranks in this communicator
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    // Pick a grid shape as square as possible for any side not given
+    int dims[2] = {P, Q};
+    if((P * Q != size) && (P > 0) && (Q > 0)){
+        if(rank == 0){
+            cerr << "A " << P << " x " << Q << " grid needs " << P * Q
+                << " ranks" << endl;
+        }
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_Dims_create(size, 2, dims);
+    P = dims[0];
+    Q = dims[1];
+
+    // Lay out the grid and each rank's tiles
+    GeGrid grid;
+    ge_grid_init(&grid, N, nb, P, Q, rank);
+
+    // Only rank 0 needs space for the total solution, and only for the
+    // serial check (every rank makes its own tiles of the matrix)
+    float *matrix = NULL;
+    if((rank == 0) && !residual){
+        matrix = new float[(size_t)N * N];
+
+        // Initialize the matrix
+        init_matrix(matrix, N, N, config.seed);
+    }
+
+    // Row of the matrix picked as each pivot
+    int *perm = new int[N];
+
+    // Run the elimination (warmup runs are not recorded). The residual
+    // check needs the packed LU factorization
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        // Every rank fills its own tiles
+        ge_grid_generate(&grid, config.seed);
+
+        // Get start time once every rank has its tiles
+        MPI_Barrier(MPI_COMM_WORLD);
+        if(rank == 0){
+            t_start = MPI_Wtime();
+        }
+
+        ge_grid(&grid, perm, residual);
+
+        // Barrier to track when calculations are done
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        // Stop the time before the gather phase
+        if(rank == 0){
+            t_end = MPI_Wtime();
+            if(r >= config.warmup){
+                times.push_back(t_end - t_start);
+            }
+        }
+    }
+
+    // Most bytes any rank received in the multiplier (along grid rows)
+    // and pivot row (down grid columns) broadcasts of one run
+    double bytes[2] = {grid.l_bytes, grid.u_bytes};
+    double max_bytes[2];
+    MPI_Reduce(bytes, max_bytes, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    // Check the factorization over the tiles of every rank, making the
+    // rows of the matrix again
+    double error = 0;
+    if(residual){
+        error = ge_grid_check_lu(&grid, perm, config.seed);
+    }
+
+    /*
+     * Collect all Tiles
+     * All tiles are gathered with one gather for the serial check, then
+     * each row is moved back to the matrix row it came from
+     */
+    float *gathered = NULL;
+    if(!residual){
+        if(rank == 0){
+            gathered = new float[(size_t)N * N];
+        }
+        ge_grid_gather(&grid, gathered, size, rank);
+    }
+
+    ge_grid_destroy(&grid);
+    MPI_Finalize();
+
+    // Print the median time, the traffic, and every run for the
+    // benchmark driver
+    if(rank == 0){
+        cout << P << " x " << Q << " grid, " << nb << " x " << nb
+            << " tiles" << endl;
+        cout << bench_stats(times).median << " Seconds" << endl;
+        cout << "Bytes received per rank: multipliers = " << max_bytes[0]
+            << ", pivot rows = " << max_bytes[1] << endl;
+        print_bench_line("parallel", N, size, times);
+    }
+
+    // Verify the solution
+    if((rank == 0) && residual){
+        cout << "Relative residual = " << error << endl;
+    }else if(rank == 0){
+        float *matrix_mpi = new float[(size_t)N * N];
+        ge_grid_unpermute(gathered, perm, N, matrix_mpi);
+        int *perm_serial = new int[N];
+        ge_serial(matrix, N, perm_serial, nb);
+        verify_solution(matrix, matrix_mpi, N);
+        verify_permutation(perm_serial, perm, N);
+        delete[] matrix_mpi;
+        delete[] perm_serial;
+    }
+
+    // Free heap-allocated memory
+    delete[] matrix;
+    delete[] gathered;
+    delete[] perm;
+
+    return 0;
+}
@@ -0,0 +1,453 @@
+// This file contains the 2D process grid used by the MPI version of
+// Gaussian Elimination with block-cyclic tiles. Rows and columns are
+// both dealt out in blocks, so pivot row segments only travel down grid
+// columns and multipliers only travel along grid rows
+// By: Nick from CoffeeBeforeArch
+
+#include <mpi.h>
+#include <cstring>
+#include <algorithm>
+#include "../../common/common.h"
+#include "../../common/mapping.h"
+#include "../../common/bench.h"
+#include "../../common/verify.h"
+
+// A P x Q grid of ranks (rank = grid row * Q + grid column), and the
+// tiles of the matrix owned by this rank
+struct GeGrid {
+    // Dimension of the matrix, and the size of a tile
+    int N;
+    int nb;
+    // Shape of the grid, and where this rank sits in it
+    int P;
+    int Q;
+    int prow;
+    int pcol;
+    // Ranks of this grid row (ranked by grid column), and of this grid
+    // column (ranked by grid row)
+    MPI_Comm row_comm;
+    MPI_Comm col_comm;
+    // Block-cyclic mapping of the rows over grid rows, and of the
+    // columns over grid columns
+    BlockCyclicMapping map;
+    // Local tiles, stored as one row-major m_local x n_local matrix
+    int m_local;
+    int n_local;
+    float *a;
+    // Matrix row at each position (rows are swapped as pivots are
+    // picked), and the position of each matrix row
+    int *ids;
+    int *pos;
+    // Bytes this rank received in the multiplier and pivot row
+    // broadcasts
+    double l_bytes;
+    double u_bytes;
+};
+
+// Sets up the grid and the local tiles of this rank
+// Takes the grid, the dimension, the tile size, the grid shape, and
+// this rank as arguments
+void ge_grid_init(GeGrid *grid, int N, int nb, int P, int Q, int rank){
+    grid->N = N;
+    grid->nb = nb;
+    grid->P = P;
+    grid->Q = Q;
+    grid->prow = rank / Q;
+    grid->pcol = rank % Q;
+    MPI_Comm_split(MPI_COMM_WORLD, grid->prow, grid->pcol, &grid->row_comm);
+    MPI_Comm_split(MPI_COMM_WORLD, grid->pcol, grid->prow, &grid->col_comm);
+    grid->map.rows_per_block = nb;
+    grid->m_local = grid->map.num_rows(N, P, grid->prow);
+    grid->n_local = grid->map.num_rows(N, Q, grid->pcol);
+    grid->a = new float[(size_t)grid->m_local * grid->n_local];
+    grid->ids = new int[N];
+    grid->pos = new int[N];
+}
+
+// Frees the grid
+void ge_grid_destroy(GeGrid *grid){
+    MPI_Comm_free(&grid->row_comm);
+    MPI_Comm_free(&grid->col_comm);
+    delete[] grid->a;
+    delete[] grid->ids;
+    delete[] grid->pos;
+}
+
+// Fills the local tiles of this rank with its part of the random matrix
+// (every rank makes its own tiles, so no rank needs the whole matrix)
+// Takes the grid and the seed as arguments
+void ge_grid_generate(GeGrid *grid, uint32_t seed){
+    int N = grid->N;
+    int nb = grid->nb;
+    int n_local = grid->n_local;
+    for(int r = 0; r < grid->m_local; r++){
+        int row = grid->map.row(r, N, grid->P, grid->prow);
+        float *a = &grid->a[(size_t)r * n_local];
+
+        // Each tile of columns is a contiguous run of the row
+        for(int c = 0; c < n_local; c += nb){
+            int col = grid->map.row(c, N, grid->Q, grid->pcol);
+            int count = std::min(nb, n_local - c);
+            ge_random_cols(&a[c], row, col, col + count, seed);
+        }
+    }
+}
+
+// Collects the tiles of every rank into the whole matrix on rank 0 with
+// one Gatherv
+// Takes the grid, the whole matrix (only written on rank 0), the number
+// of ranks, and this rank as arguments
+void ge_grid_gather(GeGrid *grid, float *matrix, int size, int rank){
+    int N = grid->N;
+    int *counts = new int[size];
+    int *offsets = new int[size];
+    for(int r = 0; r < size; r++){
+        counts[r] = grid->map.num_rows(N, grid->P, r / grid->Q) *
+            grid->map.num_rows(N, grid->Q, r % grid->Q);
+        offsets[r] = (r == 0) ? 0 : offsets[r - 1] + counts[r - 1];
+    }
+
+    // Only rank 0 needs the packed tiles of every rank
+    float *packed = NULL;
+    if(rank == 0){
+        packed = new float[(size_t)N * N];
+    }
+
+    int count = grid->m_local * grid->n_local;
+    MPI_Gatherv(grid->a, count, MPI_FLOAT, packed, counts, offsets,
+            MPI_FLOAT, 0, MPI_COMM_WORLD);
+
+    // Put each rank's tiles where they go in the matrix
+    for(int r = 0; (rank == 0) && (r < size); r++){
+        int pr = r / grid->Q;
+        int pc = r % grid->Q;
+        int m = grid->map.num_rows(N, grid->P, pr);
+        int n = grid->map.num_rows(N, grid->Q, pc);
+        float *tiles = &packed[offsets[r]];
+        for(int i = 0; i < m; i++){
+            int row = grid->map.row(i, N, grid->P, pr);
+            for(int j = 0; j < n; j++){
+                int col = grid->map.row(j, N, grid->Q, pc);
+                matrix[(size_t)row * N + col] = tiles[(size_t)i * n + j];
+            }
+        }
+    }
+
+    if(rank == 0){
+        delete[] packed;
+    }
+    delete[] counts;
+    delete[] offsets;
+}
+
+// Swaps local columns [c0, c0 + count) of matrix rows at positions i
+// and p (only the two grid rows that own them take part)
+// Takes the grid, the two positions, and the column range as arguments
+void ge_grid_swap(GeGrid *grid, int i, int p, int c0, int count){
+    if((i == p) || (count == 0)){
+        return;
+    }
+    int owner_i = grid->map.owner(i, grid->N, grid->P);
+    int owner_p = grid->map.owner(p, grid->N, grid->P);
+    float *row_i = &grid->a[(size_t)grid->map.local(i, grid->P) *
+        grid->n_local + c0];
+    float *row_p = &grid->a[(size_t)grid->map.local(p, grid->P) *
+        grid->n_local + c0];
+    if((grid->prow == owner_i) && (grid->prow == owner_p)){
+        std::swap_ranges(row_i, row_i + count, row_p);
+    }else if(grid->prow == owner_i){
+        MPI_Sendrecv_replace(row_i, count, MPI_FLOAT, owner_p, 0, owner_p,
+                0, grid->col_comm, MPI_STATUS_IGNORE);
+    }else if(grid->prow == owner_p){
+        MPI_Sendrecv_replace(row_p, count, MPI_FLOAT, owner_i, 0, owner_i,
+                0, grid->col_comm, MPI_STATUS_IGNORE);
+    }
+}
+
+// Records that the rows at positions i and p were swapped
+void ge_grid_swap_ids(GeGrid *grid, int i, int p){
+    std::swap(grid->ids[i], grid->ids[p]);
+    grid->pos[grid->ids[i]] = i;
+    grid->pos[grid->ids[p]] = p;
+}
+
+// Factors the panel of columns [k0, k1) on the grid column that owns it
+// Each pivot is picked with one reduction down the grid column, its row
+// is swapped into place, and its normalized panel segment is sent down
+// the grid column to eliminate the rows below it
+// Takes the grid, the panel range, the first local panel column, the
+// pivot positions to fill, and space for one panel row as arguments
+void ge_grid_panel(GeGrid *grid, int k0, int k1, int c0, int *piv,
+        float *u){
+    int w = k1 - k0;
+    int n_local = grid->n_local;
+    int owner = grid->map.owner(k0, grid->N, grid->P);
+    for(int i = k0; i < k1; i++){
+        float *a = grid->a;
+        int c = c0 + i - k0;
+
+        // Offer the best local row at or below position i
+        GePivot local = {-1, -1};
+        int first = grid->map.num_rows(i, grid->P, grid->prow);
+        for(int r = first; r < grid->m_local; r++){
+            int row = grid->map.row(r, grid->N, grid->P, grid->prow);
+            GePivot candidate = {std::fabs(a[(size_t)r * n_local + c]),
+                grid->ids[row]};
+            if(ge_better_pivot(candidate, local)){
+                local = candidate;
+            }
+        }
+        GePivot best;
+        MPI_Allreduce(&local, &best, 1, MPI_FLOAT_INT, MPI_MAXLOC,
+                grid->col_comm);
+
+        // Swap the pivot into position i (panel columns only)
+        int p = grid->pos[best.row];
+        piv[i - k0] = p;
+        ge_grid_swap(grid, i, p, c0, w);
+        ge_grid_swap_ids(grid, i, p);
+
+        // Normalize the panel segment of the pivot row, and send it down
+        // the grid column (the pivot itself stays for the pivot rows'
+        // trailing columns)
+        if(grid->prow == owner){
+            float *row = &a[(size_t)grid->map.local(i, grid->P) * n_local +
+                c0];
+            ge_scale(&row[i - k0 + 1], 1.0f / row[i - k0], k1 - i - 1);
+            memcpy(u, row, w * sizeof(float));
+        }
+        MPI_Bcast(u, w, MPI_FLOAT, owner, grid->col_comm);
+
+        // Eliminate pivot i from the panel columns of the rows below
+        int below = grid->map.num_rows(i + 1, grid->P, grid->prow);
+        for(int r = below; r < grid->m_local; r++){
+            float *row = &a[(size_t)r * n_local + c0];
+            ge_eliminate(&row[i - k0 + 1], &u[i - k0 + 1], row[i - k0],
+                    k1 - i - 1);
+        }
+    }
+}
+
+// Applies panel rows to a set of local rows, four at a time
+// (the same order as ge_trailing_update)
+// Takes the row to update, the panel rows, the multipliers, the panel
+// width, and the number of columns as arguments
+void ge_grid_apply(float *row, const float *u, int ld, const float *mult,
+        int w, int count){
+    int k = 0;
+    for(; k + 3 < w; k += 4){
+        const float *rows[4] = {&u[k * ld], &u[(k + 1) * ld],
+            &u[(k + 2) * ld], &u[(k + 3) * ld]};
+        ge_eliminate4(row, rows, &mult[k], count);
+    }
+    for(; k < w; k++){
+        ge_eliminate(row, &u[k * ld], mult[k], count);
+    }
+}
+
+// 2D block-cyclic Gaussian Elimination
+// For every panel: the grid column that owns it factors it, the pivots
+// and the multipliers are sent along grid rows, the grid row that owns
+// the pivot rows finishes them and sends them down grid columns, then
+// every rank updates its own tiles of the trailing matrix
+// Row perm[i] of the gathered matrix holds the ith row of the
+// upper-triangular matrix (as in ge_serial)
+// With keep_lu the row at position i is left holding row i of the
+// packed LU factorization instead (as in ge_blocked), so the row swaps
+// are also applied to the columns left of each panel
+// Takes the grid, the permutation vector, and the packed LU flag as
+// arguments
+void ge_grid(GeGrid *grid, int *perm, bool keep_lu = false){
+    int N = grid->N;
+    int nb = grid->nb;
+    int n_local = grid->n_local;
+    for(int i = 0; i < N; i++){
+        grid->ids[i] = i;
+        grid->pos[i] = i;
+    }
+    grid->l_bytes = 0;
+    grid->u_bytes = 0;
+
+    // Pivots of a panel, its multipliers for the local rows, and its
+    // pivot rows for the local columns
+    int *piv = new int[nb];
+    float *L = new float[(size_t)std::max(grid->m_local, 1) * nb];
+    float *U = new float[(size_t)nb * std::max(n_local, nb)];
+
+    for(int k0 = 0; k0 < N; k0 += nb){
+        int k1 = std::min(k0 + nb, N);
+        int w = k1 - k0;
+        int row_owner = grid->map.owner(k0, N, grid->P);
+        int col_owner = grid->map.owner(k0, N, grid->Q);
+
+        // Local rows from position k0 (and k1) on, and local columns from
+        // column k0 (and k1) on
+        int r0 = grid->map.num_rows(k0, grid->P, grid->prow);
+        int r1 = grid->map.num_rows(k1, grid->P, grid->prow);
+        int c0 = grid->map.num_rows(k0, grid->Q, grid->pcol);
+        int c1 = grid->map.num_rows(k1, grid->Q, grid->pcol);
+        int rows = grid->m_local - r0;
+        int cols = n_local - c1;
+
+        // Factor the panel, then share its pivots along the grid rows
+        if(grid->pcol == col_owner){
+            ge_grid_panel(grid, k0, k1, c0, piv, U);
+        }
+        MPI_Bcast(piv, w, MPI_INT, col_owner, grid->row_comm);
+        if(grid->pcol != col_owner){
+            for(int i = k0; i < k1; i++){
+                ge_grid_swap_ids(grid, i, piv[i - k0]);
+            }
+        }
+
+        // Apply the same row swaps to the trailing columns (and to the
+        // multipliers of earlier panels when they are kept)
+        for(int i = k0; i < k1; i++){
+            ge_grid_swap(grid, i, piv[i - k0], c1, cols);
+            if(keep_lu){
+                ge_grid_swap(grid, i, piv[i - k0], 0, c0);
+            }
+        }
+
+        // Send the multipliers of the local rows along the grid row
+        if(grid->pcol == col_owner){
+            for(int r = 0; r < rows; r++){
+                memcpy(&L[r * w], &grid->a[(size_t)(r0 + r) * n_local + c0],
+                        w * sizeof(float));
+            }
+        }
+        MPI_Bcast(L, rows * w, MPI_FLOAT, col_owner, grid->row_comm);
+        if(grid->pcol != col_owner){
+            grid->l_bytes += (double)rows * w * sizeof(float);
+        }
+
+        // The grid row with the pivot rows brings their trailing columns
+        // up to date and normalizes them, then sends them down the grid
+        // columns
+        if(grid->prow == row_owner){
+            for(int i = 0; i < w; i++){
+                float *row = &grid->a[(size_t)(r0 + i) * n_local + c1];
+                ge_grid_apply(row, U, cols, &L[i * w], i, cols);
+                ge_scale(row, 1.0f / L[i * w + i], cols);
+                memcpy(&U[i * cols], row, cols * sizeof(float));
+            }
+        }
+        MPI_Bcast(U, w * cols, MPI_FLOAT, row_owner, grid->col_comm);
+        if(grid->prow != row_owner){
+            grid->u_bytes += (double)w * cols * sizeof(float);
+        }
+
+        // Update the trailing tiles of this rank, a tile of columns at a
+        // time so the pivot rows stay in cache
+        for(int t0 = 0; t0 < cols; t0 += GE_TILE_COLS){
+            int t1 = std::min(t0 + GE_TILE_COLS, cols);
+            for(int r = r1; r < grid->m_local; r++){
+                ge_grid_apply(&grid->a[(size_t)r * n_local + c1 + t0],
+                        &U[t0], cols, &L[(r - r0) * w], w, t1 - t0);
+            }
+        }
+
+        // Clear the panel: zeros left of the diagonal and ones on it
+        if((grid->pcol == col_owner) && !keep_lu){
+            for(int r = r0; r < grid->m_local; r++){
+                float *row = &grid->a[(size_t)r * n_local + c0];
+                int diagonal = (r < r1) ? r - r0 : w;
+                memset(row, 0, std::min(diagonal, w) * sizeof(float));
+                if(diagonal < w){
+                    row[diagonal] = 1;
+                }
+            }
+        }
+    }
+
+    for(int i = 0; i < N; i++){
+        perm[i] = grid->ids[i];
+    }
+
+    delete[] piv;
+    delete[] L;
+    delete[] U;
+}
+
+// Checks the packed LU factorization left in the tiles by ge_grid with
+// keep_lu, using a random vector v: ||P A v - L (U v)|| / (||A|| ||v||)
+// in the infinity norm (O(N^2) work in all)
+// Every rank sums its tiles into y = U v and then L y, and the first
+// grid column compares L y with the rows of A v it makes again
+// Takes the grid, the permutation vector, and the seed of A as
+// arguments
+// Returns the relative error (on every rank)
+double ge_grid_check_lu(GeGrid *grid, const int *perm, uint32_t seed){
+    int N = grid->N;
+    int n_local = grid->n_local;
+    double *v = new double[N];
+    double *y = new double[N];
+    double *ly = new double[N];
+    double *part = new double[N];
+    ge_random_row(v, 0, N, 0x5eed);
+
+    // y = U v (U has a unit diagonal, added by the rank with the
+    // diagonal element), then L y (L has the pivots on the diagonal)
+    for(int pass = 0; pass < 2; pass++){
+        for(int i = 0; i < N; i++){
+            part[i] = 0;
+        }
+        for(int r = 0; r < grid->m_local; r++){
+            int i = grid->map.row(r, N, grid->P, grid->prow);
+            const float *row = &grid->a[(size_t)r * n_local];
+            for(int c = 0; c < n_local; c++){
+                int j = grid->map.row(c, N, grid->Q, grid->pcol);
+                if((pass == 0) && (j > i)){
+                    part[i] += (double)row[c] * v[j];
+                }else if((pass == 0) && (j == i)){
+                    part[i] += v[i];
+                }else if((pass == 1) && (j <= i)){
+                    part[i] += (double)row[c] * y[j];
+                }
+            }
+        }
+        MPI_Allreduce(part, (pass == 0) ? y : ly, N, MPI_DOUBLE, MPI_SUM,
+                MPI_COMM_WORLD);
+    }
+
+    // Largest error of row i of L y against row perm[i] of A v, row sum
+    // of |A|, and |v|
+    float *a_row = new float[N];
+    double local[3] = {0, 0, 0};
+    for(int r = 0; (grid->pcol == 0) && (r < grid->m_local); r++){
+        int i = grid->map.row(r, N, grid->P, grid->prow);
+        ge_random_row(a_row, perm[i], N, seed);
+        double av = 0;
+        double abs_sum = 0;
+        for(int k = 0; k < N; k++){
+            av += (double)a_row[k] * v[k];
+            abs_sum += std::fabs(a_row[k]);
+        }
+        local[0] = ge_max_error(local[0], std::fabs(av - ly[i]));
+        local[1] = ge_max_error(local[1], abs_sum);
+    }
+    for(int k = 0; k < N; k++){
+        local[2] = ge_max_error(local[2], std::fabs(v[k]));
+    }
+    double global[3];
+    MPI_Allreduce(local, global, 3, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+    delete[] v;
+    delete[] y;
+    delete[] ly;
+    delete[] part;
+    delete[] a_row;
+    return ge_relative_error(global[0], global[1] * global[2]);
+}
+
+// Moves each row of a gathered matrix to the matrix row it came from,
+// so row perm[i] holds the ith row (as in ge_serial)
+// Takes the gathered matrix, the permutation vector, the dimension, and
+// space for the result as arguments
+void ge_grid_unpermute(const float *gathered, const int *perm, int N,
+        float *matrix){
+    for(int i = 0; i < N; i++){
+        memcpy(&matrix[(size_t)perm[i] * N], &gathered[(size_t)i * N],
+                N * sizeof(float));
+    }
+}
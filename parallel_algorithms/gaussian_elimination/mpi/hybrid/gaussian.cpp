@@ -0,0 +1,160 @@
+// This program implements parallel gaussian elimination in C++ using
+// MPI between ranks and pthreads within each rank, with cyclic striped
+// mapping (assumes square matrix)
+// Run one rank per node or socket with mpirun -np, and pick the number
+// of threads per rank with -t
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include "utils.h"
+
+int main(int argc, char *argv[]){
+    // Problem size, threads per rank, and runs (-n, -t, -w, -r on the
+    // command line), and the check (-v serial or residual)
+    BenchConfig config = ge_bench_defaults(1024, 1);
+    parse_bench_args(argc, argv, &config);
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
+    // Declare a problem size
+    int N = config.N;
+
+    // Declate variables for timing
+    double t_start = 0;
+    double t_end;
+    vector<double> times;
+
+    // Unique rank for this process
+    int rank;
+
+    // Total number of ranks
+    int size;
+
+    // Initializes the MPI execution environment. Only the main thread of
+    // each rank makes MPI calls
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+
+    // Get the rank
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Get the total number ranks in this communicator
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if(provided < MPI_THREAD_FUNNELED){
+        if(rank == 0){
+            cerr << "MPI_THREAD_FUNNELED is not supported" << endl;
+        }
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    // Calulate the number of rows based on the number of ranks (the
+    // first N % size ranks get one more)
+    CyclicMapping mapping;
+    int num_rows = mapping.num_rows(N, size, rank);
+
+    // Only rank 0 needs space for the total solution, and only for the
+    // serial check (every rank makes its own rows of the matrix)
+    float *matrix = NULL;
+    if((rank == 0) && !residual){
+        matrix = new float[(size_t)N * N];
+
+        // Initialize the matrix
+        init_matrix(matrix, N, N, config.seed);
+    }
+
+    // Declare our sub-matrix for each process
+    float *sub_matrix = new float[(size_t)N * num_rows];
+
+    // Row of the matrix picked as each pivot
+    int *perm = new int[N];
+
+    // Launch the threads of this rank, which deal its rows round robin
+    // (the residual check needs the packed LU factorization)
+    GeHybrid hybrid;
+    ge_hybrid_init(&hybrid, sub_matrix, N, num_rows, rank, size,
+            config.num_threads, GE_BLOCK_SIZE, perm, residual);
+
+    // Run the elimination (warmup runs are not recorded)
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        // Every rank fills its own rows
+        ge_random_mapped(mapping, sub_matrix, N, N, size, rank,
+                config.seed);
+
+        // Get start time once every rank has its rows
+        MPI_Barrier(MPI_COMM_WORLD);
+        if(rank == 0){
+            t_start = MPI_Wtime();
+        }
+
+        ge_hybrid(&hybrid);
+
+        // Barrier to track when calculations are done
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        // Stop the time before the gather phase
+        if(rank == 0){
+            t_end = MPI_Wtime();
+            if(r >= config.warmup){
+                times.push_back(t_end - t_start);
+            }
+        }
+    }
+
+    ge_hybrid_destroy(&hybrid);
+
+    // Check the factorization over the rows of every rank, making the
+    // rows of the matrix again
+    double error = 0;
+    if(residual){
+        error = ge_mpi_check_lu(mapping, NULL, sub_matrix, N, rank, size,
+                perm, config.seed);
+    }
+
+    /*
+     * Collect all Sub-Matrices
+     * All sub-matrices are gathered into a copy for the serial check, so
+     * the original matrix is left to check with
+     */
+    float *matrix_mpi = NULL;
+    if(!residual){
+        // Datatype that moves the rows of every rank with one gather
+        // (plus one for the last N % size rows)
+        GeCyclicRows cyclic_rows;
+        ge_cyclic_rows_init(&cyclic_rows, N, rank, size);
+        if(rank == 0){
+            matrix_mpi = new float[(size_t)N * N];
+        }
+        ge_gather_rows(&cyclic_rows, sub_matrix, matrix_mpi);
+        ge_cyclic_rows_destroy(&cyclic_rows);
+    }
+
+    MPI_Finalize();
+
+    // Print the median time, and every run for the benchmark driver
+    // (every thread of every rank counts as a worker)
+    if(rank == 0){
+        cout << size << " ranks x " << config.num_threads
+            << " threads" << endl;
+        cout << bench_stats(times).median << " Seconds" << endl;
+        print_bench_line("parallel", N, size * config.num_threads, times);
+    }
+
+    // Verify the solution
+    if((rank == 0) && residual){
+        cout << "Relative residual = " << error << endl;
+    }else if(rank == 0){
+        int *perm_serial = new int[N];
+        ge_serial(matrix, N, perm_serial, GE_BLOCK_SIZE);
+        verify_solution(matrix, matrix_mpi, N);
+        verify_permutation(perm_serial, perm, N);
+        delete[] perm_serial;
+    }
+
+    // Free heap-allocated memory
+    delete[] matrix;
+    delete[] matrix_mpi;
+    delete[] sub_matrix;
+    delete[] perm;
+
+    return 0;
+}
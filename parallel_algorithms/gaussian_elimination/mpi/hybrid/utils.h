@@ -0,0 +1,228 @@
+// This file contains utility functions for the hybrid MPI + pthreads
+// Gaussian Elimination. Each rank owns a cyclic stripe of rows and
+// eliminates it with a persistent team of threads running the barrier
+// version of the pthread code, and only the main thread of a rank makes
+// MPI calls (MPI_THREAD_FUNNELED)
+// By: Nick from CoffeeBeforeArch
+
+#include <mpi.h>
+#include <pthread.h>
+#include "../../common/row_threads.h"
+#include "../../common/mpi_cyclic.h"
+#include "../../common/mpi_verify.h"
+
+// Pivot policy of the barrier version across ranks
+// Thread 0 of each rank takes part in the reduction and the broadcast of
+// every pivot, and the barriers keep the other threads of the rank in
+// step with it
+struct GeRankPivots {
+    // Rows of this rank, the dimension, this rank, and the number of
+    // ranks
+    float *sub_matrix;
+    int N;
+    int rank;
+    int size;
+    // Space for the pivot rows of a panel sent by other ranks
+    float *panel;
+    // Barrier the threads of this rank synchronize at
+    pthread_barrier_t *barrier;
+    // Pivot picked across all ranks (written by thread 0)
+    GePivot best;
+
+    // The largest element of the column across all ranks is the pivot
+    GePivot select(int tid, GePivot local){
+        if(tid == 0){
+            MPI_Allreduce(&local, &best, 1, MPI_FLOAT_INT, MPI_MAXLOC,
+                    MPI_COMM_WORLD);
+        }
+        pthread_barrier_wait(barrier);
+        return best;
+    }
+
+    // Pivot row i, sent straight from the owner's row (only the columns
+    // right of the pivot) into the panel of every other rank
+    const float *row(int tid, GePivot pivot, int i, int k0){
+        // Wait for the owner to update and normalize it
+        pthread_barrier_wait(barrier);
+        CyclicMapping ranks;
+        int root = ranks.owner(pivot.row, N, size);
+        float *row = &panel[(size_t)(i - k0) * N];
+        if(rank == root){
+            row = &sub_matrix[(size_t)ranks.local(pivot.row, size) * N];
+        }
+        if(tid == 0){
+            MPI_Bcast(&row[i + 1], N - i - 1, MPI_FLOAT, root,
+                    MPI_COMM_WORLD);
+        }
+        pthread_barrier_wait(barrier);
+        return row;
+    }
+};
+
+struct GeHybrid;
+
+struct HybridArgs {
+    // Thread ID (thread 0 is the main thread of the rank)
+    int tid;
+    // State shared by the threads of this rank
+    GeHybrid *hybrid;
+};
+
+// State shared by the threads of one rank
+struct GeHybrid {
+    // Rows of this rank and how many there are, the dimension, and the
+    // number of pivots per panel
+    float *sub_matrix;
+    int num_rows;
+    int N;
+    int block_size;
+    // This rank and the number of ranks
+    int rank;
+    int size;
+    // Row of the matrix picked as each pivot, and whether to leave the
+    // packed LU factorization in the rows
+    int *perm;
+    bool keep_lu;
+    // Number of threads in this rank, and the helper threads (1 and up),
+    // which stay parked between solves
+    int num_threads;
+    pthread_t *threads;
+    HybridArgs *thread_args;
+    // Row list of each thread
+    float ***rows;
+    int **ids;
+    // Pivot candidate of each thread, and how pivots are picked
+    Candidate *candidates;
+    GeRankPivots pivots;
+    // Barrier the threads of this rank synchronize at during a solve
+    pthread_barrier_t barrier;
+    // Barrier the helper threads wait at for the next solve
+    pthread_barrier_t start;
+    bool shutdown;
+};
+
+// Eliminates the rows of one thread, then waits for the other threads
+// Each thread takes the rows of this rank round robin
+// Takes the shared state and the thread ID as arguments
+void ge_hybrid_rows(GeHybrid *h, int tid){
+    // Row list of this thread (ids are rows of the whole matrix)
+    CyclicMapping threads;
+    CyclicMapping ranks;
+    int num_rows = threads.num_rows(h->num_rows, h->num_threads, tid);
+    float **rows = h->rows[tid];
+    int *ids = h->ids[tid];
+    for(int j = 0; j < num_rows; j++){
+        int local = threads.row(j, h->num_rows, h->num_threads, tid);
+        rows[j] = &h->sub_matrix[(size_t)local * h->N];
+        ids[j] = ranks.row(local, h->N, h->size, h->rank);
+    }
+
+    ge_barrier_rows(h->pivots, h->N, h->block_size, h->perm, tid,
+            h->num_threads, h->candidates, rows, ids, num_rows, h->keep_lu);
+
+    // The solve is done once every thread gets here
+    pthread_barrier_wait(&h->barrier);
+}
+
+// Pthread function of the helper threads: eliminate their rows for
+// every solve until the rank shuts down
+// Takes a pointer to a struct of args as an argument
+void *ge_hybrid_worker(void *args){
+    // Cast void pointer to struct pointer
+    HybridArgs *local_args = (HybridArgs*)args;
+    GeHybrid *h = local_args->hybrid;
+
+    while(true){
+        pthread_barrier_wait(&h->start);
+        if(h->shutdown){
+            break;
+        }
+        ge_hybrid_rows(h, local_args->tid);
+    }
+
+    return 0;
+}
+
+// Sets up the shared state of a rank, and launches its helper threads
+// Takes the state to fill, the rows of this rank, the dimension, the
+// number of rows of this rank, this rank, the number of ranks, the
+// number of threads, the number of pivots per panel, the permutation
+// vector, and the packed LU flag as arguments
+void ge_hybrid_init(GeHybrid *h, float *sub_matrix, int N, int num_rows,
+        int rank, int size, int num_threads, int block_size, int *perm,
+        bool keep_lu = false){
+    h->sub_matrix = sub_matrix;
+    h->num_rows = num_rows;
+    h->N = N;
+    h->block_size = block_size;
+    h->rank = rank;
+    h->size = size;
+    h->perm = perm;
+    h->keep_lu = keep_lu;
+    h->num_threads = num_threads;
+    h->shutdown = false;
+    h->candidates = ge_aligned_new<Candidate>(num_threads);
+    pthread_barrier_init(&h->barrier, NULL, num_threads);
+    pthread_barrier_init(&h->start, NULL, num_threads);
+
+    h->pivots.sub_matrix = sub_matrix;
+    h->pivots.N = N;
+    h->pivots.rank = rank;
+    h->pivots.size = size;
+    h->pivots.panel = new float[(size_t)block_size * N];
+    h->pivots.barrier = &h->barrier;
+
+    // Space for the row list of each thread
+    CyclicMapping threads;
+    h->rows = new float**[num_threads];
+    h->ids = new int*[num_threads];
+    for(int t = 0; t < num_threads; t++){
+        h->rows[t] = new float*[threads.num_rows(num_rows, num_threads, t)];
+        h->ids[t] = new int[threads.num_rows(num_rows, num_threads, t)];
+    }
+
+    // Launch the helper threads (the calling thread is thread 0)
+    h->threads = new pthread_t[num_threads];
+    h->thread_args = new HybridArgs[num_threads];
+    for(int t = 0; t < num_threads; t++){
+        h->thread_args[t].tid = t;
+        h->thread_args[t].hybrid = h;
+        if(t > 0){
+            start_thread(&h->threads[t], ge_hybrid_worker,
+                    (void*)&h->thread_args[t]);
+        }
+    }
+}
+
+// Stops the helper threads, and frees the shared state of a rank
+// Takes the state as an argument
+void ge_hybrid_destroy(GeHybrid *h){
+    h->shutdown = true;
+    pthread_barrier_wait(&h->start);
+    for(int t = 1; t < h->num_threads; t++){
+        pthread_join(h->threads[t], NULL);
+    }
+
+    for(int t = 0; t < h->num_threads; t++){
+        delete[] h->rows[t];
+        delete[] h->ids[t];
+    }
+    delete[] h->rows;
+    delete[] h->ids;
+    delete[] h->threads;
+    delete[] h->thread_args;
+    delete[] h->pivots.panel;
+    ge_aligned_delete(h->candidates, h->num_threads);
+    pthread_barrier_destroy(&h->barrier);
+    pthread_barrier_destroy(&h->start);
+}
+
+// Eliminates the rows of this rank with its team of threads
+// The calling thread joins in as thread 0, so all MPI calls stay on the
+// thread that initialized MPI
+// Takes the shared state as an argument
+void ge_hybrid(GeHybrid *h){
+    // Wake the helper threads
+    pthread_barrier_wait(&h->start);
+    ge_hybrid_rows(h, 0);
+}
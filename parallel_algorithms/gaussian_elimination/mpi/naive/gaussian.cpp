@@ -6,15 +6,26 @@
 #include <mpi.h>
 #include <cstring>
 #include "../../common/common.h"
+#include "../../common/bench.h"
+#include "../../common/mapping.h"
+#include "../../common/mpi_lookahead.h"
+#include "../../common/mpi_blocking.h"
+#include "../../common/mpi_verify.h"
 
 int main(int argc, char *argv[]){
+    // Problem size and runs (-n, -w, -r on the command line), and the
+    // check (-v serial or residual)
+    BenchConfig config = ge_bench_defaults(1024, 1);
+    parse_bench_args(argc, argv, &config);
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
     // Declare a problem size
-    int N = 1024;
+    int N = config.N;
 
     // Declate variables for timing
-    double t_start;
+    double t_start = 0;
     double t_end;
-    double t_total;
+    vector<double> times;
 
     // Unique rank for this process
     int rank;
@@ -31,144 +42,144 @@ int main(int argc, char *argv[]){
     // Get the total number ranks in this communicator
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    // Calulate the number of rows based on the number of ranks
-    int num_rows = N / size; 
+    // Calulate the number of rows based on the number of ranks (the
+    // first N % size ranks get one more)
+    BlockMapping mapping;
+    int num_rows = mapping.num_rows(N, size, rank);
 
-    /*
-     * Distribute Work to Ranks:
-     * Rank 0 needs to send the appropriate rows to each process
-     * before they are able to proceed
-     */
-    // Declare our problem matrices
-    // This work is duplicated just for code simplicity
-    float *matrix;
-
-    // Only rank 0 needs space for the total solution
-    if(rank == 0){
-        matrix = new float [N * N];
+    // Only rank 0 needs space for the total solution, and only for the
+    // serial check (every rank makes its own rows of the matrix)
+    float *matrix = NULL;
+    if((rank == 0) && !residual){
+        matrix = new float[(size_t)N * N];
 
         // Initialize the matrix
-        init_matrix(matrix, N);
+        init_matrix(matrix, N, N, config.seed);
     }
     
     // Declare our sub-matrix for each process
-    float *sub_matrix = new float[N * num_rows];
-
-    // Send a sub-matrix to each process
-    MPI_Scatter(matrix, N * num_rows, MPI_FLOAT, sub_matrix,
-            N * num_rows, MPI_FLOAT, 0, MPI_COMM_WORLD);
-
-    /*
-     * Gaussian Elimination:
-     * One row normalizes the pivot row, then sends it to all
-     * later ranks for elimination
-     */
-    // Allocate space for a single row to be sent to this rank
-    float *row = new float[N];
-
-    // Get start time
-    if(rank == 0){
-        t_start = MPI_Wtime();
-    }
-
-    // Variables for code clarity
-    int pivot;
-    int scale;
-    int column;
-    int start_row;
-
-    // Receivers go here
-    start_row = rank * num_rows;
-    for(int i = 0; i < start_row; i++){
-        // Wait for the preceeding ranks to forward us a row
-        MPI_Bcast(row, N, MPI_FLOAT, i / num_rows, MPI_COMM_WORLD);
-
-        // Eliminate from this element from all rows mapped to this
-        // rank
-        for(int j = 0; j < num_rows; j++){
-            scale = sub_matrix[j * N + i];
-
-            // Subtract from all other elements in the row
-            for(int k = i + 1; k < N; k++){
-                sub_matrix[j * N + k] -= scale * row[k];
+    float *sub_matrix = new float[(size_t)N * num_rows];
+
+    // Number of pivots per blocked panel
+    int block_size = GE_BLOCK_SIZE;
+
+    // Row of the matrix picked as each pivot
+    int *perm = new int[N];
+
+    // Pivot rows of the blocking version are sent with MPI_Bcast
+    GeBcastPivots pivots;
+    ge_bcast_pivots_init(&pivots, N, block_size);
+
+    // Run the elimination with blocking and with lookahead broadcasts
+    // (warmup runs are not recorded). The residual check needs the
+    // packed LU factorization
+    vector<double> lookahead_times;
+    float *sub_blocking = new float[(size_t)N * num_rows];
+    int *perm_blocking = new int[N];
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        for(int lookahead = 0; lookahead < 2; lookahead++){
+            // Every rank fills its own rows
+            ge_random_mapped(mapping, sub_matrix, N, N, size, rank,
+                    config.seed);
+
+            // Get start time once every rank has its rows
+            MPI_Barrier(MPI_COMM_WORLD);
+            if(rank == 0){
+                t_start = MPI_Wtime();
             }
 
-            // Eliminate the element in the same column as the pivot row
-            sub_matrix[j * N + i] = 0;
-        }
-    }
-
-    // Senders go here
-    for(int i = 0; i < num_rows; i++){
-        // Normalize this row to the pivot
-        column = rank * num_rows + i;
-        pivot = sub_matrix[i * N + column];
-
-        // Normalize every other element in this row to the pivot
-        for(int j = column + 1; j < N; j++){
-           sub_matrix[i * N + j] /= pivot;
-        }
-
-        // Normalize trivial case
-        sub_matrix[i * N + column] = 1;
-
-        // Fill row to be sent
-        memcpy(row, &sub_matrix[i * N], N * sizeof(float));
-
-        // Broadcast the normalized row to everyone else;
-        MPI_Bcast(row, N, MPI_FLOAT, rank, MPI_COMM_WORLD);
-
-        // Update the rest of the rows for this rank
-        for(int j = i + 1; j < num_rows; j++){
-            scale = sub_matrix[j * N + column];
+            if(lookahead){
+                ge_mpi_lookahead(mapping, sub_matrix, N, rank, size, perm,
+                        block_size, N, residual);
+            }else{
+                ge_mpi_blocking(mapping, &pivots, sub_matrix, N, rank, size,
+                        perm_blocking, block_size, residual);
+                memcpy(sub_blocking, sub_matrix,
+                        (size_t)N * num_rows * sizeof(float));
+            }
 
-            // Subtract from all the elements in a lower row
-            for(int k = column + 1; k < N; k++){
-                sub_matrix[j * N + k] -= scale * row[k];
+            // Barrier to track when calculations are done
+            MPI_Barrier(MPI_COMM_WORLD);
+
+            // Stop the time before the gather phase
+            if(rank == 0){
+                t_end = MPI_Wtime();
+                if((r >= config.warmup) && lookahead){
+                    lookahead_times.push_back(t_end - t_start);
+                }else if(r >= config.warmup){
+                    times.push_back(t_end - t_start);
+                }
             }
-            
-            // Eliminate the trivial case
-            sub_matrix[j * N + column] = 0;
         }
     }
 
-    // Finished ranks must still wait with synchronous broadcast
-    for(int i = rank * num_rows + 1; i < N; i++){
-        MPI_Bcast(row, N, MPI_FLOAT, i / num_rows, MPI_COMM_WORLD);
-    }
-
-    // Barrier to track when calculations are done
-    MPI_Barrier(MPI_COMM_WORLD);
+    // Both versions give the same rows and pivots
+    verify_solution(sub_blocking, sub_matrix, num_rows, N);
+    verify_permutation(perm_blocking, perm, N);
 
-    // Stop the time before the gather phase
-    if(rank == 0){
-        t_end = MPI_Wtime();
-        t_total = t_end - t_start;
+    // Check the factorization over the rows of every rank, making the
+    // rows of the matrix again
+    double error = 0;
+    if(residual){
+        error = ge_mpi_check_lu(mapping, NULL, sub_matrix, N, rank, size,
+                perm, config.seed);
     }
 
     /*
      * Collect all Sub-Matrices
-     * All sub-matrices are gathered using the gather function
+     * All sub-matrices are gathered using the gather function (into a
+     * separate matrix, so rank 0 still has the original to check with)
      */
-    MPI_Gather(sub_matrix, N * num_rows, MPI_FLOAT, matrix,
-            N * num_rows, MPI_FLOAT, 0, MPI_COMM_WORLD);
-
+    float *gathered = NULL;
+    if(!residual){
+        // Elements gathered from each rank, and where its rows start in
+        // the matrix
+        int *counts = new int[size];
+        int *displs = new int[size];
+        for(int r = 0; r < size; r++){
+            counts[r] = mapping.num_rows(N, size, r) * N;
+            displs[r] = mapping.row(0, N, size, r) * N;
+        }
+        if(rank == 0){
+            gathered = new float[(size_t)N * N];
+        }
+        MPI_Gatherv(sub_matrix, N * num_rows, MPI_FLOAT, gathered, counts,
+                displs, MPI_FLOAT, 0, MPI_COMM_WORLD);
+        delete[] counts;
+        delete[] displs;
+    }
 
+    ge_bcast_pivots_destroy(&pivots);
     MPI_Finalize();
 
-    // Check the result, and print the time
+    // Print the median time, and every run for the benchmark driver
     if(rank == 0){
         //print_matrix(matrix, N);
-        cout << t_total << " Seconds" << endl;
+        cout << bench_stats(times).median << " Seconds" << endl;
+        cout << bench_stats(lookahead_times).median
+            << " Seconds (lookahead)" << endl;
+        print_bench_line("parallel", N, size, times);
+        print_bench_line("lookahead", N, size, lookahead_times);
     }
 
-    // Free heap-allocated memory
-    if(rank == 0){
-        delete[] matrix;
+    // Verify the lookahead solution
+    if((rank == 0) && residual){
+        cout << "Relative residual = " << error << endl;
+    }else if(rank == 0){
+        int *perm_serial = new int[N];
+        ge_serial(matrix, N, perm_serial, block_size);
+        verify_solution(matrix, gathered, N);
+        verify_permutation(perm_serial, perm, N);
+        delete[] perm_serial;
     }
+
+    // Free heap-allocated memory
+    delete[] matrix;
+    delete[] gathered;
     delete[] sub_matrix;
-    delete[] row;
+    delete[] sub_blocking;
+    delete[] perm;
+    delete[] perm_blocking;
 
     return 0;
 }
-
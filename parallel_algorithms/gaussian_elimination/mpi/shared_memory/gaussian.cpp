@@ -0,0 +1,168 @@
+// This program implements parallel gaussian elimination in C++ using
+// MPI and cyclic striped mapping, with the rows of each node in an MPI
+// shared-memory window (assumes square matrix)
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include "utils.h"
+
+int main(int argc, char *argv[]){
+    // Problem size and runs (-n, -w, -r on the command line), the check
+    // (-v serial or residual), and the most ranks per node (-k, by
+    // default every rank that shares memory)
+    BenchConfig config = ge_bench_defaults(1024, 1);
+    int ranks_per_node = 0;
+    int bench_argc = 1;
+    char **bench_argv = new char*[argc];
+    bench_argv[0] = argv[0];
+    for(int i = 1; i < argc; i++){
+        if((i + 1 < argc) && (strcmp(argv[i], "-k") == 0)){
+            ranks_per_node = atoi(argv[++i]);
+        }else{
+            bench_argv[bench_argc++] = argv[i];
+        }
+    }
+    parse_bench_args(bench_argc, bench_argv, &config);
+    delete[] bench_argv;
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
+    // Declare a problem size
+    int N = config.N;
+
+    // Declate variables for timing
+    double t_start = 0;
+    double t_end;
+    vector<double> times;
+
+    // Unique rank for this process
+    int rank;
+
+    // Total number of ranks
+    int size;
+
+    // Initializes the MPI execution environment
+    MPI_Init(&argc, &argv);
+
+    // Get the rank
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Get the total number ranks in this communicator
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    // Calulate the number of rows based on the number of ranks (the
+    // first N % size ranks get one more)
+    CyclicMapping mapping;
+    int num_rows = mapping.num_rows(N, size, rank);
+
+    // Number of pivots per blocked panel
+    int block_size = GE_BLOCK_SIZE;
+
+    // Find the other ranks of this node, and put our rows in its segment
+    GeNode node;
+    ge_node_init(&node, N, num_rows, block_size, ranks_per_node, rank, size);
+
+    // Only rank 0 needs space for the total solution, and only for the
+    // serial check (every rank makes its own rows of the matrix)
+    float *matrix = NULL;
+    if((rank == 0) && !residual){
+        matrix = new float[(size_t)N * N];
+
+        // Initialize the matrix
+        init_matrix(matrix, N, N, config.seed);
+    }
+
+    // Row of the matrix picked as each pivot
+    int *perm = new int[N];
+
+    // Run the elimination (warmup runs are not recorded). The residual
+    // check needs the packed LU factorization
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        // Every rank fills its own rows in the segment of its node
+        ge_random_mapped(mapping, node.sub_matrix, N, N, size, rank,
+                config.seed);
+
+        // Get start time once every rank has its rows
+        MPI_Barrier(MPI_COMM_WORLD);
+        if(rank == 0){
+            t_start = MPI_Wtime();
+        }
+
+        ge_mpi_blocking(mapping, &node, node.sub_matrix, N, rank, size,
+                perm, block_size, residual);
+
+        // Barrier to track when calculations are done
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        // Stop the time before the gather phase
+        if(rank == 0){
+            t_end = MPI_Wtime();
+            if(r >= config.warmup){
+                times.push_back(t_end - t_start);
+            }
+        }
+    }
+
+    // Check the factorization over the rows of every rank, making the
+    // rows of the matrix again
+    double error = 0;
+    if(residual){
+        error = ge_mpi_check_lu(mapping, NULL, node.sub_matrix, N, rank,
+                size, perm, config.seed);
+    }
+
+    /*
+     * Collect all Sub-Matrices
+     * All sub-matrices are gathered into a copy for the serial check, so
+     * the original matrix is left to check with
+     */
+    float *matrix_mpi = NULL;
+    if(!residual){
+        // Datatype that moves the rows of every rank with one gather
+        // (plus one for the last N % size rows)
+        GeCyclicRows cyclic_rows;
+        ge_cyclic_rows_init(&cyclic_rows, N, rank, size);
+        if(rank == 0){
+            matrix_mpi = new float[(size_t)N * N];
+        }
+        ge_gather_rows(&cyclic_rows, node.sub_matrix, matrix_mpi);
+        ge_cyclic_rows_destroy(&cyclic_rows);
+    }
+
+    int num_nodes = node.num_nodes;
+    double bytes = node.bytes / (config.warmup + config.reps);
+    ge_node_destroy(&node);
+    MPI_Finalize();
+
+    // Print the median time, the traffic, and every run for the benchmark
+    // driver
+    if(rank == 0){
+        cout << size << " ranks on " << num_nodes << " nodes" << endl;
+        cout << bench_stats(times).median << " Seconds" << endl;
+
+        // Pivot row bytes received per run, by the leaders here and by
+        // every rank if each had its own copy
+        double tail = (double)N * (N - 1) / 2 * sizeof(float);
+        cout << "Pivot row bytes per leader: " << bytes << endl;
+        cout << "Pivot row bytes received: " << (num_nodes - 1) * tail
+            << " (private copies: " << (size - 1) * tail << ")" << endl;
+        print_bench_line("parallel", N, size, times);
+    }
+
+    // Verify the solution
+    if((rank == 0) && residual){
+        cout << "Relative residual = " << error << endl;
+    }else if(rank == 0){
+        int *perm_serial = new int[N];
+        ge_serial(matrix, N, perm_serial, block_size);
+        verify_solution(matrix, matrix_mpi, N);
+        verify_permutation(perm_serial, perm, N);
+        delete[] perm_serial;
+    }
+
+    // Free heap-allocated memory
+    delete[] matrix;
+    delete[] matrix_mpi;
+    delete[] perm;
+
+    return 0;
+}
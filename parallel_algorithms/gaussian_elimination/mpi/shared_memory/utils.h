@@ -0,0 +1,176 @@
+// This file contains utility functions for the MPI Gaussian Elimination
+// with shared-memory windows. The ranks of a node keep their rows in one
+// MPI_Win_allocate_shared segment, so a pivot row is read in place by
+// every rank of its node, and only node leaders send it between nodes
+// By: Nick from CoffeeBeforeArch
+
+#include <mpi.h>
+#include <cstring>
+#include "../../common/common.h"
+#include "../../common/bench.h"
+#include "../../common/mapping.h"
+#include "../../common/mpi_cyclic.h"
+#include "../../common/mpi_blocking.h"
+#include "../../common/mpi_verify.h"
+
+// The node a rank is on, and the shared segment of that node
+struct GeNode {
+    // Dimension of the matrix, and the number of ranks
+    int N;
+    int size;
+    // Ranks of this node, and the node leaders (MPI_COMM_NULL on the
+    // other ranks)
+    MPI_Comm node_comm;
+    MPI_Comm leader_comm;
+    // This rank within its node, and the number of ranks on it
+    int node_rank;
+    int node_size;
+    // This node, and the number of nodes
+    int node_id;
+    int num_nodes;
+    // Node and rank within the node of every rank
+    int *rank_node;
+    int *rank_local;
+    // Shared segment of this node, the rows of every rank of the node in
+    // it, and the pivot rows of a panel sent from other nodes (kept by
+    // the leader)
+    MPI_Win win;
+    float *sub_matrix;
+    float **bases;
+    float *panel;
+    // Bytes of pivot rows sent between nodes
+    double bytes;
+};
+
+// Splits the ranks into nodes and allocates the shared segment of each
+// node
+// Takes the node to fill, the dimension, the number of rows of this rank,
+// the number of pivots per panel, the most ranks per node (0 for every
+// rank that shares memory), this rank, and the number of ranks as
+// arguments
+void ge_node_init(GeNode *g, int N, int num_rows, int block_size,
+        int ranks_per_node, int rank, int size){
+    g->N = N;
+    g->size = size;
+
+    // Ranks that can share memory, optionally split into smaller nodes
+    MPI_Comm shared;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0,
+            MPI_INFO_NULL, &shared);
+    int shared_rank;
+    MPI_Comm_rank(shared, &shared_rank);
+    int color = (ranks_per_node > 0) ? shared_rank / ranks_per_node : 0;
+    MPI_Comm_split(shared, color, shared_rank, &g->node_comm);
+    MPI_Comm_free(&shared);
+    MPI_Comm_rank(g->node_comm, &g->node_rank);
+    MPI_Comm_size(g->node_comm, &g->node_size);
+
+    // Rank 0 of every node is its leader
+    MPI_Comm_split(MPI_COMM_WORLD, (g->node_rank == 0) ? 0 : MPI_UNDEFINED,
+            rank, &g->leader_comm);
+    if(g->node_rank == 0){
+        MPI_Comm_rank(g->leader_comm, &g->node_id);
+        MPI_Comm_size(g->leader_comm, &g->num_nodes);
+    }
+    int node[2] = {g->node_id, g->num_nodes};
+    MPI_Bcast(node, 2, MPI_INT, 0, g->node_comm);
+    g->node_id = node[0];
+    g->num_nodes = node[1];
+
+    // Where every rank is
+    g->rank_node = new int[size];
+    g->rank_local = new int[size];
+    MPI_Allgather(&g->node_id, 1, MPI_INT, g->rank_node, 1, MPI_INT,
+            MPI_COMM_WORLD);
+    MPI_Allgather(&g->node_rank, 1, MPI_INT, g->rank_local, 1, MPI_INT,
+            MPI_COMM_WORLD);
+
+    // Every rank puts its rows in the segment, and the leader also keeps
+    // space for one panel of pivot rows
+    MPI_Aint floats = (MPI_Aint)num_rows * N;
+    if(g->node_rank == 0){
+        floats += (MPI_Aint)block_size * N;
+    }
+    MPI_Win_allocate_shared(floats * sizeof(float), sizeof(float),
+            MPI_INFO_NULL, g->node_comm, &g->sub_matrix, &g->win);
+
+    // Address of the rows of every rank of this node. The panel is at
+    // the end of the leader's part (ranks may have different numbers of
+    // rows)
+    g->bases = new float*[g->node_size];
+    for(int r = 0; r < g->node_size; r++){
+        MPI_Aint bytes;
+        int disp;
+        MPI_Win_shared_query(g->win, r, &bytes, &disp, &g->bases[r]);
+        if(r == 0){
+            g->panel = g->bases[0] + bytes / sizeof(float) -
+                (size_t)block_size * N;
+        }
+    }
+    g->bytes = 0;
+
+    // Loads and stores go straight to the segment, and are made visible
+    // with MPI_Win_sync and a node barrier
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, g->win);
+}
+
+// Frees the shared segment and communicators of a node
+// Takes the node as an argument
+void ge_node_destroy(GeNode *g){
+    MPI_Win_unlock_all(g->win);
+    MPI_Win_free(&g->win);
+    MPI_Comm_free(&g->node_comm);
+    if(g->leader_comm != MPI_COMM_NULL){
+        MPI_Comm_free(&g->leader_comm);
+    }
+    delete[] g->rank_node;
+    delete[] g->rank_local;
+    delete[] g->bases;
+}
+
+// Makes the stores of every rank of a node visible to the others
+// Takes the node as an argument
+void ge_node_sync(GeNode *g){
+    MPI_Win_sync(g->win);
+    MPI_Barrier(g->node_comm);
+    MPI_Win_sync(g->win);
+}
+
+// Gets pivot row i to every rank (the pivot policy of ge_mpi_blocking)
+// Rows are dealt to ranks round robin as in the cyclic version. The
+// owner of a pivot row has factored it in the shared segment, where the
+// rest of its node reads it. The leader of its node then sends it to the
+// other leaders, which receive it into their node's panel
+// Takes the node, the factored pivot row (NULL if this rank does not own
+// it), the rank that owns it, which matrix row it is, the pivot column,
+// and the first column of the panel as arguments
+// Returns the pivot row on this rank
+float *ge_pivot_row(GeNode *g, float *own, int owner, int row, int i,
+        int k0){
+    int N = g->N;
+    ge_node_sync(g);
+
+    // Ranks on the owner's node read the row where it is, and the other
+    // nodes get the columns right of the pivot from their leader (the
+    // panel is not written again until every rank of the node has passed
+    // the next node barrier)
+    bool on_node = (g->rank_node[owner] == g->node_id);
+    float *pivot = &g->panel[(size_t)(i - k0) * N];
+    if(own){
+        pivot = own;
+    }else if(on_node){
+        pivot = g->bases[g->rank_local[owner]] +
+            (size_t)(row / g->size) * N;
+    }
+    if(g->num_nodes > 1){
+        if(g->leader_comm != MPI_COMM_NULL){
+            MPI_Bcast(&pivot[i + 1], N - i - 1, MPI_FLOAT,
+                    g->rank_node[owner], g->leader_comm);
+            g->bytes += (N - i - 1) * sizeof(float);
+        }
+        if(!on_node){
+            ge_node_sync(g);
+        }
+    }
+    return pivot;
+}
@@ -0,0 +1,147 @@
+// This program implements gaussian elimination of a banded matrix in C++
+// using Pthreads (assumes square matrix), and solves one right-hand side
+// with the factorization
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include "utils.h"
+#include "../../common/solve.h"
+
+// Largest matrix also solved densely to check the banded solution
+const int GE_BAND_DENSE_MAX = 2048;
+
+int main(int argc, char *argv[]){
+    // Problem size, threads, runs, and how to check the result (-n, -t,
+    // -w, -r, -v on the command line), and the number of diagonals below
+    // and above the main one (-b, and -u if it differs)
+    BenchConfig config = ge_bench_defaults(65536, 8);
+    int kl = 32;
+    int ku = -1;
+    int bench_argc = 1;
+    char **bench_argv = new char*[argc];
+    bench_argv[0] = argv[0];
+    for(int i = 1; i < argc; i++){
+        if((i + 1 < argc) && (strcmp(argv[i], "-b") == 0)){
+            kl = atoi(argv[++i]);
+        }else if((i + 1 < argc) && (strcmp(argv[i], "-u") == 0)){
+            ku = atoi(argv[++i]);
+        }else{
+            bench_argv[bench_argc++] = argv[i];
+        }
+    }
+    parse_bench_args(bench_argc, bench_argv, &config);
+    delete[] bench_argv;
+    if(ku < 0){
+        ku = kl;
+    }
+
+    // Number of threads to launch
+    int num_threads = config.num_threads;
+
+    // Dimensions of square matrix
+    int N = config.N;
+
+    // Check with the residual of a solve instead of the serial version
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
+    // Declare our problem matrices (band storage only)
+    GeBanded matrix;
+    GeBanded matrix_serial;
+    GeBanded matrix_pthread;
+    ge_banded_init(&matrix, N, kl, ku);
+    ge_banded_init(&matrix_serial, N, kl, ku);
+    ge_banded_init(&matrix_pthread, N, kl, ku);
+
+    // Initialize the matrix and a right-hand side
+    ge_random_banded(&matrix, config.seed);
+    float *b = new float[N];
+    float *x = new float[N];
+    ge_random_row(b, 0, N, config.seed + 1);
+
+    // Factor with the threads via a helper function (warmup runs are not
+    // recorded)
+    vector<double> parallel_times;
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        ge_banded_copy(&matrix_pthread, &matrix);
+        double elapsed = launch_threads(num_threads, &matrix_pthread);
+        if(r >= config.warmup){
+            parallel_times.push_back(elapsed);
+        }
+    }
+
+    // Create timers for our serial version
+    high_resolution_clock::time_point start;
+    high_resolution_clock::time_point end;
+
+    // Call the serial version for our reference solution
+    vector<double> serial_times;
+    for(int r = 0; !residual && (r < config.warmup + config.reps); r++){
+        ge_banded_copy(&matrix_serial, &matrix);
+        start = high_resolution_clock::now();
+        ge_banded_serial(&matrix_serial);
+        end = high_resolution_clock::now();
+        duration<double> elapsed = duration_cast<duration<double>>(end - start);
+        if(r >= config.warmup){
+            serial_times.push_back(elapsed.count());
+        }
+    }
+
+    // Print out the median elapsed times
+    cout << "Bandwidth = " << kl << " below, " << ku << " above" << endl;
+    cout << "Elapsed time parallel = " << bench_stats(parallel_times).median
+        << " seconds" << endl;
+    print_bench_line("parallel", N, num_threads, parallel_times);
+    print_flops_line("parallel", ge_banded_flops(N, kl, ku));
+
+    // Solve with the threaded factorization
+    memcpy(x, b, N * sizeof(float));
+    ge_banded_solve(&matrix_pthread, x);
+
+    // Verify the solution
+    if(residual){
+        cout << "Relative residual = " << ge_banded_residual(&matrix, x, b)
+            << endl;
+    }else{
+        cout << "Elapsed time serial = " << bench_stats(serial_times).median
+            << " seconds" << endl;
+        print_bench_line("serial", N, 1, serial_times);
+        verify_solution(matrix_serial.data, matrix_pthread.data, N,
+                matrix.ld);
+        verify_permutation(matrix_serial.piv, matrix_pthread.piv, N);
+
+        // Small systems are also solved densely, doing O(N^3) work
+        if(N <= GE_BAND_DENSE_MAX){
+            float *dense = new float[(size_t)N * N];
+            float *x_dense = new float[N];
+            ge_banded_to_dense(&matrix, dense);
+            start = high_resolution_clock::now();
+            ge_serial_solve(dense, b, x_dense, N, 1);
+            end = high_resolution_clock::now();
+            duration<double> elapsed =
+                duration_cast<duration<double>>(end - start);
+            cout << "Elapsed time dense serial = " << elapsed.count()
+                << " seconds" << endl;
+
+            // The difference is relative to the size of the solution
+            double diff = 0;
+            double x_norm = 0;
+            for(int i = 0; i < N; i++){
+                diff = max(diff, (double)fabs(x[i] - x_dense[i]));
+                x_norm = max(x_norm, (double)fabs(x_dense[i]));
+            }
+            cout << "Relative difference from the dense solve = "
+                << diff / x_norm << endl;
+            delete[] dense;
+            delete[] x_dense;
+        }
+    }
+
+    // Free heap-allocated memory
+    ge_banded_destroy(&matrix);
+    ge_banded_destroy(&matrix_serial);
+    ge_banded_destroy(&matrix_pthread);
+    delete[] b;
+    delete[] x;
+
+    return 0;
+}
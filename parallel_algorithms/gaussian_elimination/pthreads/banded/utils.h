@@ -0,0 +1,133 @@
+// This file contains utility functions for the banded version of
+// Gaussian Elimination with Pthreads. Each pivot only changes a window
+// of kl rows and kl + ku columns, so pivots are factored in panels, and
+// the threads split the columns of each panel's window between them
+// By: Nick from CoffeeBeforeArch
+
+#include <pthread.h>
+#include <chrono>
+#include "../../common/common.h"
+#include "../../common/banded.h"
+#include "../../common/bench.h"
+
+using namespace std::chrono;
+
+// Pivots factored in one panel (the panel is factored by one thread,
+// so it is kept narrow)
+const int GE_BAND_BLOCK = 16;
+
+// Columns of the window are handed out in multiples of this (one
+// AVX-512 vector of floats)
+const int GE_BAND_COLS = 16;
+
+struct Args {
+    // Thread ID
+    int tid;
+    // Number of threads launched
+    int num_threads;
+    // Banded matrix to factor in place
+    GeBanded *a;
+    // Barrier to synchronize at
+    pthread_barrier_t *barrier;
+};
+
+// Pthread function for the banded factorization
+// Pivots are factored GE_BAND_BLOCK at a time. Thread 0 applies each
+// panel to the columns of the next one and factors it, while the other
+// threads apply the panel to the rest of its window, so the threads
+// only meet at a barrier once per panel
+// Takes a pointer to a struct of args as an argument
+void *ge_banded_parallel(void *args){
+    // Cast void pointer to struct pointer
+    Args *local_args = (Args*)args;
+
+    // Unpack the arguments
+    int tid = local_args->tid;
+    int num_threads = local_args->num_threads;
+    GeBanded *a = local_args->a;
+    pthread_barrier_t *barrier = local_args->barrier;
+    int n = a->n;
+    int nb = GE_BAND_BLOCK;
+
+    // Threads that split the window right of the next panel (thread 0
+    // only helps when it is alone)
+    int helpers = std::max(1, num_threads - 1);
+    int helper = (num_threads == 1) ? 0 : tid - 1;
+    float *work = new float[ge_banded_work_size(a, nb)];
+
+    if(tid == 0){
+        ge_banded_panel(a, 0, std::min(nb, n));
+    }
+    pthread_barrier_wait(barrier);
+
+    for(int k0 = 0; k0 < n; k0 += nb){
+        int k1 = std::min(k0 + nb, n);
+        int next = std::min(k1 + nb, n);
+        int end = ge_band_end_col(a, k1 - 1);
+
+        // Columns of the next panel, which is then factored
+        if(tid == 0){
+            ge_banded_apply(a, k0, k1, k1, std::min(next, end), work);
+            if(k1 < n){
+                ge_banded_panel(a, k1, next);
+            }
+        }
+
+        // Our columns of the rest of the window
+        if(helper >= 0 && next < end){
+            int cols = (end - next + helpers - 1) / helpers;
+            cols = (cols + GE_BAND_COLS - 1) / GE_BAND_COLS * GE_BAND_COLS;
+            int c0 = next + helper * cols;
+            int c1 = std::min(end, c0 + cols);
+            if(c0 < c1){
+                ge_banded_apply(a, k0, k1, c0, c1, work);
+            }
+        }
+
+        // The next panel is applied to columns this one just updated
+        pthread_barrier_wait(barrier);
+    }
+
+    // Free heap-allocated memory
+    delete[] work;
+
+    return 0;
+}
+
+// Helper function to factor a banded matrix with threads
+// Returns the elapsed time in seconds
+double launch_threads(int num_threads, GeBanded *a){
+    // Create array of thread objects we will launch
+    pthread_t *threads = new pthread_t[num_threads];
+    Args *thread_args = new Args[num_threads];
+
+    // Create a barrier
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, num_threads);
+
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+
+    // Launch threads
+    for(int i = 0; i < num_threads; i++){
+        thread_args[i].tid = i;
+        thread_args[i].num_threads = num_threads;
+        thread_args[i].a = a;
+        thread_args[i].barrier = &barrier;
+        start_thread(&threads[i], ge_banded_parallel, (void*)&thread_args[i]);
+    }
+
+    for(int i = 0; i < num_threads; i++){
+        pthread_join(threads[i], NULL);
+    }
+
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+
+    // Free heap-allocated memory
+    pthread_barrier_destroy(&barrier);
+    delete[] threads;
+    delete[] thread_args;
+
+    // Cast timers as double to return
+    duration<double> elapsed = duration_cast<duration<double>>(end - start);
+    return elapsed.count();
+}
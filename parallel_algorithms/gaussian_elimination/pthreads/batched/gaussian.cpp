@@ -0,0 +1,110 @@
+// This program solves a large batch of small independent systems in C++
+// using Pthreads, with the systems interleaved so one elimination runs
+// across SIMD lanes, and reports throughput in systems per second
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include "utils.h"
+
+int main(int argc, char *argv[]){
+    // System size, threads, and runs (-n, -t, -w, -r on the command
+    // line), and whether to time the serial solver and fail on a bad
+    // residual, or only report the residuals (-v serial or residual)
+    BenchConfig config = ge_bench_defaults(16, 8);
+    parse_bench_args(argc, argv, &config);
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
+    // Number of threads to launch
+    int num_threads = config.num_threads;
+
+    // Dimensions of each system, and the number of systems (about 64 MB
+    // of matrices)
+    int N = config.N;
+    int count = max(GE_BATCH_WIDTH, (1 << 24) / (N * N));
+
+    // Declare our problem matrices (one system after the other)
+    float *A = new float[(size_t)count * N * N];
+    float *b = new float[(size_t)count * N];
+    float *x_batched = new float[N];
+
+    // Initialize the systems
+    init_matrix(A, count * N, N, config.seed, config.num_threads);
+    init_matrix(b, count, N, config.seed + 1, config.num_threads);
+
+    // Time the one-system-at-a-time serial solver as the baseline (its
+    // solutions are not kept: float solutions of the nearly singular
+    // systems in a large batch do not agree, so the batched solutions
+    // are checked by their residuals instead, and it is not run for -v
+    // residual)
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    for(int s = 0; !residual && (s < count); s++){
+        ge_serial_solve(&A[(size_t)s * N * N], &b[(size_t)s * N],
+                x_batched, N, 1);
+    }
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+    duration<double> serial = duration_cast<duration<double>>(end - start);
+
+    // Time the batched solver on one thread
+    GeBatch batch;
+    ge_batch_init(&batch, N, count);
+    for(int s = 0; s < count; s++){
+        ge_batch_pack(&batch, s, &A[(size_t)s * N * N], &b[(size_t)s * N]);
+    }
+    start = high_resolution_clock::now();
+    ge_batch_solve(&batch, 0, batch.num_groups);
+    end = high_resolution_clock::now();
+    duration<double> batched = duration_cast<duration<double>>(end - start);
+
+    // Verify the batched solve by its residuals
+    double worst_batched = check_batch(&batch, A, b, x_batched, !residual);
+
+    // Solve the batch with the threads (packing is not timed, and warmup
+    // runs are not recorded)
+    vector<double> parallel_times;
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        for(int s = 0; s < count; s++){
+            ge_batch_pack(&batch, s, &A[(size_t)s * N * N],
+                    &b[(size_t)s * N]);
+        }
+        double elapsed = launch_batch(num_threads, &batch);
+        if(r >= config.warmup){
+            parallel_times.push_back(elapsed);
+        }
+    }
+
+    // Print out the throughput
+    cout << count << " systems of size " << N << endl;
+    if(!residual){
+        cout << "Systems per second serial (one at a time) = "
+            << count / serial.count() << endl;
+    }
+    cout << "Systems per second batched = " << count / batched.count()
+        << endl;
+    cout << "Systems per second parallel = "
+        << count / bench_stats(parallel_times).median << endl;
+    print_throughput_line("parallel", N, num_threads, count,
+            parallel_times);
+    if(!residual){
+        print_throughput_line("serial", N, 1, count,
+                vector<double>(1, serial.count()));
+    }
+    print_throughput_line("batched", N, 1, count,
+            vector<double>(1, batched.count()));
+
+    // Verify the threaded solve by its residuals
+    double worst_parallel = check_batch(&batch, A, b, x_batched, !residual);
+    if(residual){
+        cout << "Largest relative residual batched = " << worst_batched
+            << endl;
+        cout << "Largest relative residual parallel = " << worst_parallel
+            << endl;
+    }
+
+    // Free our heap-allocated memory
+    ge_batch_destroy(&batch);
+    delete[] A;
+    delete[] b;
+    delete[] x_batched;
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+// This file contains utility functions for solving a batch of small
+// systems with Pthreads, where each thread claims groups of interleaved
+// systems until the batch is done
+// By: Nick from CoffeeBeforeArch
+
+#include <pthread.h>
+#include <chrono>
+#include <atomic>
+#include "../../common/common.h"
+#include "../../common/solve.h"
+#include "../../common/batched.h"
+#include "../../common/bench.h"
+
+using namespace std::chrono;
+
+// Number of groups a thread claims at a time
+const int GE_BATCH_CHUNK = 8;
+
+struct Args {
+    // Batch shared by every thread
+    GeBatch *batch;
+    // Next group nobody has claimed yet
+    std::atomic<int> *next;
+};
+
+// Pthread function for solving groups of the batch
+// Takes a pointer to a struct of args as an argument
+void *ge_parallel_batch(void *args){
+    // Cast void pointer to struct pointer
+    Args *local_args = (Args*)args;
+    GeBatch *batch = local_args->batch;
+
+    // Claim chunks of groups until there are none left
+    while(true){
+        int g0 = local_args->next->fetch_add(GE_BATCH_CHUNK);
+        if(g0 >= batch->num_groups){
+            break;
+        }
+        ge_batch_solve(batch, g0, min(g0 + GE_BATCH_CHUNK,
+                    batch->num_groups));
+    }
+
+    return 0;
+}
+
+// Helper function to solve a batch in place with threads
+// Returns the elapsed time in seconds
+double launch_batch(int num_threads, GeBatch *batch){
+    // Create array of thread objects we will launch
+    pthread_t *threads = new pthread_t[num_threads];
+    Args *thread_args = new Args[num_threads];
+    std::atomic<int> next(0);
+
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+
+    // Launch threads
+    for(int i = 0; i < num_threads; i++){
+        thread_args[i].batch = batch;
+        thread_args[i].next = &next;
+        start_thread(&threads[i], ge_parallel_batch, (void*)&thread_args[i]);
+    }
+
+    for(int i = 0; i < num_threads; i++){
+        pthread_join(threads[i], NULL);
+    }
+
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+
+    // Free heap-allocated memory
+    delete[] threads;
+    delete[] thread_args;
+
+    // Cast timers as double to return
+    duration<double> elapsed = duration_cast<duration<double>>(end - start);
+    return elapsed.count();
+}
+
+// Checks every solution of a batch by its relative residual
+// Takes the solved batch, the matrices and right-hand sides it was
+// packed from, a vector of n for each solution, and whether to fail on
+// a residual that is too large (or only report the largest one) as
+// arguments
+// Returns the largest relative residual
+double check_batch(GeBatch *batch, const float *A, const float *b,
+        float *x, bool fail){
+    int n = batch->n;
+    double worst = 0;
+    for(int s = 0; s < batch->count; s++){
+        ge_batch_unpack(batch, s, x);
+        double error = relative_residual(&A[(size_t)s * n * n], x,
+                &b[(size_t)s * n], n);
+        assert(!fail || (error <= 1e-5));
+        worst = ge_max_error(worst, error);
+    }
+    return worst;
+}
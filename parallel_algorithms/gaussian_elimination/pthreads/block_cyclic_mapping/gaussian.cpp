@@ -0,0 +1,190 @@
+// This program implements parallel gaussian elimination in C++ using
+// Pthreads (assumes square matrix) and assigns blocks of rows to each
+// thread round robin (block-cyclic mapping), so every thread keeps work
+// as the pivot moves down the matrix while owning runs of adjacent rows
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include "../../common/row_threads.h"
+
+int main(int argc, char *argv[]){
+    // Problem size, threads, runs, how to check the result, the matrix
+    // layout, and the pivot schedule (-n, -t, -w, -r, -v, -l, -e on the
+    // command line), where to pin the threads (-a compact, scatter,
+    // none, or a list of CPUs like 0,2,4), and the rows per block of the
+    // mapping (-m)
+    BenchConfig config = ge_bench_defaults(2048, 8);
+    const char *pinning = "scatter";
+    int rows_per_block = 16;
+    int bench_argc = 1;
+    char **bench_argv = new char*[argc];
+    bench_argv[0] = argv[0];
+    for(int i = 1; i < argc; i++){
+        if((i + 1 < argc) && (strcmp(argv[i], "-a") == 0)){
+            pinning = argv[++i];
+        }else if((i + 1 < argc) && (strcmp(argv[i], "-m") == 0)){
+            rows_per_block = atoi(argv[++i]);
+        }else{
+            bench_argv[bench_argc++] = argv[i];
+        }
+    }
+    parse_bench_args(bench_argc, bench_argv, &config);
+    delete[] bench_argv;
+    if(rows_per_block < 1){
+        cerr << "Rows per block (-m) must be at least 1" << endl;
+        return 1;
+    }
+
+    // Number of threads to launch
+    int num_threads = config.num_threads;
+
+    // Dimensions of square matrix
+    int N = config.N;
+
+    // Number of pivots per blocked panel
+    int block_size = GE_BLOCK_SIZE;
+
+    // Rows are dealt to the threads in blocks of this many rows
+    // (BlockMapping and CyclicMapping can be used here as well)
+    BlockCyclicMapping mapping = {rows_per_block};
+
+    // Pivot schedule: the barrier-free lookahead pipeline or a barrier
+    // around every pivot, or both (the barrier version is then timed
+    // after the lookahead one and checked against it)
+    bool lookahead = (config.schedule != GE_SCHEDULE_BARRIER);
+    bool both = (config.schedule == GE_SCHEDULE_BOTH);
+
+    // Check with an O(N^2) residual instead of the serial version (the
+    // parallel version then keeps L, and no serial copy or original
+    // matrix is kept: each thread makes its own rows from the seed)
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
+    // Row stride and pages of the parallel matrix (padded rows on
+    // regular pages unless -l says otherwise)
+    GeLayout layout = ge_layout(config.layout);
+
+    // Pin threads to CPUs (compact, scatter, or an explicit CPU list)
+    Affinity affinity = affinity_parse(pinning);
+
+    // Declare our problem matrices
+    float *matrix;
+    float *matrix_serial;
+    GeMatrix<float> matrix_pthread;
+    GeMatrix<float> matrix_barrier = GeMatrix<float>();
+
+    // Declare the row picked as each pivot by each version
+    int *perm;
+    int *perm_pthread;
+    int *perm_barrier;
+
+    // Declare and initialize the size of the matrix
+    size_t bytes = (size_t)N * N * sizeof(float);
+
+    // Allocate space for our matrices
+    matrix = residual ? NULL : new float[(size_t)N * N];
+    matrix_serial = residual ? NULL : new float[(size_t)N * N];
+    matrix_pthread = ge_matrix_alloc<float>(N, N, layout);
+    if(both){
+        matrix_barrier = ge_matrix_alloc<float>(N, N, layout);
+    }
+    if((matrix_pthread.data == NULL) || (both && (matrix_barrier.data ==
+                    NULL))){
+        cerr << "Could not allocate the matrix" << endl;
+        return 1;
+    }
+    perm = new int[N];
+    perm_pthread = new int[N];
+    perm_barrier = new int[N];
+   
+    // Initialize a matrix (each thread copies its own rows into
+    // matrix_pthread, so its pages are placed near that thread)
+    if(!residual){
+        init_matrix(matrix, N, N, config.seed, config.num_threads);
+    }
+    
+    // Print the row kernels picked for this CPU
+    cout << "Elimination kernel = " << ge_kernels.name << endl;
+
+    // Launch the threads via a helper function (warmup runs are not
+    // recorded)
+    vector<double> parallel_times;
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        double elapsed = launch_threads(mapping, num_threads,
+                matrix_pthread, perm_pthread, block_size, lookahead, matrix,
+                &affinity, residual, config.seed);
+        if(r >= config.warmup){
+            parallel_times.push_back(elapsed);
+        }
+    }
+
+    // Time the barrier version as well (same layout, pinning, and
+    // check)
+    vector<double> barrier_times;
+    for(int r = 0; both && (r < config.warmup + config.reps); r++){
+        double elapsed = launch_threads(mapping, num_threads,
+                matrix_barrier, perm_barrier, block_size, false, matrix,
+                &affinity, residual, config.seed);
+        if(r >= config.warmup){
+            barrier_times.push_back(elapsed);
+        }
+    }
+
+    // Create timers for our serial version
+    high_resolution_clock::time_point start;
+    high_resolution_clock::time_point end;
+
+    // Call the serial version for our reference solution
+    vector<double> serial_times;
+    for(int r = 0; !residual && (r < config.warmup + config.reps); r++){
+        memcpy(matrix_serial, matrix, bytes);
+        start = high_resolution_clock::now();
+        ge_serial(matrix_serial, N, perm, block_size);
+        end = high_resolution_clock::now();
+        duration<double> elapsed = duration_cast<duration<double>>(end - start);
+        if(r >= config.warmup){
+            serial_times.push_back(elapsed.count());
+        }
+    }
+
+    // Print out the median elapsed times
+    cout << "Row stride = " << matrix_pthread.ld << " floats, "
+        << ge_pages_name(matrix_pthread.pages) << " pages" << endl;
+    cout << "Elapsed time parallel = " << bench_stats(parallel_times).median
+        << " seconds" << endl;
+    print_bench_line("parallel", N, num_threads, parallel_times);
+    if(both){
+        cout << "Elapsed time barrier = "
+            << bench_stats(barrier_times).median << " seconds" << endl;
+        print_bench_line("barrier", N, num_threads, barrier_times);
+
+        // The two schedules do the same arithmetic in the same order
+        verify_solution(matrix_barrier.data, matrix_pthread.data, N, N,
+                matrix_pthread.ld, matrix_barrier.ld);
+        verify_permutation(perm_barrier, perm_pthread, N);
+    }
+
+    // Verify the solution
+    if(residual){
+        cout << "Relative residual = " << ge_verify_lu(NULL,
+                matrix_pthread.data, perm_pthread, N, num_threads,
+                matrix_pthread.ld, config.seed) << endl;
+    }else{
+        cout << "Elapsed time serial = " << bench_stats(serial_times).median
+            << " seconds" << endl;
+        print_bench_line("serial", N, 1, serial_times);
+        verify_solution(matrix_serial, matrix_pthread.data, N, N,
+                matrix_pthread.ld);
+        verify_permutation(perm, perm_pthread, N);
+    }
+
+    // Free our heap-allocated memory
+    delete[] matrix;
+    delete[] matrix_serial;
+    ge_matrix_free(&matrix_pthread);
+    ge_matrix_free(&matrix_barrier);
+    delete[] perm;
+    delete[] perm_pthread;
+    delete[] perm_barrier;
+
+    return 0;
+}
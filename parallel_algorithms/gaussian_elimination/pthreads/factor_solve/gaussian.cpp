@@ -0,0 +1,117 @@
+// This program factors a matrix once in C++ using Pthreads (assumes
+// square matrix), then solves many right-hand sides against the packed
+// LU from all threads at the same time
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include "utils.h"
+
+int main(int argc, char *argv[]){
+    // Problem size, threads, runs, and how to check the result (-n, -t,
+    // -w, -r, -v on the command line)
+    BenchConfig config = ge_bench_defaults(2048, 8);
+    parse_bench_args(argc, argv, &config);
+
+    // Number of threads to launch
+    int num_threads = config.num_threads;
+
+    // Dimensions of square matrix
+    int N = config.N;
+
+    // The last factorization and its solves are what gets checked
+    if(config.reps < 1){
+        cerr << "At least one timed run (-r) is needed" << endl;
+        return 1;
+    }
+
+    // Number of right-hand sides solved against one factorization
+    int num_rhs = 256;
+
+    // Number of pivots per blocked panel
+    int block_size = GE_BLOCK_SIZE;
+
+    // Check the packed LU and every solution with O(N^2) residuals
+    // instead of the serial version
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
+    // Declare our problem matrices (one right-hand side after the other)
+    float *A = new float[(size_t)N * N];
+    float *B = new float[(size_t)N * num_rhs];
+    float *X = residual ? NULL : new float[(size_t)N * num_rhs];
+    float *X_pthread = new float[(size_t)N * num_rhs];
+
+    // Initialize the system
+    init_matrix(A, N, N, config.seed, config.num_threads);
+    init_matrix(B, num_rhs, N, config.seed + 1, config.num_threads);
+
+    // Print the row kernels picked for this CPU
+    cout << "Elimination kernel = " << ge_kernels.name << endl;
+
+    // Factor once, then solve every right-hand side (warmup runs are not
+    // recorded, and the last factorization is kept to check)
+    GeFactorization f = GeFactorization();
+    vector<double> factor_times;
+    vector<double> solve_times;
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        double factor = launch_factor(num_threads, &f, A, N, block_size);
+        double solve = launch_solves(num_threads, &f, B, X_pthread, num_rhs);
+        if(r + 1 < config.warmup + config.reps){
+            ge_factorization_destroy(&f);
+        }
+        if(r >= config.warmup){
+            factor_times.push_back(factor);
+            solve_times.push_back(solve / num_rhs);
+        }
+    }
+
+    // Print out the median elapsed times
+    cout << "Elapsed time parallel factor = "
+        << bench_stats(factor_times).median << " seconds" << endl;
+    cout << "Time per solve (" << num_threads << " threads solving) = "
+        << bench_stats(solve_times).median << " seconds" << endl;
+    print_bench_line("parallel", N, num_threads, factor_times);
+
+    // Verify the solution
+    if(residual){
+        // Each right-hand side is one row of B and X, so each is checked
+        // as a system of its own
+        double solve_residual = 0;
+        for(int v = 0; v < num_rhs; v++){
+            solve_residual = ge_max_error(solve_residual, ge_verify_solve(A,
+                    &X_pthread[(size_t)v * N], &B[(size_t)v * N], N, 1,
+                    num_threads));
+        }
+        cout << "Relative residual of the factorization = "
+            << ge_verify_lu(A, f.lu, f.perm, N, num_threads) << endl;
+        cout << "Relative residual of the solves = " << solve_residual
+            << endl;
+        ge_factorization_destroy(&f);
+    }else{
+        ge_factorization_destroy(&f);
+
+        // Call the serial version for our reference solution
+        high_resolution_clock::time_point start =
+            high_resolution_clock::now();
+        ge_factor(&f, A, N, block_size);
+        high_resolution_clock::time_point end = high_resolution_clock::now();
+        for(int v = 0; v < num_rhs; v++){
+            ge_lu_solve(&f, &B[(size_t)v * N], &X[(size_t)v * N]);
+        }
+        ge_factorization_destroy(&f);
+
+        // Cast timers as double to print
+        duration<double> elapsed =
+            duration_cast<duration<double>>(end - start);
+        cout << "Elapsed time serial factor = " << elapsed.count()
+            << " seconds" << endl;
+        verify_solution(X, X_pthread, num_rhs, N);
+    }
+
+    // Free our heap-allocated memory
+    delete[] A;
+    delete[] B;
+    delete[] X;
+    delete[] X_pthread;
+
+    return 0;
+}
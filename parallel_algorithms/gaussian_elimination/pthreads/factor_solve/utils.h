@@ -0,0 +1,94 @@
+// This file contains utility functions for factoring a matrix once with
+// Pthreads and then solving many right-hand sides against it from many
+// threads at the same time
+// By: Nick from CoffeeBeforeArch
+
+#include <pthread.h>
+#include <chrono>
+#include "../../common/common.h"
+#include "../../common/lu.h"
+#include "../../common/bench.h"
+#include "../../common/verify.h"
+
+using namespace std::chrono;
+
+struct SolveArgs {
+    // Thread ID
+    int tid;
+    // Number of threads launched
+    int num_threads;
+    // Factorization shared (read only) by every thread
+    const GeFactorization *f;
+    // Right-hand sides and solutions, one vector of length n after the
+    // other
+    const float *B;
+    float *X;
+    int num_rhs;
+};
+
+// Pthread function for solving a share of the right-hand sides
+// Takes a pointer to a struct of args as an argument
+void *ge_parallel_solves(void *args){
+    // Cast void pointer to struct pointer
+    SolveArgs *local_args = (SolveArgs*)args;
+    int n = local_args->f->n;
+
+    // Every thread solves against the same handle
+    for(int v = local_args->tid; v < local_args->num_rhs;
+            v += local_args->num_threads){
+        ge_lu_solve(local_args->f, &local_args->B[(size_t)v * n],
+                &local_args->X[(size_t)v * n]);
+    }
+
+    return 0;
+}
+
+// Helper function to factor a matrix into a handle with threads
+// Returns the elapsed time in seconds
+double launch_factor(int num_threads, GeFactorization *f, const float *A,
+        int n, int block_size = GE_BLOCK_SIZE){
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    ge_parallel_factor(f, A, n, num_threads, block_size);
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+
+    // Cast timers as double to return
+    duration<double> elapsed = duration_cast<duration<double>>(end - start);
+    return elapsed.count();
+}
+
+// Helper function to solve many right-hand sides against one handle
+// with threads
+// Returns the elapsed time in seconds
+double launch_solves(int num_threads, const GeFactorization *f,
+        const float *B, float *X, int num_rhs){
+    // Create array of thread objects we will launch
+    pthread_t *threads = new pthread_t[num_threads];
+    SolveArgs *thread_args = new SolveArgs[num_threads];
+
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+
+    // Launch threads
+    for(int i = 0; i < num_threads; i++){
+        thread_args[i].tid = i;
+        thread_args[i].num_threads = num_threads;
+        thread_args[i].f = f;
+        thread_args[i].B = B;
+        thread_args[i].X = X;
+        thread_args[i].num_rhs = num_rhs;
+        start_thread(&threads[i], ge_parallel_solves, (void*)&thread_args[i]);
+    }
+
+    for(int i = 0; i < num_threads; i++){
+        pthread_join(threads[i], NULL);
+    }
+
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+
+    // Free heap-allocated memory
+    delete[] threads;
+    delete[] thread_args;
+
+    // Cast timers as double to return
+    duration<double> elapsed = duration_cast<duration<double>>(end - start);
+    return elapsed.count();
+}
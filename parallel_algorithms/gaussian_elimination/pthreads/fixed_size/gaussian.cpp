@@ -0,0 +1,119 @@
+// This program eliminates many small matrices in C++ using Pthreads,
+// with the size fixed at compile time so every loop is unrolled, and
+// reports throughput in matrices per second (float matrices, then
+// systems [A | b] of double, complex<float>, and complex<double>)
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include "utils.h"
+
+int main(int argc, char *argv[]){
+    // Matrix size, threads, and runs (-n, -t, -w, -r on the command line)
+    BenchConfig config = ge_bench_defaults(16, 8);
+    parse_bench_args(argc, argv, &config);
+
+    // The unrolled elimination drops the multipliers, so the float
+    // matrices can only be checked against a reference elimination (the
+    // other types are always checked by residual)
+    if(config.verify == GE_VERIFY_RESIDUAL){
+        cerr << "No residual check (-v residual) for the unrolled version"
+            << endl;
+        return 1;
+    }
+
+    // Number of threads to launch
+    int num_threads = config.num_threads;
+
+    // Dimensions of each matrix (4, 8, 16, or 32), and the number of
+    // matrices (about 64 MB of them)
+    int N = config.N;
+    GeFixedFunc<float> func = ge_fixed_func<float>(N);
+    if(func == NULL){
+        cout << "No unrolled version for N = " << N << endl;
+        return 1;
+    }
+    int count = (1 << 24) / (N * N);
+
+    // Declare our problem matrices (one after the other)
+    size_t size = (size_t)count * N * N;
+    float *matrices = new float[size];
+    float *matrix_serial = new float[size];
+    float *matrix_fixed = new float[size];
+    int *perm_serial = new int[(size_t)count * N];
+    int *perm_fixed = new int[(size_t)count * N];
+
+    // Initialize the matrices
+    init_matrix(matrices, count * N, N, config.seed, config.num_threads);
+    memcpy(matrix_serial, matrices, size * sizeof(float));
+
+    // Time the runtime-N serial version as the baseline
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    for(int s = 0; s < count; s++){
+        ge_serial(&matrix_serial[(size_t)s * N * N], N,
+                &perm_serial[(size_t)s * N]);
+    }
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+    duration<double> serial = duration_cast<duration<double>>(end - start);
+
+    // Time the unrolled version on one thread
+    memcpy(matrix_fixed, matrices, size * sizeof(float));
+    start = high_resolution_clock::now();
+    for(int s = 0; s < count; s++){
+        func(&matrix_fixed[(size_t)s * N * N], &perm_fixed[(size_t)s * N]);
+    }
+    end = high_resolution_clock::now();
+    duration<double> fixed = duration_cast<duration<double>>(end - start);
+
+    // Eliminate with the threads (copying is not timed, and warmup runs
+    // are not recorded)
+    vector<double> parallel_times;
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        memcpy(matrix_fixed, matrices, size * sizeof(float));
+        double elapsed = launch_fixed(num_threads, func, matrix_fixed,
+                perm_fixed, N, count);
+        if(r >= config.warmup){
+            parallel_times.push_back(elapsed);
+        }
+    }
+
+    // Print out the throughput
+    cout << count << " matrices of size " << N << endl;
+    cout << "Matrices per second serial (runtime N) = "
+        << count / serial.count() << endl;
+    cout << "Matrices per second unrolled = " << count / fixed.count()
+        << endl;
+    cout << "Matrices per second parallel = "
+        << count / bench_stats(parallel_times).median << endl;
+    print_throughput_line("parallel", N, num_threads, count,
+            parallel_times);
+    print_throughput_line("serial", N, 1, count,
+            vector<double>(1, serial.count()));
+    print_throughput_line("unrolled", N, 1, count,
+            vector<double>(1, fixed.count()));
+
+    // Verify the solution against a reference elimination
+    // The unrolled rows multiply then subtract, while the kernels picked
+    // for this CPU may fuse the two (FMA) and round differently, so the
+    // reference is given the scalar kernels
+    memcpy(matrix_serial, matrices, size * sizeof(float));
+    for(int s = 0; s < count; s++){
+        ge_fixed_reference(&matrix_serial[(size_t)s * N * N], N,
+                &perm_serial[(size_t)s * N], ge_scalar_kernels);
+    }
+    verify_solution(matrix_serial, matrix_fixed, count * N, N);
+    verify_permutation(perm_serial, perm_fixed, count * N);
+
+    // Free our heap-allocated memory
+    delete[] matrices;
+    delete[] matrix_serial;
+    delete[] matrix_fixed;
+    delete[] perm_serial;
+    delete[] perm_fixed;
+
+    // The other element types solve a system each, checked by residual
+    bench_fixed_solve<double>("double", config);
+    bench_fixed_solve<complex<float> >("complex_float", config);
+    bench_fixed_solve<complex<double> >("complex_double", config);
+
+    return 0;
+}
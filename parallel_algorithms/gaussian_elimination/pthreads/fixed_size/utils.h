@@ -0,0 +1,257 @@
+// This file contains utility functions for eliminating many small
+// matrices of a size known at compile time with Pthreads, where each
+// thread claims chunks of matrices until they are all done
+// By: Nick from CoffeeBeforeArch
+
+#include <pthread.h>
+#include <chrono>
+#include <atomic>
+#include <limits>
+#include "../../common/common.h"
+#include "../../common/fixed.h"
+#include "../../common/bench.h"
+
+using namespace std::chrono;
+
+// Number of matrices a thread claims at a time
+const int GE_FIXED_CHUNK = 256;
+
+// Elimination of one small matrix (an instance of ge_fixed)
+template <typename T>
+using GeFixedFunc = void (*)(T *matrix, int *perm);
+
+// Picks the unrolled elimination for a matrix size
+// Takes the dimension as an argument (Extra is the number of columns
+// after the first n, e.g. 1 for [A | b])
+// Returns NULL if there is no unrolled version of that size
+template <typename T, int Extra = 0>
+GeFixedFunc<T> ge_fixed_func(int n){
+    switch(n){
+        case 4: return ge_fixed<T, 4, 4 + Extra>;
+        case 8: return ge_fixed<T, 8, 8 + Extra>;
+        case 16: return ge_fixed<T, 16, 16 + Extra>;
+        case 32: return ge_fixed<T, 32, 32 + Extra>;
+        default: return NULL;
+    }
+}
+
+template <typename T>
+struct Args {
+    // Elimination to run on each matrix
+    GeFixedFunc<T> func;
+    // Matrices (one after the other), their permutation vectors, their
+    // dimension, their row length, and how many there are
+    T *matrices;
+    int *perms;
+    int n;
+    int cols;
+    int count;
+    // Next matrix nobody has claimed yet
+    std::atomic<int> *next;
+};
+
+// Pthread function for eliminating chunks of the matrices
+// Takes a pointer to a struct of args as an argument
+template <typename T>
+void *ge_parallel_fixed(void *args){
+    // Cast void pointer to struct pointer
+    Args<T> *local_args = (Args<T>*)args;
+    int n = local_args->n;
+    int cols = local_args->cols;
+    int count = local_args->count;
+
+    // Claim chunks of matrices until there are none left
+    while(true){
+        int s0 = local_args->next->fetch_add(GE_FIXED_CHUNK);
+        if(s0 >= count){
+            break;
+        }
+        for(int s = s0; s < min(s0 + GE_FIXED_CHUNK, count); s++){
+            local_args->func(&local_args->matrices[(size_t)s * n * cols],
+                    &local_args->perms[(size_t)s * n]);
+        }
+    }
+
+    return 0;
+}
+
+// Helper function to eliminate every matrix in place with threads
+// Takes the number of threads, the elimination to run, the matrices,
+// their permutation vectors, their dimension, how many there are, and
+// their row length (0 if it is the dimension) as arguments
+// Returns the elapsed time in seconds
+template <typename T>
+double launch_fixed(int num_threads, GeFixedFunc<T> func, T *matrices,
+        int *perms, int n, int count, int cols = 0){
+    // Create array of thread objects we will launch
+    pthread_t *threads = new pthread_t[num_threads];
+    Args<T> *thread_args = new Args<T>[num_threads];
+    std::atomic<int> next(0);
+
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+
+    // Launch threads
+    for(int i = 0; i < num_threads; i++){
+        thread_args[i].func = func;
+        thread_args[i].matrices = matrices;
+        thread_args[i].perms = perms;
+        thread_args[i].n = n;
+        thread_args[i].cols = cols ? cols : n;
+        thread_args[i].count = count;
+        thread_args[i].next = &next;
+        start_thread(&threads[i], ge_parallel_fixed<T>,
+                (void*)&thread_args[i]);
+    }
+
+    for(int i = 0; i < num_threads; i++){
+        pthread_join(threads[i], NULL);
+    }
+
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+
+    // Free heap-allocated memory
+    delete[] threads;
+    delete[] thread_args;
+
+    // Cast timers as double to return
+    duration<double> elapsed = duration_cast<duration<double>>(end - start);
+    return elapsed.count();
+}
+
+// Reference elimination of one matrix, pivot by pivot with the kernels
+// it is given (not the ones picked for this CPU), in the same order as
+// ge_fixed, so with the scalar kernels the two match exactly
+// Takes the matrix, its dimension, the permutation vector, and the
+// kernels as arguments
+void ge_fixed_reference(float *matrix, int n, int *perm,
+        const GeKernels &kernels){
+    // Rows are never moved, only the pointers to them
+    float **rows = new float*[n];
+    int *ids = new int[n];
+    for(int r = 0; r < n; r++){
+        rows[r] = &matrix[(size_t)r * n];
+        ids[r] = r;
+    }
+
+    for(int i = 0; i < n; i++){
+        // Largest magnitude in column i (ties go to the lowest row)
+        int pos = i;
+        float best = std::fabs(rows[i][i]);
+        for(int r = i + 1; r < n; r++){
+            float value = std::fabs(rows[r][i]);
+            if((value > best) || ((value == best) && (ids[r] < ids[pos]))){
+                best = value;
+                pos = r;
+            }
+        }
+        ge_swap_rows(rows, ids, i, pos);
+        perm[i] = ids[i];
+
+        // Normalize the pivot row, then eliminate the remaining rows
+        float *pivot_row = rows[i];
+        kernels.scale(pivot_row, 1.0f / pivot_row[i], n);
+        pivot_row[i] = 1;
+        for(int r = i + 1; r < n; r++){
+            kernels.eliminate(rows[r], pivot_row, rows[r][i], n);
+            rows[r][i] = 0;
+        }
+    }
+
+    delete[] rows;
+    delete[] ids;
+}
+
+// Solves one eliminated system [U | y] (row perm[i] holds row i of U,
+// with a unit diagonal, and y after it) and checks the solution
+// ||A x - b|| / (||A|| ||x|| + ||b||) in the infinity norm
+// Takes the original [A | b], the eliminated one, the permutation
+// vector, the dimension, and a vector of n for x as arguments
+// Returns the relative residual
+template <typename T>
+double ge_fixed_residual(const T *original, const T *eliminated,
+        const int *perm, int n, T *x){
+    typedef typename GeReal<T>::type R;
+    int cols = n + 1;
+
+    // Back substitution
+    for(int i = n - 1; i >= 0; i--){
+        const T *row = &eliminated[(size_t)perm[i] * cols];
+        T sum = row[n];
+        for(int j = i + 1; j < n; j++){
+            sum -= row[j] * x[j];
+        }
+        x[i] = sum;
+    }
+
+    double error = 0;
+    double norm = 0;
+    double x_norm = 0;
+    double b_norm = 0;
+    for(int i = 0; i < n; i++){
+        const T *row = &original[(size_t)i * cols];
+        T r = -row[n];
+        R abs_sum = 0;
+        for(int j = 0; j < n; j++){
+            r += row[j] * x[j];
+            abs_sum += std::abs(row[j]);
+        }
+        error = ge_max_error(error, std::abs(r));
+        norm = ge_max_error(norm, abs_sum);
+        x_norm = ge_max_error(x_norm, std::abs(x[i]));
+        b_norm = ge_max_error(b_norm, std::abs(row[n]));
+    }
+    return ge_relative_error(error, norm * x_norm + b_norm);
+}
+
+// Times the threaded unrolled elimination of many systems [A | b] of
+// type T, then solves each one and checks its residual
+// Takes the name to print and the bench config as arguments
+template <typename T>
+void bench_fixed_solve(const char *name, const BenchConfig &config){
+    typedef typename GeReal<T>::type R;
+    int N = config.N;
+    int num_threads = config.num_threads;
+    GeFixedFunc<T> func = ge_fixed_func<T, 1>(N);
+
+    // Number of systems (about 64 MB of them)
+    int cols = N + 1;
+    int count = (1 << 26) / (sizeof(T) * N * cols);
+    size_t size = (size_t)count * N * cols;
+    T *systems = new T[size];
+    T *eliminated = new T[size];
+    int *perms = new int[(size_t)count * N];
+    init_matrix(systems, count * N, cols, config.seed, num_threads);
+
+    // Eliminate with the threads (copying is not timed, and warmup runs
+    // are not recorded)
+    vector<double> times;
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        std::copy(systems, systems + size, eliminated);
+        double elapsed = launch_fixed(num_threads, func, eliminated, perms,
+                N, count, cols);
+        if(r >= config.warmup){
+            times.push_back(elapsed);
+        }
+    }
+    cout << "Systems per second " << name << " = "
+        << count / bench_stats(times).median << endl;
+    print_throughput_line(name, N, num_threads, count, times);
+
+    // Check every solution by its residual
+    T *x = new T[N];
+    double worst = 0;
+    for(int s = 0; s < count; s++){
+        worst = ge_max_error(worst, ge_fixed_residual(
+                    &systems[(size_t)s * N * cols],
+                    &eliminated[(size_t)s * N * cols],
+                    &perms[(size_t)s * N], N, x));
+    }
+    cout << "Largest relative residual " << name << " = " << worst << endl;
+    assert(worst <= 100 * N * std::numeric_limits<R>::epsilon());
+
+    // Free our heap-allocated memory
+    delete[] systems;
+    delete[] eliminated;
+    delete[] perms;
+    delete[] x;
+}
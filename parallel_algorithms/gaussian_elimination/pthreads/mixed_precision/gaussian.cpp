@@ -0,0 +1,134 @@
+// This program solves Ax = b to double accuracy in C++ using Pthreads
+// (assumes square matrix) by factoring in float and refining the
+// solution in double
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include "utils.h"
+
+int main(int argc, char *argv[]){
+    // Problem size, threads, runs, and how to check the result (-n, -t,
+    // -w, -r, -v on the command line)
+    BenchConfig config = ge_bench_defaults(2048, 8);
+    parse_bench_args(argc, argv, &config);
+
+    // Number of threads to launch
+    int num_threads = config.num_threads;
+
+    // Dimensions of square matrix
+    int N = config.N;
+
+    // Check only the O(N^2) backward error, without the serial double
+    // solve to compare against
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
+    // Backward error to reach, and the most corrections to try
+    double tol = 1e-14;
+    int max_iter = 30;
+
+    // Declare our problem (b = A x_true, so the error can be measured)
+    float *A_float = new float[(size_t)N * N];
+    double *A = new double[(size_t)N * N];
+    double *b = new double[N];
+    double *x_true = new double[N];
+    double *x = new double[N];
+    double *x_double = new double[N];
+
+    // Initialize the system
+    init_matrix(A_float, N, N, config.seed, config.num_threads);
+    for(size_t i = 0; i < (size_t)N * N; i++){
+        A[i] = A_float[i];
+    }
+    for(int i = 0; i < N; i++){
+        x_true[i] = 1.0 + (i % 10) / 3.0;
+    }
+    for(int i = 0; i < N; i++){
+        b[i] = 0;
+        for(int j = 0; j < N; j++){
+            b[i] += A[(size_t)i * N + j] * x_true[j];
+        }
+    }
+
+    // Print the row kernels picked for this CPU
+    cout << "Elimination kernel = " << ge_kernels.name << endl;
+
+    // Solve with the threads via a helper function (warmup runs are not
+    // recorded)
+    GeRefineStats stats;
+    vector<double> parallel_times;
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        launch_mixed_solve(num_threads, A, b, x, N, tol, max_iter, &stats);
+        if(r >= config.warmup){
+            parallel_times.push_back(stats.factor_seconds +
+                    stats.refine_seconds + stats.fallback_seconds);
+        }
+    }
+
+    // Call the double version for our reference solution
+    duration<double> elapsed(0);
+    if(!residual){
+        high_resolution_clock::time_point start =
+            high_resolution_clock::now();
+        ge_serial_solve<double>(A, b, x_double, N, 1);
+        high_resolution_clock::time_point end = high_resolution_clock::now();
+        elapsed = duration_cast<duration<double>>(end - start);
+    }
+
+    // Largest error of each solution against the true one
+    double error = 0;
+    double error_double = 0;
+    for(int i = 0; i < N; i++){
+        error = ge_max_error(error, fabs(x[i] - x_true[i]));
+        if(!residual){
+            error_double = ge_max_error(error_double,
+                    fabs(x_double[i] - x_true[i]));
+        }
+    }
+
+    // Print out the iterations, the time split, and the errors
+    cout << "Refinement iterations = " << stats.iterations
+        << (stats.converged ? "" : " (did not converge, fell back)") << endl;
+    cout << "Elapsed time float factor = " << stats.factor_seconds
+        << " seconds" << endl;
+    cout << "Elapsed time double refine = " << stats.refine_seconds
+        << " seconds" << endl;
+    cout << "Elapsed time double fallback = " << stats.fallback_seconds
+        << " seconds" << endl;
+    cout << "Backward error = " << stats.backward_error << endl;
+    if(residual){
+        cout << "Max error mixed = " << error << endl;
+    }else{
+        cout << "Elapsed time serial double solve = " << elapsed.count()
+            << " seconds" << endl;
+        cout << "Max error mixed = " << error << ", double = "
+            << error_double << endl;
+    }
+    print_bench_line("parallel", N, num_threads, parallel_times);
+
+    // Verify the solution reached the tolerance one way or another (the
+    // fallback has to reach it too)
+    assert(stats.backward_error <= tol);
+
+    // Force the fallback, so the double path is checked even when
+    // refinement converges (another O(N^3) solve, so -v residual skips
+    // it along with the serial double solve)
+    if(!residual){
+        GeRefineStats forced;
+        launch_mixed_solve(num_threads, A, b, x, N, tol, max_iter, &forced,
+                true);
+        cout << "Backward error of the forced fallback = "
+            << forced.backward_error << endl;
+        assert(forced.fell_back);
+        assert(forced.backward_error <= tol);
+    }
+
+    // Free our heap-allocated memory
+    delete[] A_float;
+    delete[] A;
+    delete[] b;
+    delete[] x_true;
+    delete[] x;
+    delete[] x_double;
+
+    return 0;
+}
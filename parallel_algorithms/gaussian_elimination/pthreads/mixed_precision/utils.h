@@ -0,0 +1,48 @@
+// This file contains utility functions for the mixed-precision solve
+// with Pthreads: the threads factor a float copy of A, then the solution
+// is refined in double
+// By: Nick from CoffeeBeforeArch
+
+#include <pthread.h>
+#include <chrono>
+#include "../../common/common.h"
+#include "../../common/refine.h"
+#include "../../common/solve.h"
+#include "../../common/bench.h"
+
+using namespace std::chrono;
+
+// Helper function for the mixed-precision solve of Ax = b
+// The threads factor in float, then x is refined in double until its
+// backward error reaches tol, with a threaded double factorization as
+// the fallback (taken even after refinement converged when forced)
+// Takes the number of threads, A (n x n) and b in double, x, the
+// dimension, the tolerance, the maximum number of corrections, the
+// stats to fill, whether to force the fallback, and the number of
+// pivots per panel as arguments
+void launch_mixed_solve(int num_threads, const double *A, const double *b,
+        double *x, int n, double tol, int max_iter, GeRefineStats *stats,
+        bool force_fallback = false, int block_size = GE_BLOCK_SIZE){
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+
+    // Factor a float copy of A with the threads (each rounds its own
+    // rows)
+    GeFactorization f;
+    ge_parallel_factor(&f, A, n, num_threads, block_size);
+
+    high_resolution_clock::time_point factored = high_resolution_clock::now();
+
+    // Refine in double
+    ge_refine(&f, A, b, x, tol, max_iter, stats);
+
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+    stats->factor_seconds = duration<double>(factored - start).count();
+    stats->refine_seconds = duration<double>(end - factored).count();
+
+    // Fall back to a double factorization with the same threads
+    ge_refine_fallback(A, b, x, n, stats, num_threads, block_size,
+            force_fallback);
+
+    // Free heap-allocated memory
+    ge_factorization_destroy(&f);
+}
@@ -0,0 +1,112 @@
+// This program solves AX = B in parallel in C++ using Pthreads
+// (assumes square A) for a block of right-hand sides at once
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include "utils.h"
+
+int main(int argc, char *argv[]){
+    // Problem size, threads, runs, and how to check the result (-n, -t,
+    // -w, -r, -v on the command line), and the number of right-hand
+    // sides (-k)
+    BenchConfig config = ge_bench_defaults(2048, 8);
+    int nrhs = 16;
+    int bench_argc = 1;
+    char **bench_argv = new char*[argc];
+    bench_argv[0] = argv[0];
+    for(int i = 1; i < argc; i++){
+        if((i + 1 < argc) && (strcmp(argv[i], "-k") == 0)){
+            nrhs = atoi(argv[++i]);
+        }else{
+            bench_argv[bench_argc++] = argv[i];
+        }
+    }
+    parse_bench_args(bench_argc, bench_argv, &config);
+    delete[] bench_argv;
+    if(nrhs < 1){
+        cerr << "Right-hand sides (-k) must be at least 1" << endl;
+        return 1;
+    }
+
+    // Number of threads to launch
+    int num_threads = config.num_threads;
+
+    // Number of equations
+    int N = config.N;
+
+    // Number of pivots per blocked panel
+    int block_size = GE_BLOCK_SIZE;
+
+    // Check with the residual A X - B instead of the serial version
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
+    // Declare our problem matrices
+    float *A;
+    float *B;
+    float *X;
+    float *X_pthread;
+
+    // Allocate space for our matrices
+    A = new float[(size_t)N * N];
+    B = new float[(size_t)N * nrhs];
+    X = residual ? NULL : new float[(size_t)N * nrhs];
+    X_pthread = new float[(size_t)N * nrhs];
+
+    // Initialize the system
+    init_matrix(A, N, N, config.seed, config.num_threads);
+    init_matrix(B, N, nrhs, config.seed + 1, config.num_threads);
+
+    // Print the row kernels picked for this CPU
+    cout << "Elimination kernel = " << ge_kernels.name << endl;
+
+    // Solve with the threads via a helper function (warmup runs are not
+    // recorded)
+    vector<double> parallel_times;
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        double elapsed = solve_system(num_threads, A, B, X_pthread, N, nrhs,
+                block_size);
+        if(r >= config.warmup){
+            parallel_times.push_back(elapsed);
+        }
+    }
+
+    // Create timers for our serial version
+    high_resolution_clock::time_point start;
+    high_resolution_clock::time_point end;
+
+    // Call the serial version for our reference solution
+    vector<double> serial_times;
+    for(int r = 0; !residual && (r < config.warmup + config.reps); r++){
+        start = high_resolution_clock::now();
+        ge_serial_solve(A, B, X, N, nrhs, block_size);
+        end = high_resolution_clock::now();
+        duration<double> elapsed = duration_cast<duration<double>>(end - start);
+        if(r >= config.warmup){
+            serial_times.push_back(elapsed.count());
+        }
+    }
+
+    // Print out the median elapsed times
+    cout << "Elapsed time parallel = " << bench_stats(parallel_times).median
+        << " seconds" << endl;
+    print_bench_line("parallel", N, num_threads, parallel_times);
+
+    // Verify the solution
+    if(residual){
+        cout << "Relative residual = " << ge_verify_solve(A, X_pthread, B,
+                N, nrhs, num_threads) << endl;
+    }else{
+        cout << "Elapsed time serial = " << bench_stats(serial_times).median
+            << " seconds" << endl;
+        print_bench_line("serial", N, 1, serial_times);
+        verify_solution(X, X_pthread, N, nrhs);
+    }
+
+    // Free our heap-allocated memory
+    delete[] A;
+    delete[] B;
+    delete[] X;
+    delete[] X_pthread;
+
+    return 0;
+}
@@ -0,0 +1,209 @@
+// This file contains utility functions for solving Ax = B in parallel
+// with Pthreads: the lookahead elimination of an augmented matrix
+// followed by a blocked back substitution on the same threads
+// By: Nick from CoffeeBeforeArch
+
+#include <pthread.h>
+#include <chrono>
+#include "../../common/common.h"
+#include "../../common/lookahead.h"
+#include "../../common/solve.h"
+#include "../../common/bench.h"
+#include "../../common/verify.h"
+#include "../../common/perf_cycle.h"
+
+using namespace std::chrono;
+
+// Right-hand sides are split between the threads once each thread gets
+// at least this many columns, otherwise the rows are split
+const int GE_MIN_SLICE_COLS = 16;
+
+struct Args {
+    // Thread ID
+    int tid;
+    // Number of threads launched
+    int num_threads;
+    // Augmented matrix [A | B] of floating point numbers
+    float *matrix;
+    // Number of equations, and of right-hand sides
+    int n;
+    int nrhs;
+    // Number of pivots per blocked panel
+    int block_size;
+    // Row of the matrix picked as each pivot
+    int *perm;
+    // Counters used by the lookahead pipeline
+    GeLookahead *la;
+    // Pivot rows in order, filled in by all threads after elimination
+    float **pivot_rows;
+    // Barrier to synchronize at
+    pthread_barrier_t *barrier;
+    // Variables needed for timing
+    int *counter;
+    pthread_mutex_t *mtx;
+    pthread_cond_t *cond;
+    high_resolution_clock::time_point *start;
+    high_resolution_clock::time_point *end;
+};
+
+// Pthread function for solving an augmented system
+// Takes a pointer to a struct of args as an argument
+void *ge_parallel_solve(void *args){
+    // Cast void pointer to struct pointer
+    Args *local_args = (Args*)args;
+
+    // Unpack the arguments
+    int tid = local_args->tid;
+    int num_threads = local_args->num_threads;
+    float *matrix = local_args->matrix;
+    int n = local_args->n;
+    int nrhs = local_args->nrhs;
+    int ncols = n + nrhs;
+    int block_size = local_args->block_size;
+    int *perm = local_args->perm;
+    float **pivot_rows = local_args->pivot_rows;
+    pthread_barrier_t *barrier = local_args->barrier;
+
+    // Cyclic striped mapping of the rows to the threads
+    int num_rows = (n - tid + num_threads - 1) / num_threads;
+    float **rows = new float*[num_rows];
+    int *ids = new int[num_rows];
+    for(int j = 0; j < num_rows; j++){
+        rows[j] = &matrix[(size_t)(j * num_threads + tid) * ncols];
+        ids[j] = j * num_threads + tid;
+    }
+
+    // Wait for all threads to be created before profiling
+    perf_cycle(num_threads, local_args->counter, local_args->mtx,
+            local_args->cond, local_args->start);
+
+    // Eliminate A, which forward substitutes every right-hand side
+    ge_lookahead(local_args->la, matrix, n, ncols, block_size, perm, tid,
+            rows, ids, num_rows);
+
+    // Every pivot must be picked before listing the pivot rows in order
+    pthread_barrier_wait(barrier);
+    for(int i = tid; i < n; i += num_threads){
+        pivot_rows[i] = &matrix[(size_t)perm[i] * ncols];
+    }
+    pthread_barrier_wait(barrier);
+
+    if(nrhs >= num_threads * GE_MIN_SLICE_COLS){
+        // Each thread back substitutes its own slice of the right-hand
+        // sides, so no more synchronization is needed
+        int c0 = n + (int)((long)tid * nrhs / num_threads);
+        int c1 = n + (int)((long)(tid + 1) * nrhs / num_threads);
+        ge_back_substitution(pivot_rows, n, c0, c1, block_size);
+    }else{
+        // Solve each diagonal block on one thread, then split the rows
+        // above it between the threads
+        for(int b0 = ((n - 1) / block_size) * block_size; b0 >= 0;
+                b0 -= block_size){
+            int b1 = min(b0 + block_size, n);
+            if(tid == 0){
+                ge_solve_diagonal(pivot_rows, b0, b1, n, ncols);
+            }
+            pthread_barrier_wait(barrier);
+
+            int r0 = (int)((long)tid * b0 / num_threads);
+            int r1 = (int)((long)(tid + 1) * b0 / num_threads);
+            ge_solve_update(pivot_rows, r0, r1, b0, b1, n, ncols);
+            pthread_barrier_wait(barrier);
+        }
+    }
+
+    // Stop monitoring when last thread exits
+    perf_cycle(num_threads, local_args->counter, local_args->mtx,
+            local_args->cond, local_args->end);
+
+    // Free heap-allocated memory
+    delete[] rows;
+    delete[] ids;
+
+    return 0;
+}
+
+// Helper function to create the threads for an augmented system
+// [A | B] (n x (n + nrhs)), solved in place
+// Row perm[i] of the result holds x_i in columns [n, n + nrhs)
+// Returns the elapsed time of the parallel section in seconds
+double launch_solve(int num_threads, float *matrix, int n, int nrhs,
+        int *perm, int block_size = GE_BLOCK_SIZE){
+    // Create array of thread objects we will launch
+    pthread_t *threads = new pthread_t[num_threads];
+    Args *thread_args = new Args[num_threads];
+
+    // Create a barrier and initialize it
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, num_threads);
+
+    // Create the counters used by the lookahead pipeline
+    GeLookahead la;
+    ge_lookahead_init(&la, num_threads);
+
+    // Create space for the pivot rows in order
+    float **pivot_rows = new float*[n];
+
+    // Create variables for performance monitoring
+    int counter = num_threads;
+    pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    high_resolution_clock::time_point start;
+    high_resolution_clock::time_point end;
+
+    // Launch threads
+    for(int i = 0; i < num_threads; i++){
+        // Pack struct with its arguments
+        thread_args[i].tid = i;
+        thread_args[i].num_threads = num_threads;
+        thread_args[i].matrix = matrix;
+        thread_args[i].n = n;
+        thread_args[i].nrhs = nrhs;
+        thread_args[i].block_size = block_size;
+        thread_args[i].perm = perm;
+        thread_args[i].la = &la;
+        thread_args[i].pivot_rows = pivot_rows;
+        thread_args[i].barrier = &barrier;
+
+        thread_args[i].counter = &counter;
+        thread_args[i].mtx = &mtx;
+        thread_args[i].cond = &cond;
+        thread_args[i].start = &start;
+        thread_args[i].end = &end;
+
+        start_thread(&threads[i], ge_parallel_solve, (void*)&thread_args[i]);
+    }
+
+    for(int i = 0; i < num_threads; i++){
+        pthread_join(threads[i], NULL);
+    }
+
+    // Free heap-allocated memory
+    pthread_barrier_destroy(&barrier);
+    ge_lookahead_destroy(&la);
+    delete[] pivot_rows;
+    delete[] threads;
+    delete[] thread_args;
+
+    // Cast timers as double to return
+    duration<double> elapsed = duration_cast<duration<double>>(end - start);
+    return elapsed.count();
+}
+
+// Solves AX = B in parallel with a separate right-hand side block
+// A and B are left unchanged
+// Takes the number of threads, A (n x n), B (n x nrhs), X (n x nrhs),
+// and the dimensions as arguments
+// Returns the elapsed time of the parallel section in seconds
+double solve_system(int num_threads, const float *A, const float *B,
+        float *X, int n, int nrhs, int block_size = GE_BLOCK_SIZE){
+    float *matrix = new float[(size_t)n * (n + nrhs)];
+    int *perm = new int[n];
+    ge_augment(matrix, A, B, n, nrhs);
+    double elapsed = launch_solve(num_threads, matrix, n, nrhs, perm,
+            block_size);
+    ge_extract_solution(X, matrix, perm, n, nrhs);
+    delete[] matrix;
+    delete[] perm;
+    return elapsed;
+}
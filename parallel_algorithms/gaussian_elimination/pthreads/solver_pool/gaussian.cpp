@@ -0,0 +1,140 @@
+// This program implements parallel gaussian elimination in C++ using
+// a persistent pool of Pthreads (assumes square matrix), so many
+// matrices can be solved without creating threads for each one
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include "utils.h"
+
+int main(int argc, char *argv[]){
+    // Problem size, threads in the pool, solves, and how to check the
+    // result (-n, -t, -w, -r, -s, -v on the command line). Every run is
+    // one matrix submitted to the same pool
+    BenchConfig config = ge_bench_defaults(256, 8);
+    config.reps = 100;
+    parse_bench_args(argc, argv, &config);
+
+    // Number of threads in the pool
+    int num_threads = config.num_threads;
+
+    // Dimensions of square matrix
+    int N = config.N;
+
+    // Check with an O(N^2) residual instead of the serial version (the
+    // pool then keeps L, and no serial copy is made)
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
+    // Declare our problem matrices
+    float *matrix;
+    float *matrix_serial;
+    float *matrix_pool;
+
+    // Declare the row picked as each pivot by each version
+    int *perm;
+    int *perm_pool;
+
+    // Declare and initialize the size of the matrix
+    size_t bytes = (size_t)N * N * sizeof(float);
+
+    // Allocate space for our matrices (the residual check makes the rows
+    // of the original matrix again, so it is not kept)
+    matrix = residual ? NULL : new float[(size_t)N * N];
+    matrix_serial = residual ? NULL : new float[(size_t)N * N];
+    matrix_pool = new float[(size_t)N * N];
+    perm = new int[N];
+    perm_pool = new int[N];
+
+    // Initialize a matrix
+    if(!residual){
+        init_matrix(matrix, N, N, config.seed, config.num_threads);
+    }
+
+    // Create the workers once, outside of the timed solves
+    SolverPool pool;
+    pool_init(&pool, num_threads);
+
+    // Submit each matrix and wait for it to be solved (warmup solves are
+    // not recorded)
+    vector<double> parallel_times;
+    double dispatch_total = 0;
+    double dispatch_max = 0;
+    double solve_total = 0;
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        if(residual){
+            init_matrix(matrix_pool, N, N, config.seed, num_threads);
+        }else{
+            memcpy(matrix_pool, matrix, bytes);
+        }
+
+        SolveJob job;
+        pool_submit(&pool, &job, matrix_pool, N, perm_pool, residual);
+        pool_wait(&pool, &job);
+        if(r < config.warmup){
+            continue;
+        }
+
+        // Time from submission until a worker started on it, the time
+        // spent solving, and both together
+        duration<double> dispatch = duration_cast<duration<double>>(
+                job.started - job.submitted);
+        duration<double> solve = duration_cast<duration<double>>(
+                job.completed - job.started);
+        duration<double> total = duration_cast<duration<double>>(
+                job.completed - job.submitted);
+        dispatch_total += dispatch.count();
+        dispatch_max = max(dispatch_max, dispatch.count());
+        solve_total += solve.count();
+        parallel_times.push_back(total.count());
+    }
+
+    pool_destroy(&pool);
+
+    // Create timers for our serial version
+    high_resolution_clock::time_point start;
+    high_resolution_clock::time_point end;
+
+    // Call the serial version for our reference solution
+    vector<double> serial_times;
+    for(int r = 0; !residual && (r < config.warmup + config.reps); r++){
+        memcpy(matrix_serial, matrix, bytes);
+        start = high_resolution_clock::now();
+        ge_serial(matrix_serial, N, perm);
+        end = high_resolution_clock::now();
+        duration<double> elapsed = duration_cast<duration<double>>(end - start);
+        if(r >= config.warmup){
+            serial_times.push_back(elapsed.count());
+        }
+    }
+
+    // Print out the average dispatch and solve times, and the median
+    // elapsed times
+    int num_solves = (int)parallel_times.size();
+    cout << "Average dispatch latency = " << dispatch_total / num_solves
+        << " seconds (max " << dispatch_max << ")" << endl;
+    cout << "Average solve time = " << solve_total / num_solves
+        << " seconds" << endl;
+    cout << "Elapsed time parallel = " << bench_stats(parallel_times).median
+        << " seconds" << endl;
+    print_bench_line("parallel", N, num_threads, parallel_times);
+
+    // Verify the solution of the last matrix
+    if(residual){
+        cout << "Relative residual = " << ge_verify_lu(NULL, matrix_pool,
+                perm_pool, N, num_threads, 0, config.seed) << endl;
+    }else{
+        cout << "Elapsed time serial = " << bench_stats(serial_times).median
+            << " seconds" << endl;
+        print_bench_line("serial", N, 1, serial_times);
+        verify_solution(matrix_serial, matrix_pool, N);
+        verify_permutation(perm, perm_pool, N);
+    }
+
+    // Free heap-allocated memory
+    delete[] matrix;
+    delete[] matrix_serial;
+    delete[] matrix_pool;
+    delete[] perm;
+    delete[] perm_pool;
+
+    return 0;
+}
@@ -0,0 +1,231 @@
+// This file contains a persistent pool of solver threads for the
+// pthread parallel Gaussian Elimination
+// By: Nick from CoffeeBeforeArch
+
+#include <pthread.h>
+#include <chrono>
+#include <queue>
+#include "../../common/common.h"
+#include "../../common/bench.h"
+#include "../../common/verify.h"
+#include "../../common/lookahead.h"
+
+using namespace std::chrono;
+
+// One matrix submitted to the pool
+// The caller owns it and waits on it for completion
+struct SolveJob {
+    // Matrix of floating point numbers, and its dimension
+    float *matrix;
+    int N;
+    // Row of the matrix picked as each pivot
+    int *perm;
+    // Leave the packed LU in place
+    bool keep_lu;
+    // Workers that have not finished this matrix yet
+    int remaining;
+    // Set once every worker is done
+    bool finished;
+    // Timing: submission, first worker starting, last worker finishing
+    high_resolution_clock::time_point submitted;
+    high_resolution_clock::time_point started;
+    high_resolution_clock::time_point completed;
+    // Set by the first worker to pick the job up
+    std::atomic<bool> claimed;
+};
+
+struct SolverPool;
+
+// Arguments for each worker thread
+struct WorkerArgs {
+    SolverPool *pool;
+    int tid;
+};
+
+struct SolverPool {
+    // Worker threads, parked between solves
+    int num_threads;
+    pthread_t *threads;
+    WorkerArgs *worker_args;
+    // Number of pivots per blocked panel
+    int block_size;
+    // Counters the workers synchronize on while solving the current job
+    // (allocated once, rewound for each job)
+    GeLookahead la;
+    // Protects everything below
+    pthread_mutex_t mtx;
+    // Signaled when a new job becomes current (or on shutdown)
+    pthread_cond_t work_cond;
+    // Signaled when a job finishes
+    pthread_cond_t done_cond;
+    // Job being solved, and the ones waiting behind it
+    SolveJob *current;
+    std::queue<SolveJob*> jobs;
+    // Bumped every time a new job becomes current
+    unsigned long generation;
+    bool shutdown;
+};
+
+// Makes the next queued job current and wakes the workers
+// Must be called with the pool lock held
+void pool_next_job(SolverPool *pool){
+    if(pool->jobs.empty()){
+        pool->current = NULL;
+        return;
+    }
+    pool->current = pool->jobs.front();
+    pool->jobs.pop();
+    ge_lookahead_reset(&pool->la, pool->current->keep_lu);
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cond);
+}
+
+// Worker loop: sleep until a job arrives, solve it with the others
+// Takes a pointer to the worker arguments as an argument
+void *pool_worker(void *args){
+    WorkerArgs *local_args = (WorkerArgs*)args;
+    SolverPool *pool = local_args->pool;
+    int tid = local_args->tid;
+    int num_threads = pool->num_threads;
+
+    // Row lists are kept between jobs and only grow
+    int capacity = 0;
+    float **rows = NULL;
+    int *ids = NULL;
+
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool->mtx);
+    while(true){
+        // Park until there is a job we have not worked on yet
+        while(!pool->shutdown && (pool->generation == seen)){
+            pthread_cond_wait(&pool->work_cond, &pool->mtx);
+        }
+        if(pool->shutdown){
+            break;
+        }
+        seen = pool->generation;
+        SolveJob *job = pool->current;
+        pthread_mutex_unlock(&pool->mtx);
+
+        // The first worker to wake up marks the end of the dispatch
+        if(!job->claimed.exchange(true)){
+            job->started = high_resolution_clock::now();
+        }
+
+        // Cyclic striped mapping of the rows to the workers
+        int N = job->N;
+        int num_rows = (N - tid + num_threads - 1) / num_threads;
+        if(num_rows > capacity){
+            delete[] rows;
+            delete[] ids;
+            capacity = num_rows;
+            rows = new float*[capacity];
+            ids = new int[capacity];
+        }
+        for(int j = 0; j < num_rows; j++){
+            rows[j] = &job->matrix[(size_t)(j * num_threads + tid) * N];
+            ids[j] = j * num_threads + tid;
+        }
+
+        // Solve without any barriers
+        ge_lookahead(&pool->la, job->matrix, N, N, pool->block_size,
+                job->perm, tid, rows, ids, num_rows);
+
+        // The last worker to finish completes the job
+        pthread_mutex_lock(&pool->mtx);
+        job->remaining--;
+        if(job->remaining == 0){
+            job->completed = high_resolution_clock::now();
+            job->finished = true;
+            pthread_cond_broadcast(&pool->done_cond);
+            pool_next_job(pool);
+        }
+    }
+    pthread_mutex_unlock(&pool->mtx);
+
+    delete[] rows;
+    delete[] ids;
+    return 0;
+}
+
+// Creates the workers once
+// Takes the pool, the number of threads, and the number of pivots per
+// panel as arguments
+void pool_init(SolverPool *pool, int num_threads,
+        int block_size = GE_BLOCK_SIZE){
+    pool->num_threads = num_threads;
+    pool->block_size = block_size;
+    ge_lookahead_init(&pool->la, num_threads);
+    pthread_mutex_init(&pool->mtx, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+    pool->current = NULL;
+    pool->generation = 0;
+    pool->shutdown = false;
+
+    // Launch threads
+    pool->threads = new pthread_t[num_threads];
+    pool->worker_args = new WorkerArgs[num_threads];
+    for(int i = 0; i < num_threads; i++){
+        pool->worker_args[i].pool = pool;
+        pool->worker_args[i].tid = i;
+        start_thread(&pool->threads[i], pool_worker,
+                (void*)&pool->worker_args[i]);
+    }
+}
+
+// Submits a matrix to be solved in place
+// Returns right away, no threads are created
+// Takes the pool, a job to track the solve, the matrix, its dimension,
+// the permutation vector, and whether to leave the packed LU in place as
+// arguments
+void pool_submit(SolverPool *pool, SolveJob *job, float *matrix, int N,
+        int *perm, bool keep_lu = false){
+    // Pack the job
+    job->matrix = matrix;
+    job->N = N;
+    job->perm = perm;
+    job->keep_lu = keep_lu;
+    job->remaining = pool->num_threads;
+    job->finished = false;
+    job->claimed.store(false);
+    job->submitted = high_resolution_clock::now();
+
+    // Queue it, and wake the workers if the pool is idle
+    pthread_mutex_lock(&pool->mtx);
+    pool->jobs.push(job);
+    if(pool->current == NULL){
+        pool_next_job(pool);
+    }
+    pthread_mutex_unlock(&pool->mtx);
+}
+
+// Waits for a submitted matrix to be solved
+// Takes the pool and the job as arguments
+void pool_wait(SolverPool *pool, SolveJob *job){
+    pthread_mutex_lock(&pool->mtx);
+    while(!job->finished){
+        pthread_cond_wait(&pool->done_cond, &pool->mtx);
+    }
+    pthread_mutex_unlock(&pool->mtx);
+}
+
+// Wakes the workers up one last time and joins them
+// Takes the pool as an argument
+void pool_destroy(SolverPool *pool){
+    pthread_mutex_lock(&pool->mtx);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mtx);
+
+    for(int i = 0; i < pool->num_threads; i++){
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->mtx);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->done_cond);
+    ge_lookahead_destroy(&pool->la);
+    delete[] pool->threads;
+    delete[] pool->worker_args;
+}
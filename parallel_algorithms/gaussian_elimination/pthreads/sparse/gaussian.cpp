@@ -0,0 +1,174 @@
+// This program implements sparse LU factorization in C++ using Pthreads
+// (assumes square matrix): a fill-reducing ordering and symbolic
+// analysis done once, then numeric factorizations over the elimination
+// tree, and one solve
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include "utils.h"
+#include "../../common/solve.h"
+
+// Largest matrix also solved densely to check the sparse solution
+const int GE_SPARSE_DENSE_MAX = 2048;
+
+int main(int argc, char *argv[]){
+    // Problem size, threads, runs, and how to check the result (-n, -t,
+    // -w, -r, -v on the command line), a Matrix Market file to read
+    // instead of the random matrix (-f), and the ordering (-o amd or
+    // natural)
+    BenchConfig config = ge_bench_defaults(65536, 8);
+    const char *path = NULL;
+    GeOrdering ordering = GE_ORDER_AMD;
+    int bench_argc = 1;
+    char **bench_argv = new char*[argc];
+    bench_argv[0] = argv[0];
+    for(int i = 1; i < argc; i++){
+        if((i + 1 < argc) && (strcmp(argv[i], "-f") == 0)){
+            path = argv[++i];
+        }else if((i + 1 < argc) && (strcmp(argv[i], "-o") == 0)){
+            ordering = (strcmp(argv[++i], "natural") == 0) ?
+                GE_ORDER_NATURAL : GE_ORDER_AMD;
+        }else{
+            bench_argv[bench_argc++] = argv[i];
+        }
+    }
+    parse_bench_args(bench_argc, bench_argv, &config);
+    delete[] bench_argv;
+
+    // Number of threads to launch
+    int num_threads = config.num_threads;
+
+    // Check with the residual of a solve instead of the serial version
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
+    // Read or make the matrix (CSR)
+    GeCsr matrix;
+    if(path != NULL){
+        if(!ge_sparse_read(path, &matrix)){
+            cerr << "Could not read " << path << endl;
+            return 1;
+        }
+    }else{
+        ge_random_sparse(&matrix, config.N, config.seed);
+    }
+    int N = matrix.n;
+
+    // Create timers for the analysis and our serial version
+    high_resolution_clock::time_point start;
+    high_resolution_clock::time_point end;
+
+    // Order and analyze the pattern once
+    GeSparseSymbolic symbolic;
+    start = high_resolution_clock::now();
+    int matched = ge_sparse_analyze(&matrix, ordering, &symbolic);
+    end = high_resolution_clock::now();
+    duration<double> analysis = duration_cast<duration<double>>(end - start);
+
+    // Factor with the threads via a helper function (warmup runs are not
+    // recorded)
+    GeSparseNumeric numeric_pthread;
+    vector<double> parallel_times;
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        double elapsed = launch_threads(num_threads, &symbolic, &matrix,
+                &numeric_pthread);
+        if(r >= config.warmup){
+            parallel_times.push_back(elapsed);
+        }
+    }
+
+    // Call the serial version for our reference solution
+    GeSparseNumeric numeric_serial;
+    vector<double> serial_times;
+    for(int r = 0; !residual && (r < config.warmup + config.reps); r++){
+        start = high_resolution_clock::now();
+        ge_sparse_factor(&symbolic, &matrix, &numeric_serial);
+        end = high_resolution_clock::now();
+        duration<double> elapsed = duration_cast<duration<double>>(end - start);
+        if(r >= config.warmup){
+            serial_times.push_back(elapsed.count());
+        }
+    }
+
+    // Print the fill and the median elapsed times
+    cout << "Nonzeros in A = " << matrix.nnz << ", in L + U = "
+        << ge_sparse_factor_nnz(&symbolic) << endl;
+    cout << "Elapsed time analysis = " << analysis.count() << " seconds"
+        << endl;
+    if(matched < N){
+        cout << "Structurally singular: " << N - matched
+            << " columns could not be matched" << endl;
+    }
+    cout << "Elapsed time parallel = " << bench_stats(parallel_times).median
+        << " seconds" << endl;
+    print_bench_line("parallel", N, num_threads, parallel_times);
+    print_flops_line("parallel", ge_sparse_flops(&symbolic));
+    cout << "Replaced pivots = " << ge_sparse_perturbed(&numeric_pthread)
+        << endl;
+
+    // Solve with the threaded factorization
+    float *b = new float[N];
+    float *x = new float[N];
+    ge_random_row(b, 0, N, config.seed + 1);
+    if(!ge_sparse_solve(&symbolic, &numeric_pthread, &matrix, b, x)){
+        cerr << "Iterative refinement did not converge (relative residual "
+            << ge_sparse_residual(&matrix, x, b) << ")" << endl;
+        return 1;
+    }
+
+    // Verify the solution
+    if(residual){
+        cout << "Relative residual = " << ge_sparse_residual(&matrix, x, b)
+            << endl;
+
+        // Another matrix with the same pattern reuses the analysis
+        if(path == NULL){
+            GeCsr other;
+            ge_random_sparse(&other, N, config.seed + 2);
+            launch_threads(num_threads, &symbolic, &other, &numeric_pthread);
+            if(!ge_sparse_solve(&symbolic, &numeric_pthread, &other, b,
+                        x)){
+                cerr << "Iterative refinement did not converge on the new "
+                    << "values" << endl;
+                return 1;
+            }
+            cout << "Relative residual (same pattern, new values) = "
+                << ge_sparse_residual(&other, x, b) << endl;
+            ge_csr_destroy(&other);
+        }
+    }else{
+        cout << "Elapsed time serial = " << bench_stats(serial_times).median
+            << " seconds" << endl;
+        print_bench_line("serial", N, 1, serial_times);
+        verify_solution(numeric_serial.diag.data(),
+                numeric_pthread.diag.data(), 1, N);
+        verify_solution(numeric_serial.lx.data(), numeric_pthread.lx.data(),
+                1, (int)numeric_serial.lx.size());
+        verify_solution(numeric_serial.ux.data(), numeric_pthread.ux.data(),
+                1, (int)numeric_serial.ux.size());
+
+        // Small systems are also solved densely, doing O(N^3) work
+        if(N <= GE_SPARSE_DENSE_MAX){
+            float *dense = new float[(size_t)N * N];
+            float *x_dense = new float[N];
+            ge_sparse_to_dense(&matrix, dense);
+            start = high_resolution_clock::now();
+            ge_serial_solve(dense, b, x_dense, N, 1);
+            end = high_resolution_clock::now();
+            duration<double> elapsed =
+                duration_cast<duration<double>>(end - start);
+            cout << "Elapsed time dense serial = " << elapsed.count()
+                << " seconds" << endl;
+            verify_solution(x_dense, x, N, 1);
+            delete[] dense;
+            delete[] x_dense;
+        }
+    }
+
+    // Free heap-allocated memory
+    ge_csr_destroy(&matrix);
+    ge_sparse_symbolic_destroy(&symbolic);
+    delete[] b;
+    delete[] x;
+
+    return 0;
+}
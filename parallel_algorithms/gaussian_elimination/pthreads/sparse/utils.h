@@ -0,0 +1,186 @@
+// This file contains utility functions for the pthread sparse LU
+// factorization. Each node of the elimination tree is a task that is
+// ready once all of its children are done, and the tasks are scheduled
+// with work stealing
+// By: Nick from CoffeeBeforeArch
+
+#include <pthread.h>
+#include <chrono>
+#include <atomic>
+#include <deque>
+#include <sched.h>
+#include "../../common/common.h"
+#include "../../common/bench.h"
+#include "../../common/sparse_lu.h"
+
+using namespace std::chrono;
+
+// Nodes owned by one worker
+// The owner pushes and pops at the back (newest first), thieves take
+// from the front (oldest first)
+struct alignas(64) WorkerDeque {
+    pthread_mutex_t mtx;
+    std::deque<int> nodes;
+};
+
+// State shared by all workers
+struct TreeSchedule {
+    // Analysis, matrix, and the factorization being filled in
+    const GeSparseSymbolic *s;
+    const GeCsr *a;
+    GeSparseNumeric *f;
+    // Children of each node that are not done yet
+    std::atomic<int> *pending;
+    // Number of nodes finished
+    std::atomic<int> finished;
+    // One deque per worker
+    int num_threads;
+    WorkerDeque *deques;
+};
+
+struct Args {
+    // Thread ID
+    int tid;
+    // Schedule shared by every worker
+    TreeSchedule *sched;
+};
+
+// Pushes a ready node onto the back of a worker's deque
+void push_node(WorkerDeque *dq, int k){
+    pthread_mutex_lock(&dq->mtx);
+    dq->nodes.push_back(k);
+    pthread_mutex_unlock(&dq->mtx);
+}
+
+// Takes the newest node of our own deque
+// Returns false if it was empty
+bool pop_node(WorkerDeque *dq, int *k){
+    pthread_mutex_lock(&dq->mtx);
+    bool found = !dq->nodes.empty();
+    if(found){
+        *k = dq->nodes.back();
+        dq->nodes.pop_back();
+    }
+    pthread_mutex_unlock(&dq->mtx);
+    return found;
+}
+
+// Takes the oldest node of another worker's deque
+// Returns false if every other deque was empty
+bool steal_node(TreeSchedule *t, int tid, int *k){
+    for(int i = 1; i < t->num_threads; i++){
+        WorkerDeque *dq = &t->deques[(tid + i) % t->num_threads];
+        pthread_mutex_lock(&dq->mtx);
+        bool found = !dq->nodes.empty();
+        if(found){
+            *k = dq->nodes.front();
+            dq->nodes.pop_front();
+        }
+        pthread_mutex_unlock(&dq->mtx);
+        if(found){
+            return true;
+        }
+    }
+    return false;
+}
+
+// Worker function: factor ready nodes, and queue a parent once its last
+// child is done (the parent stays on this worker, near its children)
+// Takes a pointer to a struct of args as an argument
+void *ge_worker(void *args){
+    // Cast void pointer to struct pointer
+    Args *local_args = (Args*)args;
+    int tid = local_args->tid;
+    TreeSchedule *t = local_args->sched;
+    int n = t->s->n;
+
+    // Scatter vectors of this worker
+    float *x = new float[n]();
+    float *y = new float[n]();
+
+    int k;
+    while(t->finished.load() < n){
+        if(pop_node(&t->deques[tid], &k) || steal_node(t, tid, &k)){
+            ge_sparse_node(t->s, t->a, t->f, k, x, y);
+            int parent = t->s->parent[k];
+            if((parent != -1) && (t->pending[parent].fetch_sub(1) == 1)){
+                push_node(&t->deques[tid], parent);
+            }
+            t->finished.fetch_add(1);
+        }else{
+            sched_yield();
+        }
+    }
+
+    // Free heap-allocated memory
+    delete[] x;
+    delete[] y;
+
+    return 0;
+}
+
+// Helper function to factor a matrix over its elimination tree with
+// threads
+// Returns the elapsed time in seconds
+double launch_threads(int num_threads, const GeSparseSymbolic *s,
+        const GeCsr *a, GeSparseNumeric *f){
+    int n = s->n;
+    ge_sparse_numeric_init(s, a, f);
+
+    // Every node waits for its children. The leaves are dealt out in
+    // contiguous runs, so each worker starts on nearby subtrees
+    TreeSchedule t;
+    t.s = s;
+    t.a = a;
+    t.f = f;
+    t.pending = new std::atomic<int>[n];
+    t.finished.store(0);
+    t.num_threads = num_threads;
+    t.deques = ge_aligned_new<WorkerDeque>(num_threads);
+    for(int i = 0; i < num_threads; i++){
+        pthread_mutex_init(&t.deques[i].mtx, NULL);
+    }
+    int num_leaves = 0;
+    for(int k = 0; k < n; k++){
+        t.pending[k].store(s->num_children[k]);
+        num_leaves += (s->num_children[k] == 0);
+    }
+    for(int k = 0, leaf = 0; k < n; k++){
+        if(s->num_children[k] == 0){
+            int owner = (int)((long)leaf++ * num_threads / num_leaves);
+            t.deques[owner].nodes.push_front(k);
+        }
+    }
+
+    // Create array of thread objects we will launch
+    pthread_t *threads = new pthread_t[num_threads];
+    Args *thread_args = new Args[num_threads];
+
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+
+    // Launch threads
+    for(int i = 0; i < num_threads; i++){
+        thread_args[i].tid = i;
+        thread_args[i].sched = &t;
+        start_thread(&threads[i], ge_worker, (void*)&thread_args[i]);
+    }
+
+    for(int i = 0; i < num_threads; i++){
+        pthread_join(threads[i], NULL);
+    }
+
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+
+    // Free heap-allocated memory
+    for(int i = 0; i < num_threads; i++){
+        pthread_mutex_destroy(&t.deques[i].mtx);
+    }
+    delete[] t.pending;
+    ge_aligned_delete(t.deques, num_threads);
+    delete[] threads;
+    delete[] thread_args;
+
+    // Cast timers as double to return
+    duration<double> elapsed = duration_cast<duration<double>>(end - start);
+    return elapsed.count();
+}
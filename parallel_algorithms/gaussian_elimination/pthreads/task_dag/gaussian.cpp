@@ -0,0 +1,116 @@
+// This program implements parallel gaussian elimination in C++ using
+// Pthreads (assumes square matrix) and splits the work
+// as tasks (panel factorizations and tile updates) scheduled with
+// work stealing
+// By: Nick from CoffeeBeforeArch
+
+#include <stdlib.h>
+#include "utils.h"
+
+int main(int argc, char *argv[]){
+    // Problem size, threads, and runs (-n, -t, -w, -r on the command
+    // line), and whether to check with the serial version or with an
+    // O(N^2) residual (-v serial or residual)
+    BenchConfig config = ge_bench_defaults(2048, 8);
+    parse_bench_args(argc, argv, &config);
+    bool residual = (config.verify == GE_VERIFY_RESIDUAL);
+
+    // Number of threads to launch
+    int num_threads = config.num_threads;
+
+    // Dimensions of square matrix
+    int N = config.N;
+
+    // Number of pivots per blocked panel
+    int block_size = GE_BLOCK_SIZE;
+
+    // Declare our problem matrices
+    float *matrix;
+    float *matrix_serial;
+    float *matrix_pthread;
+
+    // Declare the row picked as each pivot by each version
+    int *perm;
+    int *perm_pthread;
+
+    // Declare and initialize the size of the matrix
+    size_t bytes = (size_t)N * N * sizeof(float);
+
+    // Allocate space for our matrices (the residual check makes the rows
+    // of the original matrix again, so it is not kept)
+    matrix = residual ? NULL : new float[(size_t)N * N];
+    matrix_serial = residual ? NULL : new float[(size_t)N * N];
+    matrix_pthread = new float[(size_t)N * N];
+    perm = new int[N];
+    perm_pthread = new int[N];
+   
+    // Initialize a matrix
+    if(!residual){
+        init_matrix(matrix, N, N, config.seed, config.num_threads);
+    }
+    
+    // Print the row kernels picked for this CPU
+    cout << "Elimination kernel = " << ge_kernels.name << endl;
+
+    // Launch the task graph via a helper function on a fresh copy of
+    // the matrix (warmup runs are not recorded, and the packed LU is
+    // kept for the residual check)
+    vector<double> parallel_times;
+    for(int r = 0; r < config.warmup + config.reps; r++){
+        if(residual){
+            init_matrix(matrix_pthread, N, N, config.seed, num_threads);
+        }else{
+            memcpy(matrix_pthread, matrix, bytes);
+        }
+        double elapsed = launch_tasks(num_threads, matrix_pthread, N,
+                perm_pthread, block_size, GE_TILE_COLS, residual);
+        if(r >= config.warmup){
+            parallel_times.push_back(elapsed);
+        }
+    }
+
+    // Create timers for our serial version
+    high_resolution_clock::time_point start;
+    high_resolution_clock::time_point end;
+
+    // Call the serial version for our reference solution (not needed
+    // for the residual check)
+    vector<double> serial_times;
+    for(int r = 0; !residual && (r < config.warmup + config.reps); r++){
+        memcpy(matrix_serial, matrix, bytes);
+        start = high_resolution_clock::now();
+        ge_serial(matrix_serial, N, perm, block_size);
+        end = high_resolution_clock::now();
+        duration<double> elapsed = duration_cast<duration<double>>(end - start);
+        if(r >= config.warmup){
+            serial_times.push_back(elapsed.count());
+        }
+    }
+
+    // Print out the median elapsed times
+    cout << "Elapsed time parallel = " << bench_stats(parallel_times).median
+        << " seconds" << endl;
+    print_bench_line("parallel", N, num_threads, parallel_times);
+
+    // Verify the solution
+    if(residual){
+        cout << "Relative residual = " << ge_verify_lu(NULL,
+                matrix_pthread, perm_pthread, N, num_threads, 0,
+                config.seed) << endl;
+    }else{
+        cout << "Elapsed time serial = " << bench_stats(serial_times).median
+            << " seconds" << endl;
+        print_bench_line("serial", N, 1, serial_times);
+        verify_solution(matrix_serial, matrix_pthread, N);
+        verify_permutation(perm, perm_pthread, N);
+    }
+
+    // Free our heap-allocated memory
+    delete[] matrix;
+    delete[] matrix_serial;
+    delete[] matrix_pthread;
+    delete[] perm;
+    delete[] perm_pthread;
+
+    return 0;
+}
@@ -0,0 +1,350 @@
+// This file contains utility functions for the pthread task-based
+// Gaussian Elimination, where each panel factorization and each tile
+// update is a task scheduled with work stealing
+// By: Nick from CoffeeBeforeArch
+
+#include <pthread.h>
+#include <chrono>
+#include <atomic>
+#include <deque>
+#include <sched.h>
+#include "../../common/common.h"
+#include "../../common/bench.h"
+#include "../../common/verify.h"
+#include "../../common/perf_cycle.h"
+
+using namespace std::chrono;
+
+// Kinds of tasks in the graph
+enum TaskType {
+    // Factor the columns of panel k over all remaining rows
+    PANEL,
+    // Apply panel k to the columns of tile c right of the panel
+    UPDATE
+};
+
+struct Task {
+    TaskType type;
+    int k;
+    int c;
+};
+
+// Tasks owned by one worker
+// The owner pushes and pops at the back (newest first), thieves take
+// from the front (oldest first)
+struct alignas(64) WorkerDeque {
+    pthread_mutex_t mtx;
+    std::deque<Task> tasks;
+};
+
+// State shared by all workers
+struct TaskGraph {
+    // Matrix of floating point numbers, and its dimension
+    float *matrix;
+    int N;
+    // Width of a panel, and of a column tile (a multiple of the panel)
+    int block_size;
+    int tile_cols;
+    // Number of panels, and of column tiles
+    int num_blocks;
+    int num_tiles;
+    // Row of the matrix picked as each pivot, and the pivot values
+    int *perm;
+    float *pivots;
+    // Row list of each panel: rows[k][0, k1) are pivots in order, and
+    // rows[k][k1, N) remain after panel k (ids are the matrix rows)
+    float ***rows;
+    int **ids;
+    // Outstanding dependencies of each task
+    std::atomic<int> *panel_deps;
+    std::atomic<int> *update_deps;
+    // Number of tasks finished, and in total
+    std::atomic<int> finished;
+    int total;
+    // One deque per worker
+    int num_threads;
+    WorkerDeque *deques;
+    // Clear the multipliers and pivots once the graph is done (unless
+    // the packed LU is kept)
+    bool clear_lu;
+    // Variables needed for timing
+    int counter;
+    pthread_mutex_t mtx;
+    pthread_cond_t cond;
+    high_resolution_clock::time_point start;
+    high_resolution_clock::time_point end;
+};
+
+struct Args {
+    // Thread ID
+    int tid;
+    // Graph shared by every worker
+    TaskGraph *graph;
+};
+
+// Pushes a ready task onto the back of a worker's deque
+void push_task(WorkerDeque *dq, Task t){
+    pthread_mutex_lock(&dq->mtx);
+    dq->tasks.push_back(t);
+    pthread_mutex_unlock(&dq->mtx);
+}
+
+// Takes the newest task of our own deque
+// Returns false if it was empty
+bool pop_task(WorkerDeque *dq, Task *t){
+    pthread_mutex_lock(&dq->mtx);
+    bool found = !dq->tasks.empty();
+    if(found){
+        *t = dq->tasks.back();
+        dq->tasks.pop_back();
+    }
+    pthread_mutex_unlock(&dq->mtx);
+    return found;
+}
+
+// Takes the oldest task of another worker's deque
+// Returns false if every other deque was empty
+bool steal_task(TaskGraph *g, int tid, Task *t){
+    for(int i = 1; i < g->num_threads; i++){
+        WorkerDeque *dq = &g->deques[(tid + i) % g->num_threads];
+        pthread_mutex_lock(&dq->mtx);
+        bool found = !dq->tasks.empty();
+        if(found){
+            *t = dq->tasks.front();
+            dq->tasks.pop_front();
+        }
+        pthread_mutex_unlock(&dq->mtx);
+        if(found){
+            return true;
+        }
+    }
+    return false;
+}
+
+// Factors panel k with partial pivoting
+// Only the panel columns of the remaining rows are updated, and the
+// pivot rows are only normalized in the panel columns
+void run_panel(TaskGraph *g, int k){
+    int N = g->N;
+    int k0 = k * g->block_size;
+    int k1 = min(k0 + g->block_size, N);
+
+    // Start from the rows left by the previous panel
+    float **rows = g->rows[k];
+    int *ids = g->ids[k];
+    if(k > 0){
+        memcpy(rows, g->rows[k - 1], N * sizeof(float*));
+        memcpy(ids, g->ids[k - 1], N * sizeof(int));
+    }
+
+    for(int i = k0; i < k1; i++){
+        // Pick the pivot and move its pointer to the front
+        int pos;
+        ge_find_pivot(&rows[i], &ids[i], N - i, i, &pos);
+        ge_swap_rows(rows, ids, i, i + pos);
+        g->perm[i] = ids[i];
+
+        // Normalize the panel columns, and keep the pivot for the tiles
+        float *row = rows[i];
+        g->pivots[i] = row[i];
+        ge_scale(&row[i + 1], 1.0f / row[i], k1 - i - 1);
+
+        // Eliminate the pivot from the panel columns of later rows
+        ge_panel_update(&rows[i + 1], N - i - 1, row, i, k1);
+    }
+}
+
+// Applies panel k to the column tile c (only the columns right of it)
+// The pivot rows are brought up to date and normalized in this tile,
+// then every remaining row is updated
+void run_update(TaskGraph *g, int k, int c){
+    int N = g->N;
+    int k0 = k * g->block_size;
+    int k1 = min(k0 + g->block_size, N);
+    int c0 = max(c * g->tile_cols, k1);
+    int c1 = min((c + 1) * g->tile_cols, N);
+    float **rows = g->rows[k];
+
+    // Pivot rows of the panel
+    const float **u_rows = (const float**)&rows[k0];
+
+    for(int i = k0; i < k1; i++){
+        ge_trailing_update(&rows[i], 1, u_rows, k0, i, c0, c1);
+        ge_scale(&rows[i][c0], 1.0f / g->pivots[i], c1 - c0);
+    }
+    ge_trailing_update(&rows[k1], N - k1, u_rows, k0, k1, c0, c1);
+}
+
+// Releases one dependency of a task, and queues it once it is ready
+void release(TaskGraph *g, int tid, Task t){
+    std::atomic<int> *deps = (t.type == PANEL) ? &g->panel_deps[t.k] :
+        &g->update_deps[t.k * g->num_tiles + t.c];
+    if(deps->fetch_sub(1) == 1){
+        push_task(&g->deques[tid], t);
+    }
+}
+
+// Runs a task and releases the tasks that depend on it
+void run_task(TaskGraph *g, int tid, Task t){
+    int N = g->N;
+    int k1 = min((t.k + 1) * g->block_size, N);
+    int k2 = min(k1 + g->block_size, N);
+    if(t.type == PANEL){
+        run_panel(g, t.k);
+
+        // Trailing updates first, so the update that unblocks the next
+        // panel is on top of our deque and runs next
+        for(int c = g->num_tiles - 1; (k1 < N) && (c >= k1 / g->tile_cols);
+                c--){
+            release(g, tid, {UPDATE, t.k, c});
+        }
+    }else{
+        run_update(g, t.k, t.c);
+
+        // The next panel only waits for the tile holding its columns
+        if(t.c == k1 / g->tile_cols){
+            release(g, tid, {PANEL, t.k + 1, 0});
+        }
+
+        // The same tile of the next panel, if it has columns right of it
+        if((k2 < N) && ((t.c + 1) * g->tile_cols > k2)){
+            release(g, tid, {UPDATE, t.k + 1, t.c});
+        }
+    }
+    g->finished.fetch_add(1);
+}
+
+// Worker function: run our own tasks, steal when we run out
+// Takes a pointer to a struct of args as an argument
+void *ge_worker(void *args){
+    // Cast void pointer to struct pointer
+    Args *local_args = (Args*)args;
+    int tid = local_args->tid;
+    TaskGraph *g = local_args->graph;
+
+    // Wait for all threads to be created before profiling
+    perf_cycle(g->num_threads, &g->counter, &g->mtx, &g->cond, &g->start);
+
+    Task t;
+    while(g->finished.load() < g->total){
+        if(pop_task(&g->deques[tid], &t) || steal_task(g, tid, &t)){
+            run_task(g, tid, t);
+        }else{
+            sched_yield();
+        }
+    }
+
+    // The multipliers were kept for the tile updates (and the pivots on
+    // the diagonal), each thread clears a stripe of them now
+    for(int i = tid; g->clear_lu && (i < g->N); i += g->num_threads){
+        float *row = &g->matrix[(size_t)g->perm[i] * g->N];
+        memset(row, 0, i * sizeof(float));
+        row[i] = 1;
+    }
+
+    // Stop monitoring when last thread exits
+    perf_cycle(g->num_threads, &g->counter, &g->mtx, &g->cond, &g->end);
+
+    return 0;
+}
+
+// Helper function to build the task graph and run it
+// With keep_lu the matrix is left holding the packed LU factorization
+// (as in ge_blocked)
+// Returns the elapsed time of the parallel section in seconds
+double launch_tasks(int num_threads, float* matrix, int N, int *perm,
+        int block_size = GE_BLOCK_SIZE, int tile_cols = GE_TILE_COLS,
+        bool keep_lu = false){
+    // A panel must never straddle two tiles
+    tile_cols = ((tile_cols + block_size - 1) / block_size) * block_size;
+    int nb = (N + block_size - 1) / block_size;
+    int nt = (N + tile_cols - 1) / tile_cols;
+
+    // Build the graph
+    TaskGraph g;
+    g.matrix = matrix;
+    g.N = N;
+    g.block_size = block_size;
+    g.tile_cols = tile_cols;
+    g.num_blocks = nb;
+    g.num_tiles = nt;
+    g.perm = perm;
+    g.pivots = new float[N];
+    g.rows = new float**[nb];
+    g.ids = new int*[nb];
+    for(int k = 0; k < nb; k++){
+        g.rows[k] = new float*[N];
+        g.ids[k] = new int[N];
+    }
+    for(int i = 0; i < N; i++){
+        g.rows[0][i] = &matrix[(size_t)i * N];
+        g.ids[0][i] = i;
+    }
+
+    // Panel k waits for the tile of panel k - 1 holding its columns,
+    // and tile c of panel k waits for panel k and tile c of panel k - 1
+    g.panel_deps = new std::atomic<int>[nb];
+    g.update_deps = new std::atomic<int>[nb * nt];
+    g.total = 0;
+    for(int k = 0; k < nb; k++){
+        int k1 = min((k + 1) * block_size, N);
+        g.panel_deps[k].store(k > 0 ? 1 : 0);
+        g.total++;
+        for(int c = k1 / tile_cols; (k1 < N) && (c < nt); c++){
+            g.update_deps[k * nt + c].store(k > 0 ? 2 : 1);
+            g.total++;
+        }
+    }
+    g.finished.store(0);
+
+    // One deque per worker, the first panel starts on worker 0
+    g.num_threads = num_threads;
+    g.deques = ge_aligned_new<WorkerDeque>(num_threads);
+    for(int i = 0; i < num_threads; i++){
+        pthread_mutex_init(&g.deques[i].mtx, NULL);
+    }
+    g.deques[0].tasks.push_back({PANEL, 0, 0});
+    g.clear_lu = !keep_lu;
+    g.counter = num_threads;
+    pthread_mutex_init(&g.mtx, NULL);
+    pthread_cond_init(&g.cond, NULL);
+
+    // Create array of thread objects we will launch
+    pthread_t *threads = new pthread_t[num_threads];
+    Args *thread_args = new Args[num_threads];
+
+    // Launch threads
+    for(int i = 0; i < num_threads; i++){
+        thread_args[i].tid = i;
+        thread_args[i].graph = &g;
+        start_thread(&threads[i], ge_worker, (void*)&thread_args[i]);
+    }
+
+    for(int i = 0; i < num_threads; i++){
+        pthread_join(threads[i], NULL);
+    }
+
+    // Free heap-allocated memory
+    for(int k = 0; k < nb; k++){
+        delete[] g.rows[k];
+        delete[] g.ids[k];
+    }
+    for(int i = 0; i < num_threads; i++){
+        pthread_mutex_destroy(&g.deques[i].mtx);
+    }
+    delete[] g.rows;
+    delete[] g.ids;
+    delete[] g.pivots;
+    delete[] g.panel_deps;
+    delete[] g.update_deps;
+    ge_aligned_delete(g.deques, num_threads);
+    pthread_mutex_destroy(&g.mtx);
+    pthread_cond_destroy(&g.cond);
+    delete[] threads;
+    delete[] thread_args;
+
+    // Cast timers as double to return
+    duration<double> elapsed = duration_cast<duration<double>>(g.end -
+            g.start);
+    return elapsed.count();
+}